@@ -2,6 +2,7 @@
 Copyright (c) 2005--2007, 2010 by Ben Klemens.  Licensed under the modified GNU GPL v2; see COPYING and COPYING2.  */
 
 #include "apop_internal.h"
+#include "vtables.h"
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_randist.h>
 #include <regex.h>
@@ -15,6 +16,20 @@ static void apop_tack_on(char **in, char *addme){
     strcpy(*in+inlen, addme);
 }
 
+//FNV-1a. Declared in internal.h.
+unsigned long long apop_hash_bytes(unsigned long long h, void const *bytes, size_t len){
+    for (size_t i=0; i< len; i++)
+        h = (h ^ ((unsigned char const*)bytes)[i]) * 1099511628211ULL;
+    return h;
+}
+
+//Values that compare equal hash alike: all NaNs get the same bits, as do 0 and -0.
+unsigned long long apop_hash_double(unsigned long long h, double x){
+    if (gsl_isnan(x)) x = GSL_NAN;
+    else if (x == 0) x = 0;
+    return apop_hash_bytes(h, &x, sizeof(double));
+}
+
 typedef int (*apop_fn_riip)(apop_data*, int, int, void*);
 
 /** Join together a list or array of strings, with optional separators between the strings.
@@ -300,6 +315,199 @@ APOP_VAR_ENDHEAD
 	return pctiles;
 }
 
+/* The quantile sketch is a merging t-digest (Dunning and Ertl, "Computing extremely
+   accurate quantiles using t-digests", 2019). Centroids are (mean, weight) pairs, kept
+   in order in one array, with new points appended after them as an unsorted buffer. When
+   the buffer fills (or before any query), the centroids and buffer are sorted together
+   and adjacent items are merged so long as the merged centroid spans no more than one
+   unit of the scale function k(q) = compression/(2 pi) asin(2q-1). That function is
+   steep near q=0 and q=1, so centroids in the tails stay small, and the tails are
+   accurate. Merging two sketches is just adding one's centroids to the other's buffer. */
+static double sketch_k(apop_quantile_sketch const *s, double q){
+    return s->compression/(2*M_PI) * asin(2*GSL_MIN(GSL_MAX(q, 0), 1) - 1);
+}
+
+static int compare_centroids(const void *a, const void *b){
+    double const *ca = a, *cb = b;
+    return (*ca > *cb) - (*ca < *cb);
+}
+
+static void sketch_compress(apop_quantile_sketch *s){
+    if (!s->buffer_ct) return;
+    size_t n = s->centroid_ct + s->buffer_ct, out = 0;
+    double *c = s->centroids;
+    qsort(c, n, 2*sizeof(double), compare_centroids);
+    long double so_far = 0;
+    double kprior = sketch_k(s, 0);
+    for (size_t i=1; i< n; i++){
+        double w = c[2*i+1], outw = c[2*out+1];
+        if (sketch_k(s, (so_far + outw + w)/s->total_weight) - kprior <= 1){
+            c[2*out+1] = outw + w;
+            c[2*out]  += (c[2*i] - c[2*out]) * w/(outw + w);
+        } else {
+            so_far += outw;
+            kprior = sketch_k(s, so_far/s->total_weight);
+            out++;
+            c[2*out] = c[2*i];
+            c[2*out+1] = w;
+        }
+    }
+    s->centroid_ct = out+1;
+    s->buffer_ct = 0;
+}
+
+/** Allocate a sketch of a distribution, from which you can find approximate quantiles
+of a data set without holding the data set in memory. Add data a point or a vector at
+a time, via \ref apop_quantile_sketch_add and \ref apop_quantile_sketch_add_vector; combine
+sketches made from different batches of data (perhaps in different threads) via \ref
+apop_quantile_sketch_merge; and query via \ref apop_quantile_sketch_quantile or \ref
+apop_quantile_sketch_percentiles.
+
+The sketch is a t-digest, whose size depends on the compression, not the amount of data
+added. The error is smallest in the tails: with the default compression, the quantiles
+are typically within a few tenths of a percentile (in rank) of the exact value in the middle
+of the distribution, and closer in the tails. The min and max are exact.
+
+\code
+apop_quantile_sketch *s = apop_quantile_sketch_alloc();
+while ((batch = get_next_batch()))
+    apop_quantile_sketch_add_vector(s, batch);
+double *pctiles = apop_quantile_sketch_percentiles(s);
+printf("median: %g; 95th percentile: %g\n", pctiles[50], pctiles[95]);
+apop_quantile_sketch_free(s);
+\endcode
+
+In the database, <tt>select approx_percentile(x, 95), approx_median(x) from tab</tt> builds a sketch
+of \c x for each group; see \ref db_moments.
+
+\param compression Larger values give more centroids and more accuracy. (Default: 200)
+\return A new, empty sketch. Free it with \ref apop_quantile_sketch_free.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_quantile_sketch * apop_quantile_sketch_alloc(double compression){
+    double apop_varad_var(compression, 200);
+    Apop_stopif(!(compression >= 10), compression=10, 1, "Compression must be at least 10; using 10.");
+APOP_VAR_ENDHEAD
+    apop_quantile_sketch *out = malloc(sizeof(apop_quantile_sketch));
+    size_t space = 6*compression + 10; //about pi/2 * compression centroids, plus the buffer.
+    *out = (apop_quantile_sketch){.compression=compression, .space=space,
+                .centroids=malloc(2*sizeof(double)*space), .min=GSL_NAN, .max=GSL_NAN};
+    return out;
+}
+
+/** Free a sketch allocated via \ref apop_quantile_sketch_alloc. */
+void apop_quantile_sketch_free(apop_quantile_sketch *s){
+    if (!s) return;
+    free(s->centroids);
+    free(s);
+}
+
+/** Add one data point to a quantile sketch.
+
+\param s The sketch, from \ref apop_quantile_sketch_alloc. (No default, must not be \c NULL.)
+\param value The data point. NaNs are ignored.
+\param weight The weight of the point; a weight of three is like adding the point three
+times. Points with nonpositive weight are ignored. (Default: 1)
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD void apop_quantile_sketch_add(apop_quantile_sketch *s, double value, double weight){
+    apop_quantile_sketch *apop_varad_var(s, NULL);
+    Apop_stopif(!s, return, 0, "You gave me a NULL sketch.");
+    double apop_varad_var(value, GSL_NAN);
+    double apop_varad_var(weight, 1);
+APOP_VAR_ENDHEAD
+    if (gsl_isnan(value) || !(weight > 0)) return;
+    if (s->centroid_ct + s->buffer_ct == s->space){
+        sketch_compress(s);
+        if (s->centroid_ct + s->buffer_ct > s->space/2){
+            s->space *= 2;
+            s->centroids = realloc(s->centroids, 2*sizeof(double)*s->space);
+        }
+    }
+    size_t i = s->centroid_ct + s->buffer_ct++;
+    s->centroids[2*i] = value;
+    s->centroids[2*i+1] = weight;
+    s->total_weight += weight;
+    if (!(value >= s->min)) s->min = value; //also true if min is NaN, i.e., unset.
+    if (!(value <= s->max)) s->max = value;
+}
+
+/** Add every element of a vector to a quantile sketch.
+
+\param s The sketch, from \ref apop_quantile_sketch_alloc.
+\param v The data. NaNs are ignored.
+\param weights If not \c NULL, a vector of weights the same size as \c v.
+*/
+void apop_quantile_sketch_add_vector(apop_quantile_sketch *s, gsl_vector const *v, gsl_vector const *weights){
+    Apop_stopif(!s, return, 0, "You gave me a NULL sketch.");
+    if (!v) return;
+    Apop_stopif(weights && weights->size != v->size, return, 0, "The data vector has size %zu "
+            "but the weights vector has size %zu. Not adding anything.", v->size, weights->size);
+    for (size_t i=0; i< v->size; i++)
+        apop_quantile_sketch_add(s, gsl_vector_get(v, i), weights ? gsl_vector_get(weights, i) : 1);
+}
+
+/** Add the data summarized by one sketch to another. The result is close to the sketch
+you would have gotten by adding all of the data to one sketch.
+
+\param into The sketch to be added to.
+\param from The sketch whose data will be added to \c into. It is not modified.
+*/
+void apop_quantile_sketch_merge(apop_quantile_sketch *into, apop_quantile_sketch const *from){
+    Apop_stopif(!into, return, 0, "You gave me a NULL sketch to merge into.");
+    if (!from || !from->total_weight) return;
+    double min = from->min, max = from->max;
+    for (size_t i=0; i< from->centroid_ct + from->buffer_ct; i++)
+        apop_quantile_sketch_add(into, from->centroids[2*i], from->centroids[2*i+1]);
+    if (!(min >= into->min)) into->min = min;
+    if (!(max <= into->max)) into->max = max;
+}
+
+/** Find an approximate quantile of the data added to a sketch so far. The sketch can
+still be added to afterward.
+
+\param s The sketch.
+\param q The quantile, between zero and one: 0.5 is the median, 0.95 the 95th percentile.
+\return The approximate quantile, interpolated between the sketch's centroids, or NaN if
+no data has been added.
+*/
+double apop_quantile_sketch_quantile(apop_quantile_sketch *s, double q){
+    Apop_stopif(!s, return GSL_NAN, 0, "You gave me a NULL sketch.");
+    sketch_compress(s);
+    if (!s->centroid_ct) return GSL_NAN;
+    if (q <= 0) return s->min;
+    if (q >= 1) return s->max;
+    double *c = s->centroids, index = q * s->total_weight;
+    size_t n = s->centroid_ct;
+    //The mass of each centroid is centered on its mean. Below the first center and above
+    //the last, interpolate to the min and max.
+    double center = c[1]/2;
+    if (index < center) return s->min + (c[0] - s->min) * index/center;
+    for (size_t i=0; i+1< n; i++){
+        double next = center + (c[2*i+1] + c[2*i+3])/2;
+        if (index < next) return c[2*i] + (c[2*i+2] - c[2*i]) * (index - center)/(next - center);
+        center = next;
+    }
+    double last = c[2*n-2], lastw = c[2*n-1];
+    return GSL_MIN(s->max, last + (s->max - last) * (index - center)/(lastw/2));
+}
+
+/** Returns an array of size 101, where \c returned_vector[95] gives the approximate 95th
+percentile of the data added to the sketch so far, for example. \c Returned_vector[100] is
+the exact maximum value, and \c returned_vector[0] is the exact min. This is the same
+layout as \ref apop_vector_percentiles, which finds the exact percentiles of data that
+fits in memory.
+
+\param s The sketch.
+\li You may eventually want to \c free() the array returned by this function.
+*/
+double * apop_quantile_sketch_percentiles(apop_quantile_sketch *s){
+    Apop_stopif(!s, return NULL, 0, "You gave me a NULL sketch.");
+    double *pctiles = malloc(sizeof(double) * 101);
+    for (int i=0; i< 101; i++) pctiles[i] = apop_quantile_sketch_quantile(s, i/100.);
+    return pctiles;
+}
+
 /** \} */
 
 static int count_parens(const char *string){
@@ -364,7 +572,7 @@ APOP_VAR_ENDHEAD
     regex_t re;
     int matchcount=count_parens(regex);
     int found, found_ct=0;
-    regmatch_t result[matchcount];
+    regmatch_t result[matchcount+1];
     int compiled_ok = !regcomp(&re, regex, REG_EXTENDED 
                                             + (use_case=='y' ? 0 : REG_ICASE)
                                             + (substrings ? 0 : REG_NOSUB) );
@@ -451,6 +659,10 @@ apop_model *apop_beta_from_mean_var(double m, double v){
 
 \li Prints a warning if you send in a non-<tt>NULL apop_data</tt> set, but its \c matrix element is \c NULL, when <tt>apop_opts.verbose>=1</tt>.
 
+\li If the model has a routine for making many draws at once (registered in the \c
+apop_model_draws vtable; see vtables.h), I use that. The \ref apop_pmf and \ref
+apop_multivariate_normal each have one that does its setup once and then fills the matrix.
+
 \li See also \ref apop_draw, which makes a single draw.
  */
 
@@ -473,7 +685,16 @@ APOP_VAR_HEAD apop_data *apop_model_draws(apop_model *model, int count, gsl_rng
         spare_rng = apop_rng_alloc(++apop_opts.rng_seed);
     if (!rng)  rng = spare_rng;
 APOP_VAR_ENDHEAD
+    static int setup=0; if (!(setup++)){
+        apop_model_draws_insert(apop_pmf_draws, apop_pmf);
+        apop_model_draws_insert(apop_mvn_draws, apop_multivariate_normal);
+    }
     apop_data *out = draws ? draws : apop_data_alloc(count, model->dsize);
+    apop_model_draws_type batch = apop_model_draws_get(*model);
+    if (batch){
+        batch(out, rng, model);
+        return out;
+    }
     for (int i=0; i< count; i++){
         Apop_data_row(out, i, onerow);
         apop_draw(onerow->matrix->data, rng, model);
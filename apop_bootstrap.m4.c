@@ -23,6 +23,45 @@ gsl_rng *apop_rng_alloc(int seed){
     return setme;
 }
 
+static int thread_split(int threadno, int totalct, int threadct){
+    return (threadno == threadct) ? totalct : threadno*(totalct/threadct);
+}
+
+typedef struct {
+    apop_data *in, *subset, *boots;
+    apop_model *e;
+    gsl_vector *overall_params;
+    int n, lo, hi;
+} jack_pass;
+
+/* Each thread gets its own copy of the shortened data set. Subset i is the original
+   with row i+1 removed, which the serial loop builds by copying rows 0...i back in one
+   at a time; a thread starting at i=lo replays those copies first, so every thread
+   estimates exactly the subsets the serial loop would. */
+static void *jack_loop(void *t){
+    jack_pass *jp = t;
+    gsl_vector *pseudoval = gsl_vector_alloc(jp->overall_params->size);
+    for (int i = -1; i< jp->hi; i++){
+        //Get a view of row i, and copy it to position i-1 in the short matrix.
+        if (i >= 0){
+            Apop_data_row(jp->in, i, onerow);
+            Apop_data_row(jp->subset, i, subsetrow);
+            apop_data_memcpy(subsetrow, onerow);
+        }
+        if (i < jp->lo) continue;
+        apop_model *est = apop_estimate(jp->subset, *jp->e);
+        gsl_vector *estp = apop_data_pack(est->parameters);
+        gsl_vector_memcpy(pseudoval, jp->overall_params);// *n above.
+        gsl_vector_scale(estp, jp->n-1);
+        gsl_vector_sub(pseudoval, estp);
+        gsl_matrix_set_row(jp->boots->matrix, i+1, pseudoval);
+        apop_model_free(est);
+        gsl_vector_free(estp);
+    }
+    gsl_vector_free(pseudoval);
+    return NULL;
+}
+
 /** Give me a data set and a model, and I'll give you the jackknifed covariance matrix of the model parameters.
 
 The basic algorithm for the jackknife (with many details glossed over): create a sequence of data
@@ -38,50 +77,57 @@ apop_data_show(apop_jackknife_cov(your_data, your_model));
  
 \param in	    The data set. An \ref apop_data set where each row is a single data point.
 \param model    An \ref apop_model, that will be used internally by \ref apop_estimate.
+\param threaded If \c 'y' and <tt>apop_opts.thread_count</tt> is greater than one, split the
+leave-one-out estimations among that many threads, each with its own copy of the data and the
+model. The model's \c estimate routine then has to be thread-safe. The output is the same as
+with one thread. (Default: \c 'n')
             
 \exception out->error=='n'   \c NULL input data.
 \return         An \c apop_data set whose matrix element is the estimated covariance matrix of the parameters.
+\li This function uses the \ref designated syntax for inputs.
 \see apop_bootstrap_cov
  */
-apop_data * apop_jackknife_cov(apop_data *in, apop_model model){
+APOP_VAR_HEAD apop_data * apop_jackknife_cov(apop_data *in, apop_model model, char threaded){
+    apop_data * apop_varad_var(in, NULL);
+    apop_model model = varad_in.model;
+    char apop_varad_var(threaded, 'n');
+APOP_VAR_ENDHEAD
     Apop_stopif(!in, apop_return_data_error(n), 0, "The data input can't be NULL.");
     Get_vmsizes(in); //msize1, msize2, vsize
     apop_model *e = apop_model_copy(model);
-    int i, n = GSL_MAX(msize1, GSL_MAX(vsize, in->textsize[0]));
+    int n = GSL_MAX(msize1, GSL_MAX(vsize, in->textsize[0]));
     apop_model *overall_est = e->parameters ? e : apop_estimate(in, *e);//if not estimated, do so
     gsl_vector *overall_params = apop_data_pack(overall_est->parameters);
     gsl_vector_scale(overall_params, n); //do it just once.
-    gsl_vector *pseudoval = gsl_vector_alloc(overall_params->size);
+
+    int threadct = threaded=='y' ? GSL_MAX(1, GSL_MIN(n, apop_opts.thread_count)) : 1;
+    pthread_t thread_id[threadct];
+    jack_pass jp[threadct];
+    apop_data *array_of_boots = apop_data_alloc(n, overall_params->size);
 
     //Copy the original, minus the first row.
     Apop_data_rows(in, 1, n-1, allbutfirst);
-    apop_data *subset = apop_data_copy(allbutfirst);
+    for (int i=0; i< threadct; i++)
+        jp[i] = (jack_pass){.in=in, .boots=array_of_boots, .overall_params=overall_params, .n=n,
+                    .lo = thread_split(i, n, threadct) - 1, .hi = thread_split(i+1, n, threadct) - 1,
+                    .subset = apop_data_copy(allbutfirst), .e = threadct==1 ? e : apop_model_copy(*e)};
     apop_name *tmpnames = in->names; 
     in->names = NULL;  //save on some copying below.
 
-    apop_data *array_of_boots = apop_data_alloc(n, overall_params->size);
-
-    for(i = -1; i< n-1; i++){
-        //Get a view of row i, and copy it to position i-1 in the short matrix.
-        if (i >= 0){
-            Apop_data_row(in, i, onerow);
-            Apop_data_row(subset, i, subsetrow);
-            apop_data_memcpy(subsetrow, onerow);
-        }
-        apop_model *est = apop_estimate(subset, *e);
-        gsl_vector *estp = apop_data_pack(est->parameters);
-        gsl_vector_memcpy(pseudoval, overall_params);// *n above.
-        gsl_vector_scale(estp, n-1);
-        gsl_vector_sub(pseudoval, estp);
-        gsl_matrix_set_row(array_of_boots->matrix, i+1, pseudoval);
-        apop_model_free(est);
-        gsl_vector_free(estp);
+    if (threadct==1) jack_loop(jp);
+    else {
+        for (int i=0; i< threadct; i++)
+            pthread_create(&thread_id[i], NULL, jack_loop, jp+i);
+        for (int i=0; i< threadct; i++)
+            pthread_join(thread_id[i], NULL);
     }
     in->names = tmpnames;
     apop_data *out = apop_data_covariance(array_of_boots);
     gsl_matrix_scale(out->matrix, 1./(n-1.));
-    apop_data_free(subset);
-    gsl_vector_free(pseudoval);
+    for (int i=0; i< threadct; i++){
+        apop_data_free(jp[i].subset);
+        if (jp[i].e != e) apop_model_free(jp[i].e);
+    }
     apop_data_free(array_of_boots);
     if (e!=overall_est)
         apop_model_free(overall_est);
@@ -90,6 +136,45 @@ apop_data * apop_jackknife_cov(apop_data *in, apop_model model){
     return out;
 }
 
+typedef struct {
+    apop_data *data, *subset;
+    apop_model *e;
+    gsl_rng *rng;
+    size_t lo, hi, done, nan_draws, height;
+    char ignore_nans;
+    gsl_vector **boots;
+    apop_name *names;
+} boot_pass;
+
+/* Draws hi-lo bootstrap samples into boots[lo...hi-1]. Each thread gets its own
+   share of the NaN allowance, so the total allowed is still the iteration count. */
+static void *boot_loop(void *t){
+    boot_pass *bp = t;
+    size_t i, ct = bp->hi - bp->lo;
+	for (i=0; i<ct && bp->nan_draws < ct; i++){
+		for (size_t j=0; j< bp->height; j++){       //create the data set
+			size_t row	= gsl_rng_uniform_int(bp->rng, bp->height);
+			Apop_data_row(bp->data, row, random_data_row);
+			Apop_data_row(bp->subset, j, subset_row_j);
+            apop_data_memcpy(subset_row_j, random_data_row);
+		}
+		//get the parameter estimates.
+		apop_model *est = apop_estimate(bp->subset, *bp->e);
+        gsl_vector *estp = apop_data_pack(est->parameters);
+        if (!gsl_isnan(apop_sum(estp))){
+            if (!bp->names) bp->names = apop_name_copy(est->parameters->names);
+            bp->boots[bp->lo + i] = estp;
+        } else if (bp->ignore_nans=='y'){
+            i--; 
+            bp->nan_draws++;
+            gsl_vector_free(estp);
+        } else bp->boots[bp->lo + i] = estp;
+        apop_model_free(est);
+	}
+    bp->done = i;
+    return NULL;
+}
+
 /** Give me a data set and a model, and I'll give you the bootstrapped covariance matrix of the parameter estimates.
 
 \param data	    The data set. An \c apop_data set where each row is a single data point. (No default)
@@ -108,14 +193,21 @@ Apop_row(boot_stats, 27, row_27)
 printf("The statistics calculated on the 28th iteration:\n");
 apop_vector_print(row_27);
 \endcode
+\param threaded If \c 'y' and <tt>apop_opts.thread_count</tt> is greater than one, split the
+iterations among that many threads; see below. (Default: \c 'n')
 \param ignore_nans If \c 'y' and any of the elements in the estimation return \c NaN, then I will throw out that draw and try again. If \c 'n', then I will write that set of statistics to the list, \c NaN and all. I keep count of throw-aways; if there are more than \c iterations elements thrown out, then I throw an error and return with estimates using data I have so far. That is, I assume that \c NaNs are rare edge cases; if they are as common as good data, you might want to rethink how you are using the bootstrap mechanism. (Default: 'n')
 \return         An \c apop_data set whose matrix element is the estimated covariance matrix of the parameters.
 \exception out->error=='n'   \c NULL input data.
 \exception out->error=='N'   \c too many Nans.
 \li This function uses the \ref designated syntax for inputs.
+\li If <tt>.threaded='y'</tt> and <tt>apop_opts.thread_count</tt> is greater than one, the
+iterations are split among that many threads, each with its own copy of the data and the model. The model's \c estimate routine
+has to be thread-safe. Each thread draws from its own RNG, seeded in turn from \c rng, so
+results are reproducible for a given seed and thread count, but change if the thread count
+changes. With one thread, \c rng is used directly.
 \see apop_jackknife_cov
  */
-APOP_VAR_HEAD apop_data * apop_bootstrap_cov(apop_data * data, apop_model model, gsl_rng *rng, int iterations, char keep_boots, char ignore_nans) {
+APOP_VAR_HEAD apop_data * apop_bootstrap_cov(apop_data * data, apop_model model, gsl_rng *rng, int iterations, char keep_boots, char ignore_nans, char threaded) {
     static gsl_rng *spare = NULL;
     apop_data * apop_varad_var(data, NULL);
     apop_model model = varad_in.model;
@@ -127,53 +219,64 @@ APOP_VAR_HEAD apop_data * apop_bootstrap_cov(apop_data * data, apop_model model,
     if (!rng)  rng = spare;
     char apop_varad_var(keep_boots, 'n');
     char apop_varad_var(ignore_nans, 'n');
+    char apop_varad_var(threaded, 'n');
 APOP_VAR_ENDHEAD
     Get_vmsizes(data); //vsize, msize1, msize2
     apop_model *e       = apop_model_copy(model);
-    apop_data  *subset  = apop_data_copy(data);
     apop_data  *array_of_boots = NULL,
                *summary;
     //prevent and infinite regression of covariance calculation.
     Apop_model_add_group(e, apop_parts_wanted); //default wants for nothing.
-    size_t	   i, nan_draws=0;
+    int threadct = threaded=='y' ? GSL_MAX(1, GSL_MIN(iterations, apop_opts.thread_count)) : 1;
+    pthread_t thread_id[threadct];
+    boot_pass bp[threadct];
+    gsl_vector **boots = calloc(iterations, sizeof(gsl_vector*));
+    size_t height = GSL_MAX(msize1, GSL_MAX(vsize, data->textsize[0]));
+    for (int i=0; i< threadct; i++)
+        bp[i] = (boot_pass){.data=data, .height=height, .ignore_nans=ignore_nans, .boots=boots,
+                    .lo = thread_split(i, iterations, threadct), .hi = thread_split(i+1, iterations, threadct),
+                    .subset = apop_data_copy(data), .e = threadct==1 ? e : apop_model_copy(*e),
+                    .rng = threadct==1 ? rng : apop_rng_alloc(gsl_rng_get(rng))};
     apop_name *tmpnames = data->names; //save on some copying below.
     data->names = NULL;  
 
-    int height = GSL_MAX(msize1, GSL_MAX(vsize, data->textsize[0]));
-	for (i=0; i<iterations && nan_draws < iterations; i++){
-		for (size_t j=0; j< height; j++){       //create the data set
-			size_t row	= gsl_rng_uniform_int(rng, height);
-			Apop_data_row(data, row, random_data_row);
-			Apop_data_row(subset, j, subset_row_j);
-            apop_data_memcpy(subset_row_j, random_data_row);
-		}
-		//get the parameter estimates.
-		apop_model *est = apop_estimate(subset, *e);
-        gsl_vector *estp = apop_data_pack(est->parameters);
-        if (!gsl_isnan(apop_sum(estp))){
-            if (i==0){
-                array_of_boots	      = apop_data_alloc(iterations, estp->size);
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'v');
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'c');
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'r');
-            }
-            gsl_matrix_set_row(array_of_boots->matrix, i, estp);
-        } else if (ignore_nans=='y'){
-            i--; 
-            nan_draws++;
-        }
-        apop_model_free(est);
-        gsl_vector_free(estp);
-	}
+    if (threadct==1) boot_loop(bp);
+    else {
+        for (int i=0; i< threadct; i++)
+            pthread_create(&thread_id[i], NULL, boot_loop, bp+i);
+        for (int i=0; i< threadct; i++)
+            pthread_join(thread_id[i], NULL);
+    }
     data->names = tmpnames;
-    apop_data_free(subset);
+
+    //Gather the draws, in thread order.
+    size_t i = 0;
+    int out_of_draws = 0, names_set = 0;
+    for (int t=0; t< threadct; t++) i += bp[t].done;
+    for (int t=0, row=0; t< threadct; t++){
+        out_of_draws += (bp[t].nan_draws == bp[t].hi - bp[t].lo);
+        for (size_t j=bp[t].lo; j< bp[t].lo + bp[t].done; j++){
+            if (!array_of_boots) array_of_boots = apop_data_alloc(i, boots[j]->size);
+            gsl_matrix_set_row(array_of_boots->matrix, row++, boots[j]);
+            gsl_vector_free(boots[j]);
+        }
+        if (bp[t].names && array_of_boots && !names_set++){
+            apop_name_stack(array_of_boots->names, bp[t].names, 'c', 'v');
+            apop_name_stack(array_of_boots->names, bp[t].names, 'c', 'c');
+            apop_name_stack(array_of_boots->names, bp[t].names, 'c', 'r');
+        }
+        if (bp[t].names) apop_name_free(bp[t].names);
+        apop_data_free(bp[t].subset);
+        if (bp[t].e != e) apop_model_free(bp[t].e);
+        if (bp[t].rng != rng) gsl_rng_free(bp[t].rng);
+    }
+    free(boots);
     apop_model_free(e);
     int set_error=0;
-    Apop_stopif(i == 0 && nan_draws == iterations, apop_return_data_error(N),
+    Apop_stopif(i == 0, apop_return_data_error(N),
                 1, "I ran into %i NaNs and no not-NaN estimations, and so stopped. "
                        , iterations);
-    Apop_stopif(nan_draws == iterations,  set_error++;
-            apop_matrix_realloc(array_of_boots->matrix, i, array_of_boots->matrix->size2),
+    Apop_stopif(out_of_draws,  set_error++,
                 1, "I ran into %i NaNs, and so stopped. Returning results based "
                        "on %zu bootstrap iterations.", iterations, i);
 	summary	= apop_data_covariance(array_of_boots);
@@ -5,6 +5,10 @@
 #include <regex.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*extend a string. this prevents a minor leak you'd get if you did
  asprintf(&q, "%s is a teapot.", q);
@@ -514,32 +518,43 @@ static char get_next(char *buffer, size_t *ptr, FILE *infile){
     return buffer[(*ptr)++];
 }
 
-static apop_char_info parse_next_char(char *buffer, size_t *ptr, FILE *f, char const *delimiters){
+//Classify every possible character once per file, rather than checking each character
+//read against the list of delimiters.
+static void set_char_types(char *char_types, char const *delimiters){
+    for (int i=0; i< 256; i++){
+        char c = i;
+        int is_delimiter = !!strchr(delimiters, c);
+        char_types[i] = (c==' '||c=='\t' || c==0)? (is_delimiter ? 'W'  : 'w')
+                        :is_delimiter    ? 'd'
+                        :(c == '\n')     ? 'n'
+                        :(c == '"')      ? '"'
+                        :(c == '\'')     ? '\''
+                        :(c == '\\')     ? '\\'
+                        :(c == EOF)      ? 'E'
+                        :(c == '#')      ? '#'
+                                         : 'r';
+    }
+}
+
+static apop_char_info parse_next_char(char *buffer, size_t *ptr, FILE *f, char const *char_types){
     char c = get_next(buffer, ptr, f);
-    int is_delimiter = !!strchr(delimiters, c);
-    return (apop_char_info){.c=c, 
-            .type = (c==' '||c=='\t' || c==0)? (is_delimiter ? 'W'  : 'w')
-                    :is_delimiter    ? 'd'
-                    :(c == '\n')     ? 'n'
-                    :(c == '"')      ? '"'
-                    :(c == '\'')     ? '\''
-                    :(c == '\\')     ? '\\'
-                    :(c == EOF)      ? 'E'
-                    :(c == '#')      ? '#'
-                                     : 'r'
-            };
+    return (apop_char_info){.c=c, .type=char_types[(unsigned char)c]};
 }
 
 //fills fn with a list of strings.
 //returns the count of elements. Negate the count if we're at EOF.
 //fn must already be allocated via apop_data_alloc() [no args].
-static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_data *fn, int const *field_ends, char const *delimiters){
+//If field_space isn't NULL, it is a list (reallocated here as needed) of the space
+//allocated for each string in fn, so the strings can be reused from line to line
+//instead of being reallocated for every field on every line.
+static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_data *fn, int const *field_ends,
+                                        char const *char_types, size_t **field_space){
     int ct=0, thisflen=0, inq=0, inqq=0, infield=0, mlen=5,
             lastwhite=0, lastnonwhite=0; 
     if (field_ends) return parse_a_fixed_line(infile, fn, field_ends);
     apop_char_info ci;
     do {
-        ci = parse_next_char(buffer, ptr, infile, delimiters);
+        ci = parse_next_char(buffer, ptr, infile, char_types);
         //comments are to end of line, so they're basically a newline.
         if (ci.type=='#' && !(inq||inqq)){
             for(char c='x'; (c!='\n' && c!=EOF); )
@@ -550,7 +565,7 @@ static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_d
         //The escape-type cases: \\ and '' and "".
         //If one applies, set the type to regular
         if (ci.type=='\\'){
-            ci=parse_next_char(buffer, ptr, infile, delimiters);
+            ci=parse_next_char(buffer, ptr, infile, char_types);
             if (ci.type!='E')
                 ci.type='r';
         }
@@ -567,10 +582,20 @@ static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_d
             if (ci.type=='w') continue; //eat leading spaces.
             if (ci.type=='r' || ci.type=='d'             //new field; if 'dnE', blank field. 
                    || (strchr("nE", ci.type) && ct>0)){  //Blank fields only at end of lines that already have data; else all-blank line to ignore.
-                if (++ct > fn->textsize[0]) apop_text_alloc(fn, ct, 1);//realloc text portion.
-                *fn->text[ct-1] = realloc(*fn->text[ct-1], 5);
+                if (++ct > fn->textsize[0]){
+                    apop_text_alloc(fn, ct, 1);//realloc text portion.
+                    if (field_space){
+                        *field_space = realloc(*field_space, sizeof(size_t)*ct);
+                        (*field_space)[ct-1] = 0;
+                    }
+                }
+                mlen = field_space ? (*field_space)[ct-1] : 0;
+                if (mlen < 5){
+                    mlen = 5;
+                    *fn->text[ct-1] = realloc(*fn->text[ct-1], mlen);
+                    if (field_space) (*field_space)[ct-1] = mlen;
+                }
                 thisflen = 0;
-                mlen=5;
                 infield=1;
             } 
         } 
@@ -586,6 +611,7 @@ static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_d
                 if (thisflen+2 > mlen){
                     mlen *=2; //length of allocated memory
                     *fn->text[ct-1] = realloc(*fn->text[ct-1], mlen);
+                    if (field_space) (*field_space)[ct-1] = mlen;
                 }
                 fn->text[ct-1][0][thisflen-1] = ci.c;
                 if (ci.type!='w')
@@ -598,13 +624,14 @@ static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_d
 
 //On return, fn has copies of the field names, and add_this_line has the first data line.
 static void get_field_names(int has_col_names, char **field_names, FILE *infile, char *buffer, size_t *ptr,
-                                apop_data *add_this_line, apop_data *fn, int const *field_ends, char const *delimiters){
+                                apop_data *add_this_line, apop_data *fn, int const *field_ends, char const *char_types,
+                                size_t **field_space){
     if (has_col_names && field_names == NULL){
-        while (fn->textsize[0] ==0) parse_a_line(infile, buffer, ptr, fn, field_ends, delimiters);
-        while (add_this_line->textsize[0] ==0) parse_a_line(infile, buffer, ptr, add_this_line, field_ends, delimiters);
+        while (fn->textsize[0] ==0) parse_a_line(infile, buffer, ptr, fn, field_ends, char_types, NULL);
+        while (add_this_line->textsize[0] ==0) parse_a_line(infile, buffer, ptr, add_this_line, field_ends, char_types, field_space);
     } else{
         while (add_this_line->textsize[0] ==0) 
-            parse_a_line(infile, buffer, ptr, add_this_line, field_ends, delimiters);
+            parse_a_line(infile, buffer, ptr, add_this_line, field_ends, char_types, field_space);
         fn	= apop_text_alloc(fn, add_this_line->textsize[0], 1);
         for (int i=0; i< fn->textsize[0]; i++)
             if (field_names) apop_text_add(fn, i, 0, field_names[i]);
@@ -612,6 +639,282 @@ static void get_field_names(int has_col_names, char **field_names, FILE *infile,
     }
 }
 
+//Complain if a line has more elements than the matrix has columns.
+static int line_too_long(int ct, int hasrows, int row, gsl_matrix const *m){
+    if (hasrows)
+        Apop_stopif(ct-1 > m->size2, return 1, 1,
+                 "row %i (not counting rownames) has %i elements (not counting the rowname), "
+                 "but I thought this was a data set with %zu elements per row. "
+                 "Stopping the file read; returning what I have so far.", row, ct-1, m->size2)
+    else Apop_stopif(ct > m->size2, return 1, 1,
+                 "row %i has %i elements, "
+                 "but I thought this was a data set with %zu elements per row. "
+                 "Stopping the file read; returning what I have so far. Set has_row_names?", row, ct, m->size2);
+    return 0;
+}
+
+//Convert the fields of a parsed line to numbers in the given row (counting from one) of m.
+static void line_to_row(gsl_matrix *m, apop_data const *line, int ct, int row, int hasrows){
+    char *str;
+    for (int col=hasrows; col < ct; col++){
+        char *thisstr = *line->text[col];
+        if (strlen(thisstr)){
+            double val = strtod(thisstr, &str);
+            if (thisstr != str)
+                gsl_matrix_set(m, row-1, col-hasrows, val);
+            else {
+                gsl_matrix_set(m, row-1, col-hasrows, GSL_NAN);
+                Apop_notify(1, "trouble converting data item %i on data line %i [%s]; writing NaN.", col, row, thisstr);
+            }
+        } else gsl_matrix_set(m, row-1, col-hasrows, GSL_NAN);
+    }
+}
+
+/* Threaded reading. With apop_opts.thread_count > 1, the file is mapped into memory
+   and a quick pass over it finds where the lines end, following the same quoting,
+   escaping, and comment rules as parse_a_line. Each thread then takes a run of whole
+   lines and parses it with the usual machinery, via a FILE opened on its slice
+   of the map, and the results are put together in file order. */
+
+typedef struct {
+    char *data;
+    size_t len;
+    int fd;
+} text_map_t;
+
+//Returns zero if the file is mapped. Else, read it the usual way: it may be stdin
+//or a pipe, or too small to be worth splitting.
+static int map_text_file(char const *text_file, text_map_t *m){
+    struct stat st;
+    if (!strcmp(text_file, "-")) return 1;
+    m->fd = open(text_file, O_RDONLY);
+    if (m->fd < 0) return 1;
+    if (fstat(m->fd, &st) || !S_ISREG(st.st_mode) || st.st_size < 2*bs
+          || (m->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, m->fd, 0)) == MAP_FAILED){
+        close(m->fd);
+        return 1;
+    }
+    m->len = st.st_size;
+    return 0;
+}
+
+static void unmap_text_file(text_map_t *m){
+    munmap(m->data, m->len);
+    close(m->fd);
+}
+
+/* Find the end of the line starting at data[i], as parse_a_line would read it. Sets
+   *has_fields if parse_a_line would find any fields on the line, and *eof if the line
+   ends the data, either at the end of the file or at an EOF character. */
+static size_t text_line_end(char const *data, size_t i, size_t len, char const *char_types,
+                                int *has_fields, int *eof){
+    int inq=0, inqq=0;
+    *has_fields = 0;
+    for ( ; i < len; i++){
+        char type = char_types[(unsigned char)data[i]];
+        if (type=='#' && !(inq||inqq)){
+            while (i < len && data[i]!='\n' && data[i]!=EOF) i++;
+            if (i < len) return i+1;
+            break;
+        }
+        if (type=='\\'){
+            if (++i == len) break;
+            type = char_types[(unsigned char)data[i]];
+            if (type!='E')
+                type='r';
+        }
+        if (((inq && type !='\'') ||(inqq && type !='"')) && type !='E')
+            type='r';
+        if (type=='\'') inq = !inq;
+        else if (type=='"') inqq = !inqq;
+        else if (type=='r' || type=='d') *has_fields = 1;
+        else if (type=='n') return i+1;
+        else if (type=='E') {*eof = 1; return i;}
+    }
+    *eof = 1;
+    return len;
+}
+
+typedef struct {
+    char const *data;
+    size_t len;
+    int lines, rows; //all lines, and lines with fields
+} text_chunk_t;
+
+/* Starting at *pos, cut the data into up to chunk_ct runs of whole lines, each at
+   least target bytes (except perhaps the last). Returns the count of chunks; *pos is
+   left at the end of the last chunk, and *eof is set if that is the end of the data. */
+static int split_text(char const *data, size_t *pos, size_t len, size_t target, int chunk_ct,
+                            text_chunk_t *chunks, char const *char_types, int *eof){
+    int ct = 0, has_fields;
+    while (ct < chunk_ct && *pos < len && !*eof){
+        text_chunk_t *c = chunks + ct++;
+        size_t start = *pos;
+        *c = (text_chunk_t){.data = data + start};
+        while (*pos - start < target && !*eof){
+            *pos = text_line_end(data, *pos, len, char_types, &has_fields, eof);
+            c->lines++;
+            c->rows += has_fields;
+        }
+        c->len = *pos - start;
+    }
+    return ct;
+}
+
+/* Find the end of the first line of data, skipping the header line if need be.
+   Returns zero if there is no such line or it ends the data. */
+static size_t first_data_line_end(char const *data, size_t len, int skip_header,
+                                    char const *char_types, size_t *line_start){
+    int found = 0, has_fields, eof = 0;
+    size_t pos = 0;
+    while (found < skip_header + 1 && !eof){
+        *line_start = pos;
+        pos = text_line_end(data, pos, len, char_types, &has_fields, &eof);
+        found += has_fields;
+    }
+    return (found < skip_header + 1 || eof) ? 0 : pos;
+}
+
+typedef struct {
+    text_chunk_t chunk;
+    char const *char_types;
+    int hasrows, first_row;
+    char error;
+    int bad_row, bad_ct; //the first line with too many elements, if any
+    apop_data *set;      //apop_text_to_data writes directly to the output set.
+    apop_data **lines;   //apop_text_to_db gets a list of parsed lines...
+    line_parse_t *L;
+    int *line_no;        //...with line numbers counting from the start of the chunk.
+    int line_ct;
+} text_threadpass;
+
+static void *chunk_to_data(void *in){
+    text_threadpass *tc = in;
+    char buffer[bs];
+    size_t ptr=bs, *field_space=NULL;
+    FILE *infile = fmemopen((void*)tc->chunk.data, tc->chunk.len, "r");
+    Apop_stopif(!infile, tc->error='a'; return NULL, 0, "Couldn't open a chunk of the file in memory.");
+    apop_data *add_this_line = apop_data_alloc();
+    line_parse_t L = { };
+    for (int row=tc->first_row; row < tc->first_row + tc->chunk.rows && !L.eof; ){
+        L = parse_a_line(infile, buffer, &ptr, add_this_line, NULL, tc->char_types, &field_space);
+        if (!L.ct) continue;
+        if (tc->hasrows) tc->set->names->row[row] = strdup(*add_this_line->text[0]);
+        row++;
+        if (L.ct - tc->hasrows > tc->set->matrix->size2){
+            tc->bad_row = row;
+            tc->bad_ct = L.ct;
+            break;
+        }
+        line_to_row(tc->set->matrix, add_this_line, L.ct, row, tc->hasrows);
+    }
+    apop_data_free(add_this_line);
+    free(field_space);
+    fclose(infile);
+    return NULL;
+}
+
+static void *chunk_to_lines(void *in){
+    text_threadpass *tc = in;
+    char buffer[bs];
+    size_t ptr=bs;
+    FILE *infile = fmemopen((void*)tc->chunk.data, tc->chunk.len, "r");
+    Apop_stopif(!infile, tc->error='a'; return NULL, 0, "Couldn't open a chunk of the file in memory.");
+    tc->lines = malloc(sizeof(apop_data*) * tc->chunk.rows);
+    tc->L = malloc(sizeof(line_parse_t) * tc->chunk.rows);
+    tc->line_no = malloc(sizeof(int) * tc->chunk.rows);
+    apop_data *this_line = NULL;
+    line_parse_t L = { };
+    for (int line=1; tc->line_ct < tc->chunk.rows && !L.eof; line++){
+        if (!this_line) this_line = apop_data_alloc();
+        L = parse_a_line(infile, buffer, &ptr, this_line, NULL, tc->char_types, NULL);
+        if (!L.ct) continue;
+        tc->lines[tc->line_ct] = this_line;
+        tc->L[tc->line_ct] = L;
+        tc->line_no[tc->line_ct++] = line;
+        this_line = NULL;
+    }
+    apop_data_free(this_line);
+    fclose(infile);
+    return NULL;
+}
+
+static void run_text_threads(text_threadpass *tp, int threadct, void *(*fn)(void *)){
+    pthread_t thread_id[threadct];
+    if (threadct==1) fn(tp);
+    else {
+        for (int i=0; i< threadct; i++)
+            pthread_create(&thread_id[i], NULL, fn, tp+i);
+        for (int i=0; i< threadct; i++)
+            pthread_join(thread_id[i], NULL);
+    }
+}
+
+//Returns NULL if the file can't be mapped, in which case read it serially.
+static apop_data *text_to_data_threaded(char const *text_file, int hasrows, int has_col_names, char const *char_types){
+    text_map_t m;
+    if (map_text_file(text_file, &m)) return NULL;
+    apop_data *set = NULL;
+    size_t first, pos = first_data_line_end(m.data, m.len, has_col_names=='y', char_types, &first);
+    FILE *infile = pos ? fmemopen(m.data, pos, "r") : NULL;
+    if (!infile) {
+        unmap_text_file(&m);
+        return NULL;
+    }
+
+    //Get the names and the width of the data from the top of the file.
+    char buffer[bs];
+    size_t ptr=bs;
+    apop_data *add_this_line = apop_data_alloc();
+    apop_data *field_names = apop_data_alloc();
+    line_parse_t L = { };
+    if (has_col_names=='y'){
+        get_field_names(1, NULL, infile, buffer, &ptr, add_this_line, field_names, NULL, char_types, NULL);
+        L.ct = *add_this_line->textsize;
+    } else while (!L.ct)
+        L = parse_a_line(infile, buffer, &ptr, add_this_line, NULL, char_types, NULL);
+    fclose(infile);
+
+    int threadct = GSL_MAX(1, GSL_MIN(apop_opts.thread_count, (m.len-first)/bs)), eof = 0;
+    text_chunk_t chunks[threadct];
+    pos = first;
+    threadct = split_text(m.data, &pos, m.len, (m.len-first)/threadct + 1, threadct, chunks, char_types, &eof);
+    int rows = 0;
+    for (int i=0; i< threadct; i++) rows += chunks[i].rows;
+
+    set = apop_data_alloc(rows, L.ct - hasrows);
+    if (has_col_names=='y')
+        for (int j=0; j< L.ct - hasrows; j++)
+            apop_name_add(set->names, *field_names->text[j], 'c');
+    if (hasrows){
+        set->names->row = calloc(rows, sizeof(char*));
+        set->names->rowct = rows;
+    }
+    text_threadpass tp[threadct];
+    for (int i=0, row=0; i< threadct; row += chunks[i++].rows)
+        tp[i] = (text_threadpass){.chunk=chunks[i], .char_types=char_types,
+                                  .hasrows=hasrows, .first_row=row, .set=set};
+    run_text_threads(tp, threadct, chunk_to_data);
+
+    for (int i=0; i< threadct; i++){
+        if (tp[i].error) set->error = tp[i].error;
+        if (tp[i].bad_row){
+            line_too_long(tp[i].bad_ct, hasrows, tp[i].bad_row, set->matrix);
+            set->error = 't';
+            if (hasrows){
+                for (int r=tp[i].bad_row; r < rows; r++) free(set->names->row[r]);
+                set->names->rowct = tp[i].bad_row;
+            }
+            set->matrix = apop_matrix_realloc(set->matrix, tp[i].bad_row, set->matrix->size2);
+            break;
+        }
+    }
+    apop_data_free(add_this_line);
+    apop_data_free(field_names);
+    unmap_text_file(&m);
+    return set;
+}
+
 /** Read a delimited text file into the matrix element of an \ref apop_data set.
 
   See \ref text_format.
@@ -627,6 +930,11 @@ static void get_field_names(int has_col_names, char **field_names, FILE *infile,
 
 <b>example:</b> See \ref apop_ols.
 
+\li If <tt>apop_opts.thread_count</tt> is greater than one and the input is a regular file
+(not \c stdin) with delimited fields, I map the file into memory, split it into runs of
+whole lines, and parse them in parallel. The output is the same as the single-threaded
+read, row for row.
+
 \li This function uses the \ref designated syntax for inputs.
 \ingroup conversions	*/
 APOP_VAR_HEAD apop_data * apop_text_to_data(char const*text_file, int has_row_names, int has_col_names, int const *field_ends, char const *delimiters){
@@ -640,11 +948,15 @@ APOP_VAR_HEAD apop_data * apop_text_to_data(char const*text_file, int has_row_na
 APOP_VAR_ENDHEAD
     apop_data *set = NULL;
     FILE *infile = NULL;
-    char *str;
     char buffer[bs];
-    size_t ptr=bs;
+    size_t ptr=bs, *field_space=NULL;
+    char char_types[256];
+    set_char_types(char_types, delimiters);
+    if (apop_opts.thread_count > 1 && !field_ends
+            && (set = text_to_data_threaded(text_file, has_row_names=='y', has_col_names, char_types)))
+        return set;
     apop_data *add_this_line= apop_data_alloc();
-    int row = 0,
+    int row = 0, rows_allocated = 0,
         hasrows = (has_row_names == 'y');
     Apop_stopif(prep_text_reading(text_file, &infile), apop_return_data_error(t),
             0, "trouble opening %s", text_file);
@@ -653,7 +965,7 @@ APOP_VAR_ENDHEAD
     //First, handle the top line, if we're told that it has column names.
     if (has_col_names=='y'){
         apop_data *field_names = apop_data_alloc();
-        get_field_names(1, NULL, infile, buffer, &ptr, add_this_line, field_names, field_ends, delimiters);
+        get_field_names(1, NULL, infile, buffer, &ptr, add_this_line, field_names, field_ends, char_types, &field_space);
         L.ct = *add_this_line->textsize;
         set = apop_data_alloc(0,1, L.ct - hasrows);
 	    set->names->colct   = 0;
@@ -666,40 +978,31 @@ APOP_VAR_ENDHEAD
     //Now do the body.
 	while(!set || !L.eof || L.ct){
         if (!L.ct) { //skip blank lines
-            L=parse_a_line(infile,buffer, &ptr,  add_this_line, field_ends, delimiters);
+            L=parse_a_line(infile,buffer, &ptr,  add_this_line, field_ends, char_types, &field_space);
             continue;
         }
         if (!set) set = apop_data_alloc(0, 1, L.ct-hasrows); //for .has_col_names=='n'.
         row++;
-        int cols = set->matrix  ? set->matrix->size2 : L.ct - hasrows;
-        set->matrix = apop_matrix_realloc(set->matrix, row, cols);
-        Apop_stopif(!set->matrix, set->error='a'; return set, 0, "allocation error.");
-        if (hasrows) {
-            apop_name_add(set->names, *add_this_line->text[0], 'r');
-            Apop_stopif(L.ct-1 > set->matrix->size2, set->error='t'; return set, 1,
-                 "row %i (not counting rownames) has %i elements (not counting the rowname), "
-                 "but I thought this was a data set with %zu elements per row. "
-                 "Stopping the file read; returning what I have so far.", row, L.ct-1, set->matrix->size2);
-        } else Apop_stopif(L.ct > set->matrix->size2, set->error='t'; return set, 1,
-                 "row %i has %i elements, "
-                 "but I thought this was a data set with %zu elements per row. "
-                 "Stopping the file read; returning what I have so far. Set has_row_names?", row, L.ct, set->matrix->size2);
-        for (int col=hasrows; col < L.ct; col++){
-            char *thisstr = *add_this_line->text[col];
-            if (strlen(thisstr)){
-                double val = strtod(thisstr, &str);
-                if (thisstr != str)
-                    gsl_matrix_set(set->matrix, row-1, col-hasrows, val);
-                else {
-                    gsl_matrix_set(set->matrix, row-1, col-hasrows, GSL_NAN);
-                    Apop_notify(1, "trouble converting data item %i on data line %i [%s]; writing NaN.", col, row, thisstr);
-                }
-            } else gsl_matrix_set(set->matrix, row-1, col-hasrows, GSL_NAN);
+        if (row > rows_allocated){ //grow geometrically; trim at the end.
+            int cols = set->matrix  ? set->matrix->size2 : L.ct - hasrows;
+            rows_allocated = rows_allocated ? rows_allocated*2 : 1;
+            set->matrix = apop_matrix_realloc(set->matrix, rows_allocated, cols);
+            Apop_stopif(!set->matrix, set->error='a'; goto outro, 0, "allocation error.");
         }
+        if (hasrows) apop_name_add(set->names, *add_this_line->text[0], 'r');
+        if (line_too_long(L.ct, hasrows, row, set->matrix)){
+            set->error='t';
+            goto outro;
+        }
+        line_to_row(set->matrix, add_this_line, L.ct, row, hasrows);
         if (L.eof) break;//hit when the last line has elements and is terminated by EOF.
-        L=parse_a_line(infile, buffer, &ptr, add_this_line, field_ends, delimiters);
+        L=parse_a_line(infile, buffer, &ptr, add_this_line, field_ends, char_types, &field_space);
 	}
+    outro:
+    if (set->matrix && row < set->matrix->size1)
+        set->matrix = apop_matrix_realloc(set->matrix, row, set->matrix->size2);
     apop_data_free(add_this_line);
+    free(field_space);
     if (strcmp(text_file,"-")) fclose(infile);
 	return set;
 }
@@ -1080,6 +1383,54 @@ static void line_to_insert(line_parse_t L, apop_data const*addme, char const *ta
     }
 }
 
+//Insert one line, then step and reset the prepared statement if there is one.
+static int insert_line(line_parse_t L, apop_data const*addme, char const *tabname,
+                             sqlite3_stmt *statement, int row, int *ct){
+    int batch_size = 10000;
+    line_to_insert(L, addme, tabname, statement, row);
+    if (!((*ct)++ % batch_size)){
+        if (apop_opts.verbose > 1) {fprintf(stderr, ".");fflush(NULL);}
+    }
+    if (statement){
+        int err = sqlite3_step(statement);
+        if (err!=0 && err != 101) //0=ok, 101=done
+            Apop_notify(0, "sqlite insert query gave error code %i.\n", err);
+        Apop_assert_c(!sqlite3_reset(statement), -1, apop_errorlevel, "SQLite error.");
+#if SQLITE_VERSION_NUMBER >= 3003009
+        Apop_assert_c(!sqlite3_clear_bindings(statement), -1, apop_errorlevel, "SQLite error."); //needed for NULLs
+#endif
+    }
+    return 0;
+}
+
+/* Parse the rest of the mapped file in rounds of one chunk per thread, and insert each
+   round's lines in file order. Returns the line count as the serial loop would have it. */
+static int text_to_db_threaded(text_map_t *m, size_t pos, char const *tabname, sqlite3_stmt *statement,
+                                        char const *char_types, int rows, int *ct){
+    int threadct = GSL_MAX(1, apop_opts.thread_count), eof = 0;
+    text_chunk_t chunks[threadct];
+    text_threadpass tp[threadct];
+    while (pos < m->len && !eof){
+        int chunk_ct = split_text(m->data, &pos, m->len, 40*bs, threadct, chunks, char_types, &eof);
+        for (int i=0; i< chunk_ct; i++)
+            tp[i] = (text_threadpass){.chunk=chunks[i], .char_types=char_types};
+        run_text_threads(tp, chunk_ct, chunk_to_lines);
+        for (int i=0; i< chunk_ct; i++){
+            for (int j=0; j< tp[i].line_ct; j++){
+                if (rows >= 0 && insert_line(tp[i].L[j], tp[i].lines[j], tabname, statement,
+                                                rows + tp[i].line_no[j], ct))
+                    rows = -1;
+                apop_data_free(tp[i].lines[j]);
+            }
+            if (tp[i].error) rows = -1;
+            if (rows >= 0) rows += chunks[i].lines;
+            free(tp[i].lines); free(tp[i].L); free(tp[i].line_no);
+        }
+        if (rows < 0) return -1;
+    }
+    return rows + !eof; //the serial reader makes one last read to find the end of the file.
+}
+
 int apop_use_sqlite_prepared_statements(size_t col_ct){
     #if SQLITE_VERSION_NUMBER < 3003009
         return 0;
@@ -1133,6 +1484,10 @@ apop_query("commit;");
 
 \return Returns the number of rows on success, -1 on error.
 
+\li If <tt>apop_opts.thread_count</tt> is greater than one and the input is a regular file
+(not \c stdin) with delimited fields, I map the file into memory and parse it in
+parallel, one run of whole lines per thread, then insert the lines in file order.
+
 This function uses the \ref designated syntax for inputs.
 \ingroup conversions
 */
@@ -1149,65 +1504,71 @@ APOP_VAR_HEAD int apop_text_to_db(char const *text_file, char *tabname, int has_
     char * apop_varad_var(table_params, NULL)
     const char * apop_varad_var(delimiters, apop_opts.input_delimiters);
 APOP_VAR_ENDHEAD
-    int  batch_size  = 10000, not_ok=0,
-      	 col_ct, ct = 0, rows = 1;
-    FILE *infile;
+    int  not_ok=0, col_ct, ct = 0, rows = 1, out = -1;
+    FILE *infile = NULL;
     char buffer[bs];
-    size_t ptr=bs;
-    apop_data *add_this_line = apop_data_alloc();
-    sqlite3_stmt *statement;
+    size_t ptr=bs, *field_space=NULL, first, pos = 0;
+    char char_types[256];
+    set_char_types(char_types, delimiters);
+    apop_data *add_this_line = apop_data_alloc(), *fn = NULL;
+    sqlite3_stmt *statement = NULL;
     line_parse_t L={1,0};
+    text_map_t m;
 
 	Apop_assert_c(!apop_table_exists(tabname), -1, 0, "table %s exists; not recreating it.", tabname);
 
-    //get names and the first row.
-    if (prep_text_reading(text_file, &infile)) return -1;
-    apop_data *fn = apop_data_alloc();
+    //get names and the first row. If threading, read them from the top of the mapped file.
+    int threaded = apop_opts.thread_count > 1 && !field_ends && !map_text_file(text_file, &m);
+    if (threaded){
+        pos = first_data_line_end(m.data, m.len, has_col_names=='y' && !field_names, char_types, &first);
+        if (pos) infile = fmemopen(m.data, pos, "r");
+        if (!infile){
+            unmap_text_file(&m);
+            threaded = 0;
+        }
+    }
+    if (!threaded && prep_text_reading(text_file, &infile)) goto bailout;
+    fn = apop_data_alloc();
     get_field_names(has_col_names=='y', field_names, infile, buffer, &ptr,
-                                    add_this_line, fn, field_ends, delimiters);
+                                    add_this_line, fn, field_ends, char_types, &field_space);
     col_ct = L.ct = *add_this_line->textsize;
-    Apop_stopif(!col_ct, return -1, 0, "counted zero columns in the input file (%s).", tabname);
+    Apop_stopif(!col_ct, goto bailout, 0, "counted zero columns in the input file (%s).", tabname);
     if (apop_opts.db_engine=='m')
         not_ok = tab_create_mysql(tabname, has_row_names=='y', field_params, table_params, fn);
     else
         not_ok = tab_create_sqlite(tabname, has_row_names=='y', field_params, table_params, fn);
-    Apop_stopif(not_ok, return -1, 0, "Creating the table in the database failed.");
+    Apop_stopif(not_ok, goto bailout, 0, "Creating the table in the database failed.");
 #if SQLITE_VERSION_NUMBER < 3003009
     apop_notify(1, "Apophenia was compiled using a version of SQLite from mid-2007 or earlier. "
                     "The code for reading in text files using such an old version is no longer supported, "
                     "so if errors crop up please see about installing a more recent version of SQLite's library.");
 #endif
-    int use_sqlite_prepared_statements = apop_use_sqlite_prepared_statements(col_ct);
-    if (use_sqlite_prepared_statements)
+    if (apop_use_sqlite_prepared_statements(col_ct))
         Apop_stopif(apop_prepare_prepared_statements(tabname, col_ct, &statement), 
-                return -1, 0, "Trouble preparing the prepared statement for SQLite.");
+                goto bailout, 0, "Trouble preparing the prepared statement for SQLite.");
     //done with table & query setup.
     //convert a data line into SQL: insert into TAB values (0.3, 7, "et cetera");
-	while(L.ct && !L.eof){
-        line_to_insert(L, add_this_line, tabname, statement, rows);
-        if (!(ct++ % batch_size)){
-            if (apop_opts.verbose > 1) {fprintf(stderr, ".");fflush(NULL);}
-        }
-        if (use_sqlite_prepared_statements){
-            int err = sqlite3_step(statement);
-            if (err!=0 && err != 101) //0=ok, 101=done
-                Apop_notify(0, "sqlite insert query gave error code %i.\n", err);
-            Apop_assert_c(!sqlite3_reset(statement), -1, apop_errorlevel, "SQLite error.");
-#if SQLITE_VERSION_NUMBER >= 3003009
-            Apop_assert_c(!sqlite3_clear_bindings(statement), -1, apop_errorlevel, "SQLite error."); //needed for NULLs
-#endif
-        }
+	while(L.ct){
+        if (insert_line(L, add_this_line, tabname, statement, rows, &ct)) goto bailout;
+        if (L.eof || threaded) break;
         do {
-            L = parse_a_line(infile, buffer, &ptr, add_this_line, field_ends, delimiters);
+            L = parse_a_line(infile, buffer, &ptr, add_this_line, field_ends, char_types, &field_space);
             rows ++;
         } while (!L.ct && !L.eof); //skip blank lines
 	}
-    apop_data_free(add_this_line);
+    if (threaded)
+        rows = text_to_db_threaded(&m, pos, tabname, statement, char_types, rows, &ct);
+    out = rows;
+
+    bailout:
 #if SQLITE_VERSION_NUMBER >= 3003009
-	if (use_sqlite_prepared_statements){
-        Apop_assert_c(sqlite3_finalize(statement) ==SQLITE_OK, -1, apop_errorlevel, "SQLite error.");
-    }
+	if (statement)
+        Apop_stopif(sqlite3_finalize(statement) != SQLITE_OK, out = -1, apop_errorlevel, "SQLite error.");
 #endif
-    if (strcmp(text_file,"-")) fclose(infile);
-	return rows;
+    if (infile && strcmp(text_file,"-")) fclose(infile);
+    if (threaded) unmap_text_file(&m); //after closing infile, which reads from the map.
+    apop_data_free(add_this_line);
+    apop_data_free(fn);
+    free(field_space);
+	return out;
 }
@@ -249,47 +249,14 @@ apop_data * apop_query_to_text(const char * fmt, ...){
     return out;
 }
 
-//apop_query_to_data callback.
-static int db_to_table(void *qinfo, int argc, char **argv, char **column){
-    Apop_stopif(!argv, return -1, apop_errorlevel, "Got NULL data from SQLite.");
-    int i, ncfound = 0;
-    callback_t *qi= qinfo;
-    if (qi->firstcall){
-        qi->firstcall--;
-        for(i=0; i<argc; i++)
-            if (!strcasecmp(column[i], apop_opts.db_name_column)){
-                qi->namecol = i;
-                ncfound = 1;
-                break;
-            }
-	    qi->outdata = argc-ncfound ? apop_data_alloc(1, argc-ncfound) : apop_data_alloc( );
-        for(i=0; i<argc; i++)
-            if (qi->namecol != i)
-                apop_name_add(qi->outdata->names, column[i], 'c');
-    } else 
-        if (qi->outdata->matrix)
-            apop_matrix_realloc(qi->outdata->matrix, qi->currentrow+1, qi->outdata->matrix->size2);
-    ncfound =0;
-    for (int jj=0;jj<argc;jj++)
-        if (jj != qi->namecol){
-            double valor = 
-                !argv[jj] || !strcmp(argv[jj], "NULL")|| !strcasecmp(apop_opts.db_nan, argv[jj])
-                 ? GSL_NAN : atof(argv[jj]);
-            gsl_matrix_set(qi->outdata->matrix,qi->currentrow,jj-ncfound, valor);
-        } else {
-            apop_name_add(qi->outdata->names, argv[jj], 'r');
-            ncfound = 1;
-        }
-    (qi->currentrow)++;
-	return 0;
-}
-
 /** Queries the database, and dumps the result into an \ref apop_data set.
 
 \li If \ref apop_opts_type "apop_opts.db_name_column" is set (it defaults to being "row_names"), and the name of a column matches the name, then the row names are read from that column.
 
 \li As with the other \c apop_query_to_... functions, the query can include printf-style format specifiers, such as <tt>apop_query_to_data("select age from %s where id=%i;", tablename, id_number)</tt>.
 
+\li For SQLite, numeric cells are read directly as <tt>double</tt>s, without a round trip through text. Text cells are converted via \c atof.
+
 \return If no rows are returned, \c NULL; else an \ref apop_data set with the data in place. Most data will be in the \c matrix element of the output. Column names are appropriately placed. If <tt>apop_opts.db_name_column</tt> matches one of the fields in your query's output, then that column will be used for row names (and therefore will not appear in the \c matrix).
 
 \param fmt A <tt>printf</tt>-style SQL query.
@@ -305,16 +272,28 @@ apop_data * apop_query_to_data(const char * fmt, ...){
 #endif
 
     //else
-    char *err=NULL;
-    callback_t qinfo = {.firstcall = 1, .namecol=-1};
-	if (db==NULL) apop_db_open(NULL);
-    sqlite3_exec(db, query,db_to_table,&qinfo, &err); 
-    free (query);
-    ERRCHECK_SET_ERROR(qinfo.outdata)
-	return qinfo.outdata;
+    apop_data *out = apop_sqlite_query_to_data(query);
+    free(query);
+	return out;
 }
 
 
+/* Run a query and hand its output to block_fn a block of at most block_rows rows at a
+time, so the full result set need never be in memory. block_fn owns each block it gets,
+and can return nonzero to stop the read. With SQLite, rows are stepped through directly;
+the MySQL version reads the full result set and hands it over as a single block.
+Returns zero on success, else the query's error code or block_fn's nonzero return. */
+int apop_query_to_blocks(char const *query, size_t block_rows,
+                            int (*block_fn)(apop_data *, void *), void *info){
+    Apop_stopif(!block_rows, return 1, 0, "Blocks must have at least one row.");
+    if (apop_opts.db_engine == 'm'){
+        apop_data *d = apop_query_to_data("%s", query);
+        Apop_stopif(d && d->error, apop_data_free(d); return 1, 0, "Query error.");
+        return d ? block_fn(d, info) : 0;
+    }
+    return apop_sqlite_query_to_blocks(query, block_rows, block_fn, info);
+}
+
     /** \cond doxy_ignore */
 //These used to do more, but I'll leave them as a macro anyway in case of future expansion.
 #define Store_settings  \
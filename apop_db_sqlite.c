@@ -29,6 +29,20 @@ group by whatever
 
 \li The  var/skew/kurtosis functions calculate sample moments, so if you want the population moment, multiply the result by (n-1)/n .
 
+\li <tt>approx_percentile(x, p)</tt> gives the approximate \c p-th percentile of \c x (with \c p
+between 0 and 100), and <tt>approx_median(x)</tt> is <tt>approx_percentile(x, 50)</tt>. They
+build an \ref apop_quantile_sketch for each group, so they take one pass and a fixed amount
+of memory however large the table, and the min and max are exact. Blanks are ignored. The
+percentile \c p is read from the first row of each group where \c x is not blank, so give
+one \c p per query, not a column that varies by row. They are named so as not to replace
+the exact <tt>percentile</tt> and <tt>median</tt> that some builds of SQLite provide.
+
+\code
+select grp, approx_median(x), approx_percentile(x, 5), approx_percentile(x, 95)
+from table
+group by grp
+\endcode
+
 \li For bonus points, there are the <tt>sqrt(x)</tt>, <tt>pow(x,y)</tt>, <tt>exp(x)</tt>,
 <tt>log(x)</tt>, and trig functions. They call the standard math library function
 of the same name to calculate \f$\sqrt{x}\f$, \f$x^y\f$, \f$e^x\f$, \f$\ln(x)\f$,
@@ -166,6 +180,30 @@ static void kurtFinalize(sqlite3_context *context){
       sqlite3_result_double(context, 0);
 }
 
+/* approx_percentile(x, p) and approx_median(x) keep a quantile sketch in the aggregate context, and
+   free it on finalizing. With no non-NULL rows, there's no sketch, and the result is NULL. */
+typedef struct {
+    apop_quantile_sketch *sketch;
+    double pct;
+} PercentileCtx;
+
+static void percentileStep(sqlite3_context *context, int argc, sqlite3_value **argv){
+    PercentileCtx *p = sqlite3_aggregate_context(context, sizeof(*p));
+    if (!p || sqlite3_value_type(argv[0]) == SQLITE_NULL) return;
+    if (!p->sketch){
+        p->sketch = apop_quantile_sketch_alloc();
+        p->pct = argc > 1 ? sqlite3_value_double(argv[1]) : 50;
+    }
+    apop_quantile_sketch_add(p->sketch, sqlite3_value_double(argv[0]));
+}
+
+static void percentileFinalize(sqlite3_context *context){
+    PercentileCtx *p = sqlite3_aggregate_context(context, sizeof(*p));
+    if (!p || !p->sketch) return;
+    sqlite3_result_double(context, apop_quantile_sketch_quantile(p->sketch, p->pct/100.));
+    apop_quantile_sketch_free(p->sketch);
+}
+
 static void powFn(sqlite3_context *context, int argc, sqlite3_value **argv){
     double base = sqlite3_value_double(argv[0]);
     double exp  = sqlite3_value_double(argv[1]);
@@ -199,6 +237,8 @@ static int apop_sqlite_db_open(char const *filename){
 	sqlite3_create_function(db, "skew", 1, SQLITE_ANY, NULL, NULL, &threeStep, &skewFinalize);
 	sqlite3_create_function(db, "kurt", 1, SQLITE_ANY, NULL, NULL, &fourStep, &kurtFinalize);
 	sqlite3_create_function(db, "kurtosis", 1, SQLITE_ANY, NULL, NULL, &fourStep, &kurtFinalize);
+	sqlite3_create_function(db, "approx_percentile", 2, SQLITE_ANY, NULL, NULL, &percentileStep, &percentileFinalize);
+	sqlite3_create_function(db, "approx_median", 1, SQLITE_ANY, NULL, NULL, &percentileStep, &percentileFinalize);
 	sqlite3_create_function(db, "ln", 1, SQLITE_ANY, NULL, &logFn, NULL, NULL);
 	sqlite3_create_function(db, "ran", 0, SQLITE_ANY, NULL, &rngFn, NULL, NULL);
 	sqlite3_create_function(db, "pow", 2, SQLITE_ANY, NULL, &powFn, NULL, NULL);
@@ -258,11 +298,152 @@ apop_data * apop_sqlite_query_to_text(char *query){
     return qinfo.outdata;
 }
 
+/* The numeric apop_query_to_... functions don't go through sqlite3_exec, which hands
+every cell to the callback as a string. Instead, we prepare each statement and step
+through it, so numeric cells are read straight off the row via sqlite3_column_double,
+with no printf/atof round trip. The output is grown geometrically as rows come in,
+and trimmed to size at the end.  */
+
+//Step through every statement in the query (sqlite3_exec allows several), calling
+//row_fn on each row. Returns a nonzero SQLite error code or nonzero from row_fn on failure.
+static int apop_sqlite_step_through(char const *query, int (*row_fn)(sqlite3_stmt*, void*), void *info){
+    char const *tail = query;
+    while (tail && *tail){
+        sqlite3_stmt *stmt = NULL;
+        int rc = sqlite3_prepare_v2(db, tail, -1, &stmt, &tail);
+        if (rc != SQLITE_OK) return rc;
+        if (!stmt) continue; //whitespace or a comment.
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+            if (row_fn(stmt, info)){
+                sqlite3_finalize(stmt);
+                return SQLITE_ABORT;
+            }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return rc;
+    }
+    return 0;
+}
+
+/* If apop_opts.db_nan is something like -999, then a numeric cell can match it,
+   and we have to check numeric cells against it as well as text cells. */
+static double const *numeric_nan(double *space){
+    char *end;
+    *space = strtod(apop_opts.db_nan, &end);
+    return (*apop_opts.db_nan && !*end) ? space : NULL;
+}
+
+static double cell_to_double(sqlite3_stmt *stmt, int col, double const *nan_value){
+    switch (sqlite3_column_type(stmt, col)){
+        case SQLITE_NULL: return GSL_NAN;
+        case SQLITE_INTEGER:
+        case SQLITE_FLOAT: {
+            double out = sqlite3_column_double(stmt, col);
+            return (nan_value && out == *nan_value) ? GSL_NAN : out;
+        }
+        default: { //text or blob that may hold a number, as from apop_text_to_db.
+            char const *txt = (char const *) sqlite3_column_text(stmt, col);
+            return (!txt || !strcmp(txt, "NULL") || !strcasecmp(apop_opts.db_nan, txt))
+                     ? GSL_NAN : atof(txt);
+        }
+    }
+}
+
+typedef struct {    //for apop_sqlite_query_to_data.
+    int       firstcall, namecol;
+    size_t    currentrow, rows_allocated;
+    apop_data *outdata;
+    double const *nan_value;
+} typed_fetch_t;
+
+static int stmt_to_table(sqlite3_stmt *stmt, void *qinfo){
+    typed_fetch_t *qi = qinfo;
+    int argc = sqlite3_column_count(stmt), ncfound = 0;
+    if (qi->firstcall){
+        qi->firstcall--;
+        for (int i=0; i< argc; i++)
+            if (!strcasecmp(sqlite3_column_name(stmt, i), apop_opts.db_name_column)){
+                qi->namecol = i;
+                ncfound = 1;
+                break;
+            }
+        qi->outdata = argc-ncfound ? apop_data_alloc(1, argc-ncfound) : apop_data_alloc();
+        qi->rows_allocated = 1;
+        for (int i=0; i< argc; i++)
+            if (qi->namecol != i)
+                apop_name_add(qi->outdata->names, sqlite3_column_name(stmt, i), 'c');
+    } else if (qi->outdata->matrix && qi->currentrow >= qi->rows_allocated){
+        qi->rows_allocated *= 2;
+        apop_matrix_realloc(qi->outdata->matrix, qi->rows_allocated, qi->outdata->matrix->size2);
+    }
+    ncfound = 0;
+    for (int jj=0; jj< argc; jj++)
+        if (jj != qi->namecol)
+            gsl_matrix_set(qi->outdata->matrix, qi->currentrow, jj-ncfound,
+                                cell_to_double(stmt, jj, qi->nan_value));
+        else {
+            char const *name = (char const *) sqlite3_column_text(stmt, jj);
+            apop_name_add(qi->outdata->names, name ? name : "NaN", 'r');
+            ncfound = 1;
+        }
+    qi->currentrow++;
+    return 0;
+}
+
+apop_data *apop_sqlite_query_to_data(char const *query){
+    double nan_space;
+    typed_fetch_t qinfo = {.firstcall = 1, .namecol=-1, .nan_value=numeric_nan(&nan_space)};
+    if (!db) apop_db_open(NULL);
+    int rc = apop_sqlite_step_through(query, stmt_to_table, &qinfo);
+    Apop_stopif(rc, if (!qinfo.outdata) {qinfo.outdata=apop_data_alloc();} qinfo.outdata->error='q';
+                    return qinfo.outdata, 0, "%s: %s", query, sqlite3_errmsg(db));
+    if (qinfo.outdata && qinfo.outdata->matrix && qinfo.currentrow < qinfo.outdata->matrix->size1)
+        apop_matrix_realloc(qinfo.outdata->matrix, qinfo.currentrow, qinfo.outdata->matrix->size2);
+    return qinfo.outdata;
+}
+
+typedef struct {    //for apop_sqlite_query_to_blocks.
+    typed_fetch_t fetch;
+    size_t        block_rows;
+    int           (*block_fn)(apop_data *, void *);
+    void          *block_info;
+} block_fetch_t;
+
+//Hand the rows read so far to the block function, which takes ownership, and start afresh.
+static int flush_block(block_fetch_t *bi){
+    typed_fetch_t *qi = &bi->fetch;
+    if (!qi->outdata) return 0;
+    if (qi->outdata->matrix && qi->currentrow < qi->outdata->matrix->size1)
+        apop_matrix_realloc(qi->outdata->matrix, qi->currentrow, qi->outdata->matrix->size2);
+    int out = bi->block_fn(qi->outdata, bi->block_info);
+    *qi = (typed_fetch_t){.firstcall = 1, .namecol=-1, .nan_value=qi->nan_value};
+    return out;
+}
+
+static int stmt_to_blocks(sqlite3_stmt *stmt, void *info){
+    block_fetch_t *bi = info;
+    stmt_to_table(stmt, &bi->fetch);
+    return (bi->fetch.currentrow >= bi->block_rows) ? flush_block(bi) : 0;
+}
+
+static int apop_sqlite_query_to_blocks(char const *query, size_t block_rows,
+                                    int (*block_fn)(apop_data *, void *), void *info){
+    double nan_space;
+    block_fetch_t bi = {.fetch={.firstcall = 1, .namecol=-1, .nan_value=numeric_nan(&nan_space)},
+                        .block_rows=block_rows, .block_fn=block_fn, .block_info=info};
+    if (!db) apop_db_open(NULL);
+    int rc = apop_sqlite_step_through(query, stmt_to_blocks, &bi);
+    Apop_stopif(rc && rc != SQLITE_ABORT, apop_data_free(bi.fetch.outdata); return rc,
+                    0, "%s: %s", query, sqlite3_errmsg(db));
+    if (rc) {apop_data_free(bi.fetch.outdata); return rc;} //the block function asked to stop.
+    return flush_block(&bi);
+}
+
 typedef struct {
     apop_data  *d;
     int        intypes[5];//names, vectors, mcols, textcols, weights.
-    int        current, thisrow, error_thrown;
+    int        current, thisrow, rows_allocated, error_thrown;
     const char *instring;
+    double const *nan_value;
 } apop_qt;
 
 static void count_types(apop_qt *in, const char *intypes){
@@ -283,12 +464,23 @@ static void count_types(apop_qt *in, const char *intypes){
         Apop_notify(1, "You asked apop_query_to_mixed for multiple weighting vectors. I'll ignore all but the last one.");
 }
 
-static int multiquery_callback(void *instruct, int argc, char **argv, char **column){
+//Resize every element of the output to the given row count.
+static void multiquery_resize(apop_qt *in, int rows){
+    if (in->d->textsize[1])
+        in->d->text = realloc(in->d->text, sizeof(char **)*rows);
+    if (in->intypes[2]) apop_matrix_realloc(in->d->matrix, rows, in->intypes[2]);
+    if (in->d->vector)  apop_vector_realloc(in->d->vector, rows);
+    if (in->d->weights) apop_vector_realloc(in->d->weights, rows);
+    in->rows_allocated = rows;
+}
+
+static int multiquery_row(sqlite3_stmt *stmt, void *instruct){
     apop_qt *in = instruct;
     char c;
     int thistcol    = 0, 
         thismcol    = 0,
         colct       = 0,
+        argc        = sqlite3_column_count(stmt),
         i, addnames = 0;
     in->thisrow ++;
     if (!in->d) {
@@ -302,42 +494,42 @@ static int multiquery_callback(void *instruct, int argc, char **argv, char **col
             in->d->textsize[1]  = in->intypes[3];
             in->d->text         = malloc(sizeof(char***));
         }
+        in->rows_allocated = 1;
     }
     if (!(in->d->names->colct + in->d->names->textct + (in->d->names->vector!=NULL)))
         addnames++;
+    if (in->thisrow > in->rows_allocated)
+        multiquery_resize(in, in->rows_allocated*2);
     if (in->d->textsize[1]){
         in->d->textsize[0]         = in->thisrow;
-        in->d->text                = realloc(in->d->text, sizeof(char ***)*in->thisrow);
         in->d->text[in->thisrow-1] = malloc(sizeof(char**) * in->d->textsize[1]);
     }
-    if (in->intypes[2])
-        apop_matrix_realloc(in->d->matrix, in->thisrow, in->intypes[2]);
     for (i=in->current=0; i< argc; i++){
         c   = in->instring[in->current++];
+        char const *column = sqlite3_column_name(stmt, i);
         if (c=='n'||c=='N'){
-            apop_name_add(in->d->names, (argv[i]? argv[i] : "NaN")  , 'r'); 
+            char const *name = (char const *) sqlite3_column_text(stmt, i);
+            apop_name_add(in->d->names, (name ? name : "NaN"), 'r'); 
             if(addnames)
-                apop_name_add(in->d->names, column[i], 'h'); 
+                apop_name_add(in->d->names, column, 'h'); 
         } else if (c=='v'||c=='V'){
-            apop_vector_realloc(in->d->vector, in->thisrow);
-            apop_data_set(in->d, in->thisrow-1, -1, 
-                                    argv[i] ? atof(argv[i]) : GSL_NAN);
+            gsl_vector_set(in->d->vector, in->thisrow-1, 
+                                    cell_to_double(stmt, i, in->nan_value));
             if(addnames)
-                apop_name_add(in->d->names, column[i], 'v'); 
+                apop_name_add(in->d->names, column, 'v'); 
         } else if (c=='m'||c=='M'){
-            apop_data_set(in->d, in->thisrow-1, thismcol++, 
-                                    argv[i] ? atof(argv[i]) : GSL_NAN);
+            gsl_matrix_set(in->d->matrix, in->thisrow-1, thismcol++, 
+                                    cell_to_double(stmt, i, in->nan_value));
             if(addnames)
-                apop_name_add(in->d->names, column[i], 'c'); 
+                apop_name_add(in->d->names, column, 'c'); 
         } else if (c=='t'||c=='T'){
-            asprintf(&(in->d->text[in->thisrow-1][thistcol++]), "%s", 
-			                        argv[i] ? argv[i] : "NaN");
+            char const *txt = (char const *) sqlite3_column_text(stmt, i);
+            asprintf(&(in->d->text[in->thisrow-1][thistcol++]), "%s", txt ? txt : "NaN");
             if(addnames)
-                apop_name_add(in->d->names, column[i], 't'); 
+                apop_name_add(in->d->names, column, 't'); 
         } else if (c=='w'||c=='W'){
-            apop_vector_realloc(in->d->weights, in->thisrow);
             gsl_vector_set(in->d->weights, in->thisrow-1, 
-                                    argv[i] ? atof(argv[i]) : GSL_NAN);
+                                    cell_to_double(stmt, i, in->nan_value));
         }
         colct++;
     }
@@ -351,13 +543,16 @@ static int multiquery_callback(void *instruct, int argc, char **argv, char **col
 apop_data *apop_sqlite_multiquery(const char *intypes, char *query){
     apop_assert(intypes, "You gave me NULL for the list of input types. I can't work with that.");
     apop_assert(query, "You gave me a NULL query. I can't work with that.");
-    char *err = NULL;
-    apop_qt info = { };
+    double nan_space;
+    apop_qt info = {.nan_value=numeric_nan(&nan_space)};
     count_types(&info, intypes);
 	if (!db) apop_db_open(NULL);
-    sqlite3_exec(db, query, multiquery_callback, &info, &err); 
-    Apop_stopif(info.error_thrown, if (!info.d) apop_data_alloc(); info.d->error='d'; return info.d,
+    int rc = apop_sqlite_step_through(query, multiquery_row, &info);
+    Apop_stopif(info.error_thrown, if (!info.d) {info.d=apop_data_alloc();} info.d->error='d'; return info.d,
             0, "dimension error");
-    ERRCHECK_SET_ERROR(info.d)
-	return info.d;
+    Apop_stopif(rc, if (!info.d) {info.d=apop_data_alloc();} info.d->error='q'; return info.d,
+            0, "%s: %s", query, sqlite3_errmsg(db));
+    if (info.d && info.thisrow < info.rows_allocated)
+        multiquery_resize(&info, info.thisrow);
+    return info.d;
 }
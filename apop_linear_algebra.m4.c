@@ -22,6 +22,17 @@ void apop_gsl_error(const char *reason, const char *file, int line, int gsl_errn
     Apop_notify(1, "%s: %s", file, reason);
     Apop_maybe_abort(1);
 }
+
+/* Are the two matrices the same size, with identical elements? Used to check whether a
+ cached factorization is still current. Declared in internal.h. */
+int apop_same_matrix(gsl_matrix const *a, gsl_matrix const *b){
+    if (a->size1 != b->size1 || a->size2 != b->size2) return 0;
+    for (size_t i=0; i< a->size1; i++)
+        for (size_t j=0; j< a->size2; j++)
+            if (gsl_matrix_get(a, i, j) != gsl_matrix_get(b, i, j)) return 0;
+    return 1;
+}
+
 #define Checkgsl(...) if (__VA_ARGS__) {goto done;}
 #define Check_gsl_with_out(...) if (__VA_ARGS__) {out->error='m'; goto done;}
 #define Check_gsl_with_outmp(...) if (__VA_ARGS__) {gsl_matrix_free(*out); *out=NULL; goto done;}
@@ -14,11 +14,12 @@
    which some may find useful.
 
    We thus have a lot of functions that all feed in to mapply_core, which, after several if statements,
-   then dispatches segments do different threads, and either the vectorloop or forloop that does all the
+   then hands segments to the thread pool, and either the vectorloop or forloop that does all the
    actual math.
 
  */
 #include "apop_internal.h"
+#include <stdint.h>
 static gsl_vector*mapply_core(gsl_matrix *m, gsl_vector *vin, void *fn, gsl_vector *vout, int use_index, int use_param,void *param, char post_22);
 
 typedef double apop_fn_v(gsl_vector*);
@@ -36,6 +37,169 @@ typedef double apop_fn_vi(gsl_vector*, int);
 typedef double apop_fn_di(double, int);
 typedef double apop_fn_ri(apop_data*, int);
 
+/* The thread pool. Workers are started on first need and then sleep on a condition
+   variable between jobs, so a job costs a broadcast and a wait rather than a round of
+   pthread_create/join. Each participant (the caller is participant zero) gets a
+   contiguous run of chunks as its queue, works from the front, and when it runs dry
+   takes chunks off the back of the others' queues. */
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next, end; //chunk numbers, not rows.
+} pool_queue;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t go, done;
+    int worker_ct;
+    long generation;
+    int participants, finished;
+    apop_pool_fn *fn;
+    void *ctx;
+    size_t n, chunk;
+    pool_queue *queues;
+} pool = {.lock=PTHREAD_MUTEX_INITIALIZER, .go=PTHREAD_COND_INITIALIZER, .done=PTHREAD_COND_INITIALIZER};
+
+static pthread_mutex_t pool_busy = PTHREAD_MUTEX_INITIALIZER;
+
+/* Whether this thread is doing pool work, so a nested apop_pool_run runs serially. This
+   is a pthread key rather than a threadlocal int because threadlocal compiles away to a
+   plain global on some systems. */
+static pthread_key_t in_pool_key;
+static pthread_once_t in_pool_once = PTHREAD_ONCE_INIT;
+static void in_pool_key_init(void){ pthread_key_create(&in_pool_key, NULL); }
+
+static int in_pool(void){
+    pthread_once(&in_pool_once, in_pool_key_init);
+    return pthread_getspecific(in_pool_key) != NULL;
+}
+
+static void set_in_pool(int yes){
+    pthread_once(&in_pool_once, in_pool_key_init);
+    pthread_setspecific(in_pool_key, yes ? &in_pool_key : NULL);
+}
+
+static int pool_take(pool_queue *q, int from_back, size_t *c){
+    int got = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->next < q->end){
+        *c = from_back ? --q->end : q->next++;
+        got = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+static void pool_work(int worker){
+    size_t c;
+    int p = pool.participants;
+    while (1){
+        int got = pool_take(pool.queues+worker, 0, &c);
+        for (int k=1; !got && k< p; k++)
+            got = pool_take(pool.queues+(worker+k)%p, 1, &c);
+        if (!got) return;
+        pool.fn(pool.ctx, c*pool.chunk, GSL_MIN(pool.n, (c+1)*pool.chunk), worker);
+    }
+}
+
+static void *pool_worker(void *in){
+    int id = (intptr_t) in;
+    long seen = 0;
+    set_in_pool(1);
+    pthread_mutex_lock(&pool.lock);
+    while (1){
+        while (pool.generation == seen) pthread_cond_wait(&pool.go, &pool.lock);
+        seen = pool.generation;
+        if (id >= pool.participants) continue;
+        pthread_mutex_unlock(&pool.lock);
+        pool_work(id);
+        pthread_mutex_lock(&pool.lock);
+        if (++pool.finished == pool.participants-1) pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+/* A default chunk size: small enough that there are several chunks per thread to
+   even out uneven rows, large enough that the queue locks are noise. */
+size_t apop_pool_chunk(size_t n){
+    return GSL_MAX(1, n/(8*GSL_MAX(1, apop_opts.thread_count)));
+}
+
+/* For sums that write each chunk's subtotal to its own slot and add the slots in order.
+   The chunk size depends only on n, so the grouping of the sum, and thus the last bits of
+   the result, are the same at any thread count. At most 256 or so slots. */
+size_t apop_pool_fixed_chunk(size_t n){
+    return GSL_MAX(64, (n+255)/256);
+}
+
+void apop_pool_run(apop_pool_fn *fn, void *ctx, size_t n, size_t chunk){
+    if (!n) return;
+    if (!chunk) chunk = apop_pool_chunk(n);
+    size_t chunk_ct = (n + chunk - 1)/chunk;
+    int threadct = GSL_MAX(1, GSL_MIN(chunk_ct, apop_opts.thread_count));
+    if (threadct == 1 || in_pool() || pthread_mutex_trylock(&pool_busy)){
+        for (size_t c=0; c< chunk_ct; c++)
+            fn(ctx, c*chunk, GSL_MIN(n, (c+1)*chunk), 0);
+        return;
+    }
+    pthread_mutex_lock(&pool.lock);
+    for ( ; pool.worker_ct < threadct-1; pool.worker_ct++){
+        pthread_t id;
+        Apop_stopif(pthread_create(&id, NULL, pool_worker, (void*)(intptr_t)(pool.worker_ct+1)),
+                break, 0, "Couldn't start a pool thread; running with %i.", pool.worker_ct+1);
+        pthread_detach(id);
+    }
+    threadct = GSL_MIN(threadct, pool.worker_ct+1);
+    pool_queue queues[threadct];
+    for (int t=0; t< threadct; t++){
+        pthread_mutex_init(&queues[t].lock, NULL);
+        queues[t].next = t*chunk_ct/threadct;
+        queues[t].end = (t+1)*chunk_ct/threadct;
+    }
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.n = n;
+    pool.chunk = chunk;
+    pool.queues = queues;
+    pool.participants = threadct;
+    pool.finished = 0;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.go);
+    pthread_mutex_unlock(&pool.lock);
+
+    set_in_pool(1);
+    pool_work(0);
+    set_in_pool(0);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.finished < threadct-1) pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    for (int t=0; t< threadct; t++) pthread_mutex_destroy(&queues[t].lock);
+    pthread_mutex_unlock(&pool_busy);
+}
+
+
+typedef struct {
+    apop_data *in, *out;
+    apop_fn_r *fn_r;
+    apop_fn_rp *fn_rp;
+    apop_fn_rpi *fn_rpi;
+    apop_fn_ri *fn_ri;
+    void *param;
+    int inplace;
+} rowpass;
+
+static void rowloop(void *in, size_t lo, size_t hi, int worker){
+    rowpass *rp = in;
+    for (size_t i=lo; i< hi; i++){
+        Apop_data_row(rp->in, i, the_row);
+        double val = rp->fn_r ? rp->fn_r(the_row)
+                   : rp->fn_rp ? rp->fn_rp(the_row, rp->param)
+                   : rp->fn_rpi ? rp->fn_rpi(the_row, rp->param, i)
+                   : rp->fn_ri(the_row, i);
+        if (rp->inplace != 'y') gsl_vector_set(rp->out->vector, i, val);
+    }
+}
 
 /**
   Apply a function to every element of a data set, matrix or vector; or, apply a vector-taking function to every row or column of a matrix.
@@ -87,12 +251,15 @@ if you set \c inplace='n', then I will return an \ref apop_data set whose \c vec
 element is as long as your data set (i.e., as long as the longest of your text, vector,
 or matrix parts).
 
-\li If you set <tt>apop_opts.thread_count</tt> to a value greater than one, I will split the data set into as many chunks as you specify, and process them simultaneously. You need to watch out for the usual hang-ups about multithreaded programming, but if your data is iid, and each row's processing is independent of the others, you should have no problems. Bear in mind that generating threads takes some small overhead, so simple cases like adding a few hundred numbers will actually be slower when threading.
+\li If you set <tt>apop_opts.thread_count</tt> to a value greater than one, I will split the data set into chunks and process them on that many threads simultaneously. You need to watch out for the usual hang-ups about multithreaded programming, but if your data is iid, and each row's processing is independent of the others, you should have no problems. The threads are kept in a pool from one call to the next, and a thread that finishes its chunks early takes over chunks from slower threads, so rows of uneven cost still keep all threads busy. This includes row-wise functions
+(<tt>.fn_r</tt> and kin), so those have to be safe to call from several threads at once. There is still some small overhead in handing out the work, so simple cases like adding a few hundred numbers may be slower when threading.
+
+\li If your function itself calls \ref apop_map or \ref apop_map_sum (or another function that uses them, like a model's log likelihood), the inner call runs in the calling thread rather than waiting on the pool.
 
 \param inplace  If zero, generate a new \ref apop_data set for output, which will contain the mapped values (and the names from the original set). If one, modify in place. The \c double \f$\to\f$ \c double versions, \c 'v', \c 'm', and \c 'a', write to exactly the same location as before. The \c gsl_vector \f$\to\f$ \c double versions, \c 'r', and \c 'c', will write to the vector. Be careful: if you are writing in place and there is already a vector there, then the original vector is lost. (Default = 0)
 
 \param all_pages If \c 'y', then I follow the \c more pointer to subsequent pages, else I
-handle only the first page of data. [I abuse this for an internal semaphore, by the way, so your input must always be nonnegative and  less than 1,000. Of course, 'y' and 'n' fit these rules fine.]
+handle only the first page of data.
 Default: \c 'n'. 
 
 \return if <tt>.inplace='n'</tt> (the default), a newly allocated \ref apop_data set representing the result of mapping your function onto the input data set. if <tt>.inplace='y'</tt>, a pointer to your original data set, modified in place.
@@ -163,20 +330,13 @@ APOP_VAR_ENDHEAD
             apop_name_stack(in->names, out->names, 'r', 'c');
     }
 
-#define PLACE(fn) {if (inplace == 'y') fn; else gsl_vector_set(out->vector, i, fn);}
-
     //Call mapply_core.
     if (by_apop_rows){
-        for (size_t i=0; i<GSL_MAX(in->textsize[0], maxsize); i++){
-            Apop_data_row(in, i, the_row);
-            if (fn_r) PLACE(fn_r(the_row))
-            else if (fn_rp)
-                PLACE(fn_rp(the_row, param))
-            else if (fn_rpi)
-                PLACE(fn_rpi(the_row, param, i))
-            else if (fn_ri)
-                PLACE(fn_ri(the_row, i))
-        }
+        rowpass rp = {.in=in, .out=out, .fn_r=fn_r, .fn_rp=fn_rp, .fn_rpi=fn_rpi, .fn_ri=fn_ri,
+                      .param=param, .inplace=inplace};
+        size_t n = GSL_MAX(in->textsize[0], maxsize);
+        if (apop_opts.thread_count <= 1) rowloop(&rp, 0, n, 0);
+        else apop_pool_run(rowloop, &rp, n, apop_pool_chunk(n));
     } else {
         if (in->vector && (part == 'v' || part=='a'))
             mapply_core(NULL, in->vector, fn, out->vector, use_index, use_param, param, 'r');
@@ -283,41 +443,24 @@ static void *oldvectorloop(void *t){
     return NULL;
 }
 
-static size_t *threadminmax(const int threadno, const int totalct, const int threadct){
-    int segment_size = totalct/threadct;
-    size_t *out = malloc(sizeof(size_t)*3);
-    out[0] = threadno*segment_size;
-    out[1] = (threadno==threadct-1) ? totalct : (threadno+1)*segment_size;
-    out[2] = threadno;
-    return out;
+static void core_chunk(void *in, size_t lo, size_t hi, int worker){
+    threadpass tc = *(threadpass*)in;
+    size_t limlist[] = {lo, hi, worker};
+    tc.limlist = limlist;
+    if (tc.m) tc.rc ? forloop(&tc) : oldforloop(&tc);
+    else      tc.rc ? vectorloop(&tc) : oldvectorloop(&tc);
 }
 
 static gsl_vector*mapply_core(gsl_matrix *m, gsl_vector *vin, void *fn, gsl_vector *vout, int use_index, int use_param,void *param, char post_22){
-    int threadct = GSL_MIN((m? m->size1 : vin->size), apop_opts.thread_count);
-    pthread_t thread_id[threadct];
-    threadpass tp[threadct];
-    for (size_t i=0 ; i<threadct; i++)
-        tp[i] = (threadpass) {
-            .limlist   = threadminmax(i, 
-                    m? ((!post_22 || post_22 == 'r') ? m->size1 : m->size2) : vin->size ,threadct),
+    threadpass tp = (threadpass) {
             .fn = fn,   .m = m, 
             .vin = vin, .v = vout,
             .use_index = use_index, .use_param= use_param,
             .param = param, .rc = post_22
         };
-    if (threadct==1){ //don't thread.
-        if (m)  post_22 ? forloop(tp) : oldforloop(tp);
-        else    post_22 ? vectorloop(tp) : oldvectorloop(tp);
-    } else {
-        for (size_t i=0 ; i<threadct; i++){
-            if (m)  pthread_create(&thread_id[i], NULL,post_22 ? forloop : oldforloop,(tp+i));
-            else    pthread_create(&thread_id[i], NULL,post_22 ? vectorloop : oldvectorloop,(tp+i));
-        }
-        for (size_t i=0 ; i<threadct; i++)
-            pthread_join(thread_id[i], NULL);
-    }
-    for (size_t i=0 ; i<threadct; i++)
-        free(tp[i].limlist);
+    size_t n = m? ((!post_22 || post_22 == 'r') ? m->size1 : m->size2) : vin->size;
+    if (apop_opts.thread_count <= 1) core_chunk(&tp, 0, n, 0); //don't thread.
+    else apop_pool_run(core_chunk, &tp, n, apop_pool_chunk(n));
     return vout;
 }
 
@@ -329,7 +472,7 @@ There are two types, which were developed at different times. The \ref apop_map
 
 Here are a few technical details of usage:
 
-\li If \c apop_opts.thread_count is greater than one, then the matrix will be broken into chunks and each sent to a different thread. Notice that the GSL is generally threadsafe, and SQLite is threadsafe conditional on several commonsense caveats that you'll find in the SQLite documentation.
+\li If \c apop_opts.thread_count is greater than one, then the matrix will be broken into chunks and handed out to a pool of threads that persists across calls. Notice that the GSL is generally threadsafe, and SQLite is threadsafe conditional on several commonsense caveats that you'll find in the SQLite documentation.
 
 \li Apart from \ref apop_map_sum (which does minimal internal allocation), the \c ...sum functions are convenience functions that just call \c ...map and then add up the contents. Thus, you will need to have adequate memory for the allocation of the temp matrix/vector.
 \{ */
@@ -469,23 +612,57 @@ double apop_matrix_map_sum(const gsl_matrix *in, double (*fn)(gsl_vector*)){
     return out;
 }
 
-/*I abuse the macro system to do threading, because the variadic function takes
-     exactly one input, which is what the pthread_create function needs. The alternative,
-     writing a function to handle every argument to apop_map_sum to re-generate the
-     variadic_apop_map_sum_type struct, would be an uglier hack.
-
-     This function wraps variadic_apop_map_sum so that we're of the form pthread wants, void *(*)(void*),
-     instead of double (*)(variadic_type_apop_map_sum).  The main of
-     variadic_apop_map_sum just uses Apop_data_rows (and some abuse of that macro's
-     internals) to generate the subsets, then each thread calls this function to do the work.
+/* apop_map_sum sums over a range of rows (or columns, for part=='c') at a time. With
+   threads, each pooled chunk writes its subtotal to its own slot, and the slots are added
+   up in order, so the total doesn't depend on which thread ran which chunk. */
+typedef struct {
+    variadic_type_apop_map_sum *a;
+    double *sums;
+    size_t chunk;
+} sumpass;
+
+static double map_sum_range(variadic_type_apop_map_sum *a, size_t lo, size_t hi){
+    apop_data *in = a->in;
+    void *param = a->param;
+    Get_vmsizes(in);
+    double outsum = 0;
+    if (a->fn_r || a->fn_ri || a->fn_rpi || a->fn_rp)
+        for (size_t i=lo; i < hi; i++){
+            Apop_data_row(in, i, arow);
+            if (a->fn_r) outsum += a->fn_r(arow);
+            else if (a->fn_rp) outsum += a->fn_rp(arow, param);
+            else if (a->fn_ri) outsum += a->fn_ri(arow, i);
+            else            outsum += a->fn_rpi(arow, param, i);
+        }
+    else if (a->part =='m' || a->part == 'v' || a->part == 'a'){
+        if (a->part =='m') firstcol= 0; //don't traverse vector, even if present
+        if (a->part =='v') msize2= 0; //don't traverse matrix, even if present
+        for (size_t i=lo; i < hi; i++)
+            for (int j=firstcol; j < msize2; j++){
+                double val = apop_data_get(in, i, j);
+                if (a->fn_d) outsum += a->fn_d(val);
+                else if (a->fn_dp) outsum += a->fn_dp(val, param);
+                else if (a->fn_di) outsum += a->fn_di(val, i);
+                else            outsum += a->fn_dpi(val, param, i);
+            }
+    } else {
+        gsl_vector_view v;
+        for (size_t i=lo; i < hi; i++){
+            v = (a->part=='r')
+                ? gsl_matrix_row(in->matrix, i)
+                : gsl_matrix_column(in->matrix, i);
+            if       (a->fn_v)  outsum += a->fn_v(&v.vector);
+            else if (a->fn_vp)  outsum += a->fn_vp(&v.vector, param);
+            else if (a->fn_vi)  outsum += a->fn_vi(&v.vector, i);
+            else             outsum += a->fn_vpi(&v.vector, param, i);
+        }
+    }
+    return outsum;
+}
 
-     How does apop_map_sum know if it's in the middle of a thread? I add 1000 to the all_pages integer. 
-     If threadct =0 or all_pages >=1000, then process as normal.
-*/
-void *apop_map_sum_for_threading(void *in){
-    double *val = malloc(sizeof(double));
-    *val = variadic_apop_map_sum(*(variadic_type_apop_map_sum*)in);
-    return val;
+static void sum_chunk(void *in, size_t lo, size_t hi, int worker){
+    sumpass *sp = in;
+    sp->sums[lo/sp->chunk] = map_sum_range(sp->a, lo, hi);
 }
 
 /** A function that effectively calls \ref apop_map and returns the sum of the resulting elements. Thus, this function returns a single \c double. See the \ref apop_map page for details of the inputs, which are the same here, except that \c inplace doesn't make sense---this function will always just add up the input function outputs.
@@ -496,52 +673,8 @@ void *apop_map_sum_for_threading(void *in){
  \ingroup mapply
  */
 APOP_VAR_HEAD double apop_map_sum(apop_data *in, apop_fn_d *fn_d, apop_fn_v *fn_v, apop_fn_r *fn_r, apop_fn_dp *fn_dp, apop_fn_vp *fn_vp, apop_fn_rp *fn_rp, apop_fn_dpi *fn_dpi,  apop_fn_vpi *fn_vpi, apop_fn_rpi *fn_rpi, apop_fn_di *fn_di, apop_fn_vi *fn_vi, apop_fn_ri *fn_ri, void *param, char part, int all_pages){ 
-
-    //The first half of the wrapper function is about threading. See notes attached to apop_map_sum_for_threading.
-    int threadct = GSL_MIN((varad_in.in->matrix? varad_in.in->matrix->size1 : varad_in.in->vector->size), apop_opts.thread_count);
-    if (threadct > 1 && varad_in.all_pages <1000){
-        pthread_t     thread_id[threadct];
-        variadic_type_apop_map_sum inputs[threadct];
-        apop_data slices[threadct];
-        gsl_vector v[threadct], w[threadct];
-        gsl_matrix m[threadct];
-        Get_vmsizes(varad_in.in);
-        int totalct = GSL_MAX(vsize, GSL_MAX(msize1, varad_in.in->textsize[0]));
-        int segment_size  = totalct/threadct;
-        for (int i=0 ; i<threadct; i++){
-            inputs[i] = varad_in;
-            /*Copy the inputs, use Apop_data_rows to get slices, use all_pages to mark that this is
-            in-thread processing, then run this function on the subsetted copy of the inputs.  
-            The tedium is in copying the substructures (but not data) so they persist past the loop. */
-            int bottom=i*segment_size;
-            Apop_data_rows(varad_in.in, bottom, i==threadct-1 ? totalct-bottom : segment_size, somerows);
-            slices[i] = *somerows; //copy the struct, because on the next loop it'll be different.
-            v[i] = somerows->vector ? *(somerows->vector): (gsl_vector){};
-            w[i] = somerows->weights ? *(somerows->weights): (gsl_vector){};
-            m[i] = somerows->matrix ? *(somerows->matrix): (gsl_matrix){};
-            slices[i].vector = somerows->vector ? &v[i] : 0;
-            slices[i].weights = somerows->weights ? &w[i] : 0;
-            slices[i].matrix = somerows->matrix ?&m[i] : 0;
-            inputs[i].in = slices+i;
-            inputs[i].all_pages = varad_in.all_pages+1000;
-            pthread_create(&thread_id[i], NULL, apop_map_sum_for_threading, inputs+i);
-        }
-        double sum = 0;
-        void *partsum;
-        for (int i=0 ; i<threadct; i++){
-            pthread_join(thread_id[i], &partsum);
-//printf("part %i: %g\n", i, *(double*)partsum);
-//apop_data_show(slices+i);
-            sum+= *(double*)partsum;
-            free(partsum);
-        }
-
-        inputs[0].in = varad_in.in->more;
-        inputs[0].all_pages -= 1000;
-        return sum + (((varad_in.all_pages=='y' || varad_in.all_pages=='Y') && varad_in.in->more) ? variadic_apop_map_sum(inputs[0]): 0);
-    }
-
     apop_data * apop_varad_var(in, NULL)
+    if (!in) return 0;
     apop_fn_v * apop_varad_var(fn_v, NULL)
     apop_fn_d * apop_varad_var(fn_d, NULL)
     apop_fn_r * apop_varad_var(fn_r, NULL)
@@ -556,48 +689,120 @@ APOP_VAR_HEAD double apop_map_sum(apop_data *in, apop_fn_d *fn_d, apop_fn_v *fn_
     apop_fn_ri * apop_varad_var(fn_ri, NULL)
     void * apop_varad_var(param, NULL)
     char apop_varad_var(part, ((fn_v||fn_vp||fn_vpi||fn_vi) ? 'r' : 'a'));
-    if (varad_in.all_pages >= 1000) varad_in.all_pages -= 1000;
     int apop_varad_var(all_pages, 'n')
 APOP_VAR_ENDHEAD 
     Get_vmsizes(in);
-    double outsum = 0;
+    size_t n;
     if (fn_r || fn_ri || fn_rpi || fn_rp)
-        for (int i=0; i < GSL_MAX(maxsize, in->textsize[0]); i++){
-            Apop_data_row(in, i, arow);
-            if (fn_r) outsum += fn_r(arow);
-            else if (fn_rp) outsum += fn_rp(arow, param);
-            else if (fn_ri) outsum += fn_ri(arow, i);
-            else            outsum += fn_rpi(arow, param, i);
-        }
-    else {
-        if (part =='m' || part == 'v' || part == 'a'){
+        n = GSL_MAX(maxsize, in->textsize[0]);
+    else if (part =='m' || part == 'v' || part == 'a'){
         apop_assert(fn_d || fn_dp || fn_di || fn_dpi, "You specified .part='a', which means I need one of .fn_d, .fn_dp, .fn_di, or .fn_dpi specified");
-        if (part =='m') firstcol= 0; //don't traverse vector, even if present
-        if (part =='v') msize2= 0; //don't traverse matrix, even if present
-        for (int i=0; i < GSL_MAX(vsize, msize1); i++)
-            for (int j=firstcol; j < msize2; j++){
-                double val = apop_data_get(in, i, j);
-                if (fn_d) outsum += fn_d(val);
-                else if (fn_dp) outsum += fn_dp(val, param);
-                else if (fn_di) outsum += fn_di(val, i);
-                else            outsum += fn_dpi(val, param, i);
-            }
-        } else if (part =='r' ||part =='c'){
-            apop_assert(fn_v || fn_vp || fn_vi || fn_vpi, "You specified .part='a', which means I need one of .fn_v, .fn_vp, .fn_vi, or .fn_vpi specified");
-            long int max = (part=='r') ? msize1 : msize2;
-            gsl_vector_view v;
-            for (int i=0; i < max; i++){
-                v = (part=='r')
-                    ? gsl_matrix_row(in->matrix, i)
-                    : gsl_matrix_column(in->matrix, i);
-                if       (fn_v)  outsum += fn_v(&v.vector);
-                else if (fn_vp)  outsum += fn_vp(&v.vector, param);
-                else if (fn_vi)  outsum += fn_vi(&v.vector, i);
-                else             outsum += fn_vpi(&v.vector, param, i);
-            }
-        }
+        n = GSL_MAX(vsize, msize1);
+    } else if (part =='r' ||part =='c'){
+        apop_assert(fn_v || fn_vp || fn_vi || fn_vpi, "You specified .part='a', which means I need one of .fn_v, .fn_vp, .fn_vi, or .fn_vpi specified");
+        n = (part=='r') ? msize1 : msize2;
+    } else n = 0;
+
+    variadic_type_apop_map_sum a = {.in=in, .fn_d=fn_d, .fn_v=fn_v, .fn_r=fn_r, .fn_dp=fn_dp,
+                .fn_vp=fn_vp, .fn_rp=fn_rp, .fn_dpi=fn_dpi, .fn_vpi=fn_vpi, .fn_rpi=fn_rpi,
+                .fn_di=fn_di, .fn_vi=fn_vi, .fn_ri=fn_ri, .param=param, .part=part};
+    double outsum = 0;
+    if (apop_opts.thread_count <= 1 || n < 2) outsum = map_sum_range(&a, 0, n);
+    else {
+        size_t chunk = apop_pool_chunk(n), chunk_ct = (n + chunk - 1)/chunk;
+        double sums[chunk_ct];
+        apop_pool_run(sum_chunk, &(sumpass){.a=&a, .sums=sums, .chunk=chunk}, n, chunk);
+        for (size_t c=0; c< chunk_ct; c++) outsum += sums[c];
     }
-        return outsum + 
-                    (((all_pages=='y' || all_pages=='Y') && in->more) ? apop_map_sum_base(in->more, fn_d, fn_v, fn_r, fn_dp, fn_vp, fn_rp, fn_dpi, fn_vpi, fn_rpi, fn_di, fn_vi, fn_ri, param, part, all_pages) : 0);
+    return outsum + 
+                (((all_pages=='y' || all_pages=='Y') && in->more) ? apop_map_sum_base(in->more, fn_d, fn_v, fn_r, fn_dp, fn_vp, fn_rp, fn_dpi, fn_vpi, fn_rpi, fn_di, fn_vi, fn_ri, param, part, all_pages) : 0);
+}
+/* apop_dot_map_sum finds X beta a tile of rows at a time, small enough that the tile of
+   X and its product stay in cache, hands each row of the product to the row function,
+   and keeps a running sum. Each chunk (of apop_pool_fixed_chunk rows, even when not
+   threaded) writes its subtotal and its accumulator to its own slot, and the slots are
+   added up in order. */
+typedef struct {
+    gsl_matrix const *x, *beta;
+    apop_fn_xb *fn;
+    void *param;
+    long double *sums;
+    gsl_matrix *accs;   //one row per chunk, or NULL.
+    size_t chunk, tile;
+} dotsumpass;
+
+static void dot_sum_chunk(void *in, size_t lo, size_t hi, int worker){
+    dotsumpass *dp = in;
+    size_t slot = lo/dp->chunk, cols = dp->beta->size2;
+    double *acc = dp->accs ? gsl_matrix_ptr(dp->accs, slot, 0) : NULL;
+    gsl_matrix *xb = gsl_matrix_alloc(GSL_MIN(dp->tile, hi-lo), cols);
+    long double outsum = 0;
+    for (size_t t=lo; t < hi; t+= dp->tile){
+        size_t rows = GSL_MIN(dp->tile, hi-t);
+        gsl_matrix_const_view xtile = gsl_matrix_const_submatrix(dp->x, t, 0, rows, dp->x->size2);
+        gsl_matrix_view xbtile = gsl_matrix_submatrix(xb, 0, 0, rows, cols);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, &xtile.matrix, dp->beta, 0, &xbtile.matrix);
+        for (size_t i=0; i < rows; i++)
+            outsum += dp->fn(gsl_matrix_ptr(xb, i, 0), t+i, dp->param, acc);
     }
+    gsl_matrix_free(xb);
+    dp->sums[slot] = outsum;
+}
+
+/** Find \f$x_i\beta\f$ for every row \f$i\f$ of \c x, send each to a function, and return
+the sum of the function's outputs. This is the core of many a log likelihood: it is
+equivalent to <tt>apop_map_sum(apop_dot(x, beta), .fn_rpi=...)</tt>, but never writes
+down the full \f$X\beta\f$ matrix. Rows are multiplied a cache-sized tile at a time, via
+one matrix-matrix product per tile, and the tiles are split among threads given <tt>\ref
+apop_opts_type "apop_opts".thread_count > 1</tt>.
+
+\param x The data, one observation per row.
+\param beta The parameters, with as many rows as \c x has columns. For a single parameter
+vector, use <tt>gsl_matrix_view_vector(v, v->size, 1)</tt>.
+\param fn A function with the header <tt>double fn(double const *xb, size_t row, void
+*param, double *acc)</tt>. It is sent the row of \f$X\beta\f$ (with <tt>beta->size2</tt>
+elements), the row number, which you can use to look up the outcome or the row of \c x,
+your \c param, and a scratch accumulator, to which you can add (never assign) other
+per-row quantities like a gradient. It returns the term to be added to the sum.
+\param param A pointer to anything, passed to \c fn.
+\param acc If not \c NULL, set to the sum of all the increments \c fn made to its
+accumulator. Each thread gets its own zeroed accumulator of <tt>acc->size</tt>
+elements. If \c NULL, \c fn is sent \c NULL.
+
+\return The sum of <tt>fn</tt>'s outputs over all rows. The rows are summed in chunks whose
+size depends only on the row count, each chunk's subtotal is kept separately, and the
+subtotals are added in order, so the result is the same at any thread count.
+
+\li Your function will be run in parallel given multiple threads, so it should not write
+to any shared memory other than its accumulator and memory owned by its row, like
+element \c row of a vector of per-row outputs. Each row is handled exactly once, so
+such writes never collide.
+\ingroup mapply
+*/
+double apop_dot_map_sum(gsl_matrix const *x, gsl_matrix const *beta, apop_fn_xb *fn, void *param, gsl_vector *acc){
+    Apop_stopif(!x || !beta || !fn, return GSL_NAN, 0, "I need a data matrix, a parameter matrix, and a function.");
+    Apop_stopif(x->size2 != beta->size1, return GSL_NAN, 0, "The data has %zu columns but "
+            "the parameter matrix has %zu rows.", x->size2, beta->size1);
+    if (acc) gsl_vector_set_all(acc, 0);
+    size_t n = x->size1;
+    if (!n) return 0;
+    size_t chunk = apop_pool_fixed_chunk(n), chunk_ct = (n + chunk - 1)/chunk;
+    long double sums[chunk_ct];
+    dotsumpass dp = {.x=x, .beta=beta, .fn=fn, .param=param, .sums=sums, .chunk=chunk,
+                     .tile=GSL_MAX(16, (32768/sizeof(double))/(x->size2 + beta->size2)),
+                     .accs= acc ? gsl_matrix_calloc(chunk_ct, acc->size) : NULL};
+    if (apop_opts.thread_count <= 1)
+        for (size_t lo=0; lo< n; lo+=chunk) dot_sum_chunk(&dp, lo, GSL_MIN(n, lo+chunk), 0);
+    else apop_pool_run(dot_sum_chunk, &dp, n, chunk);
+    long double outsum = 0;
+    for (size_t c=0; c< chunk_ct; c++){
+        outsum += sums[c];
+        if (acc){
+            Apop_matrix_row(dp.accs, c, oneacc);
+            gsl_vector_add(acc, oneacc);
+        }
+    }
+    if (dp.accs) gsl_matrix_free(dp.accs);
+    return outsum;
+}
 /** \} */
@@ -36,6 +36,7 @@ typedef struct {
     FILE        **trace_file;
     double      best_ll;
     char        want_cov, want_predicted, want_tests, want_info;
+    char        in_multistart; //if 'y', the multistart driver owns the SIGINT handler.
     jmp_buf     bad_eval_jump;
 }   infostruct;
 
@@ -86,6 +87,11 @@ Apop_settings_init(apop_mle,
     Apop_varad_set(want_cov, 'y');
     if (in.want_cov == 1) out->want_cov = 'y';
     Apop_varad_set(dim_cycle_tolerance, 0);
+    Apop_varad_set(deriv_method, 'c');
+    Apop_varad_set(threaded_derivs, 'n');
+    Apop_varad_set(start_count, 1);
+    Apop_varad_set(start_model, NULL);
+    Apop_varad_set(start_spread, 1);
 //siman:
     //siman also uses step_size  = 1.;  
     Apop_varad_set(n_tries, 5);  //The number of points to try for each step. 
@@ -119,26 +125,80 @@ static double one_d(double b, void *in){
 
 //Numeric first and second derivatives.
 
-/* For each element of the parameter set, jiggle it to find its
- gradient. Return a vector as long as the parameter list. */
-static void apop_internal_numerical_gradient(apop_fn_with_params ll, 
-                            infostruct* info, gsl_vector *out, double delta){
+/* The derivative along dimension j at beta. For the forward difference, f0 is the
+   value at beta itself, which the caller calculates once for all dimensions. */
+static double one_partial(infostruct *i, gsl_vector *beta, size_t j, double delta, char method, double f0){
     double result, err;
-    gsl_vector *beta = apop_data_pack(info->model->parameters, NULL, .all_pages='y');
-    infostruct i = *info;
-    i.f = &ll;
-    i.gp = &(grad_params){ .beta = gsl_vector_alloc(beta->size)};
     gsl_function F = { .function= one_d, 
-                       .params	= &i };
-	for (size_t j=0; j< beta->size; j++){
-		i.gp->dimension = j;
-		gsl_vector_memcpy(i.gp->beta, beta);
-		gsl_deriv_central(&F, gsl_vector_get(beta,j), delta, &result, &err);
-		gsl_vector_set(out, j, result);
-	}
+                       .params	= i };
+    i->gp->dimension = j;
+    gsl_vector_memcpy(i->gp->beta, beta);
+    if (method == 'f')
+        return (one_d(gsl_vector_get(beta,j) + delta, i) - f0)/delta;
+    gsl_deriv_central(&F, gsl_vector_get(beta,j), delta, &result, &err);
+    return result;
+}
+
+typedef struct {
+    infostruct i;
+    gsl_vector *beta, *out;
+    size_t lo, hi;
+    double delta, f0;
+    char method;
+} grad_pass;
+
+static void *grad_loop(void *in){
+    grad_pass *g = in;
+    for (size_t j=g->lo; j< g->hi; j++)
+        gsl_vector_set(g->out, j, one_partial(&g->i, g->beta, j, g->delta, g->method, g->f0));
+    return NULL;
+}
+
+/* For each element of the parameter set, jiggle it to find its
+ gradient. Return a vector as long as the parameter list. 
+ With threadct > 1, each thread takes a block of dimensions and works on its own copy
+ of the model. The model's parameters are reset to beta on the way out. */
+static void apop_internal_numerical_gradient(apop_fn_with_params ll, infostruct* info, 
+                            gsl_vector *out, double delta, char method, int threadct){
+    gsl_vector *beta = apop_data_pack(info->model->parameters, NULL, .all_pages='y');
+    threadct = GSL_MAX(1, GSL_MIN(threadct, beta->size));
+    pthread_t thread_id[threadct];
+    grad_pass gp[threadct];
+    for (int t=0; t< threadct; t++){
+        gp[t] = (grad_pass){.i=*info, .beta=beta, .out=out, .delta=delta, .method=method,
+                        .lo = t*beta->size/threadct, .hi = (t+1)*beta->size/threadct};
+        gp[t].i.f = &ll;
+        gp[t].i.gp = malloc(sizeof(grad_params));
+        *gp[t].i.gp = (grad_params){ .beta = gsl_vector_alloc(beta->size)};
+        if (t) gp[t].i.model = apop_model_copy(*info->model);
+    }
+    if (method == 'f'){
+        gp->i.gp->dimension = 0;
+        gsl_vector_memcpy(gp->i.gp->beta, beta);
+        double f0 = one_d(gsl_vector_get(beta, 0), &gp->i);
+        for (int t=0; t< threadct; t++) gp[t].f0 = f0;
+    }
+    if (threadct==1) grad_loop(gp);
+    else {
+        for (int t=0; t< threadct; t++)
+            pthread_create(&thread_id[t], NULL, grad_loop, gp+t);
+        for (int t=0; t< threadct; t++)
+            pthread_join(thread_id[t], NULL);
+    }
+    for (int t=0; t< threadct; t++){
+        if (t) apop_model_free(gp[t].i.model);
+        gsl_vector_free(gp[t].i.gp->beta);
+        free(gp[t].i.gp);
+    }
+    apop_data_unpack(beta, info->model->parameters);
     gsl_vector_free(beta);
 }
 
+//How many threads should the derivative routines use, given the model's settings?
+static int deriv_threads(apop_mle_settings *mp){
+    return (mp && mp->threaded_derivs == 'y') ? apop_opts.thread_count : 1;
+}
+
 /**The GSL provides one-dimensional numerical differentiation; here's the multidimensional extension.
 
 \param data The data set to use for all evaluations. It remains constant throughout.
@@ -150,6 +210,9 @@ static void apop_internal_numerical_gradient(apop_fn_with_params ll,
  gsl_vector *gradient = apop_numerical_gradient(data, your_parametrized_model);
  \endcode
 
+\li If the model has an \ref apop_mle_settings group, I use its \c deriv_method to pick
+the central- or forward-difference stencil, and if its \c threaded_derivs is \c 'y',
+I split the dimensions among <tt>apop_opts.thread_count</tt> threads.
 \li This function uses the \ref designated syntax for inputs.
 \ingroup linear_algebra
  */
@@ -166,38 +229,82 @@ APOP_VAR_ENDHEAD
   Get_vmsizes(model->parameters); //tsize
   apop_fn_with_params ll  = model->log_likelihood ? model->log_likelihood : model->p;
   Apop_stopif(!ll, return 0, 0, "Input model has neither p nor log_likelihood method. Returning zero.");
+  apop_mle_settings *mp = apop_settings_get_group(model, apop_mle);
   gsl_vector        *out= gsl_vector_alloc(tsize);
   infostruct    i = (infostruct) {.model = model, .data = data};
-    apop_internal_numerical_gradient(ll, &i, out, delta);
+    apop_internal_numerical_gradient(ll, &i, out, delta, mp ? mp->deriv_method : 'c', deriv_threads(mp));
     return out;
 }
 
+/* The Hessian is the gradient of the score. This model's log likelihood is one element
+   of the base model's score: either via the base model's score function, or the
+   numerical derivative along that one dimension alone. Every thread has its own copy
+   of this struct, so there is no state shared among threads. */
 typedef struct {
     apop_model *base_model;
     int *current_index;
+    gsl_vector *score;
+    double delta;
+    char method;
 } apop_model_for_infomatrix_struct;
 
 static double apop_fn_for_infomatrix(apop_data *d, apop_model *m){
-    static gsl_vector *v = NULL;
     apop_model_for_infomatrix_struct *settings = m->more;
     apop_model *mm = settings->base_model;
     if (mm->score){
-        if (!v || v->size != mm->parameters->vector->size){
-            if (v) gsl_vector_free(v);
-            v = gsl_vector_alloc(mm->parameters->vector->size);
-        }
-         mm->score(d, v, mm);
-        return gsl_vector_get(v, *settings->current_index);
+        mm->score(d, settings->score, mm);
+        return gsl_vector_get(settings->score, *settings->current_index);
     } //else:
-        gsl_vector *vv = apop_numerical_gradient(d, mm);
-        double out = gsl_vector_get(vv, *settings->current_index);
-        gsl_vector_free(vv);
-        return out;
+    apop_fn_with_params ll = mm->log_likelihood ? mm->log_likelihood : mm->p;
+    infostruct i = (infostruct) {.model = mm, .data = d, .f = &ll};
+    gsl_vector *beta = apop_data_pack(mm->parameters, NULL, .all_pages='y');
+    i.gp = &(grad_params){ .beta = gsl_vector_alloc(beta->size)};
+    double f0 = 0;
+    if (settings->method == 'f'){
+        gsl_vector_memcpy(i.gp->beta, beta);
+        f0 = one_d(gsl_vector_get(beta, 0), &i);
+    }
+    double out = one_partial(&i, beta, *settings->current_index, settings->delta, settings->method, f0);
+    apop_data_unpack(beta, mm->parameters);
+    gsl_vector_free(i.gp->beta);
+    gsl_vector_free(beta);
+    return out;
 }
 
 apop_model apop_model_for_infomatrix = {"Ad hoc model for working out the information matrix.", 
                                                 .log_likelihood = apop_fn_for_infomatrix};
 
+typedef struct {
+    apop_data *data;
+    apop_model *model;
+    gsl_matrix *grads;
+    size_t lo, hi;
+    double delta;
+    char method;
+} hessian_pass;
+
+//Row k of grads is the gradient of the kth element of the score.
+static void *hessian_loop(void *in){
+    hessian_pass *h = in;
+    int k;
+    size_t betasize = h->grads->size1;
+    apop_model_for_infomatrix_struct ms = { .base_model = h->model, .current_index = &k,
+                .score = gsl_vector_alloc(betasize), .delta = h->delta, .method = h->method};
+    apop_model *m = apop_model_copy(apop_model_for_infomatrix);
+    m->parameters = h->model->parameters;
+    m->more = &ms;
+    infostruct i = (infostruct) {.model = m, .data = h->data};
+    for (k=h->lo; k< h->hi; k++){
+        Apop_matrix_row(h->grads, k, dscore);
+        apop_internal_numerical_gradient(apop_fn_for_infomatrix, &i, dscore, h->delta, h->method, 1);
+    }
+    m->parameters = NULL;
+    m->more = NULL;
+    apop_model_free(m);
+    gsl_vector_free(ms.score);
+    return NULL;
+}
+
 /** Numerically estimate the matrix of second derivatives of the
 parameter values. The math is
  simply a series of re-evaluations at small differential steps. [Therefore, it may be expensive to do this for a very computationally-intensive model.]  
@@ -207,6 +314,9 @@ parameter values. The math is
 \param delta the step size for the differentials. The current default is around 1e-3.
 \return The matrix of estimated second derivatives at the given data and parameter values.
  
+\li If the model has an \ref apop_mle_settings group, I use its \c deriv_method to pick
+the central- or forward-difference stencil, and if its \c threaded_derivs is \c 'y',
+the rows of the Hessian are split among <tt>apop_opts.thread_count</tt> threads, each with its own copy of the model.
 \li This function uses the \ref designated syntax for inputs.
  */
 APOP_VAR_HEAD apop_data * apop_model_hessian(apop_data * data, apop_model *model, double delta){
@@ -219,27 +329,33 @@ APOP_VAR_HEAD apop_data * apop_model_hessian(apop_data * data, apop_model *model
         delta = mp ? mp->delta : default_delta;
     }
 APOP_VAR_ENDHEAD
-    int    k;
     Get_vmsizes(model->parameters) //tsize
     size_t betasize  = tsize;
+    apop_mle_settings *mp = apop_settings_get_group(model, apop_mle);
+    int threadct = GSL_MAX(1, GSL_MIN(deriv_threads(mp), betasize));
     apop_data *out    = apop_data_calloc(0, betasize, betasize);
-    gsl_vector *dscore = gsl_vector_alloc(betasize);
-    apop_model_for_infomatrix_struct ms = { .base_model = model, .current_index = &k, };
-    apop_model *m = apop_model_copy(apop_model_for_infomatrix);
-    m->parameters = model->parameters;
-    m->more = &ms;
-    if (apop_settings_get_group(model, apop_mle))
-        apop_settings_copy_group(m, model, "apop_mle");
-    for (k=0; k< betasize; k++){
-        dscore = apop_numerical_gradient(data, m, delta);
-        //We get two estimates of the (k,j)th element, which are often very close,
-        //and take the mean.
-        for (size_t j=0; j< betasize; j++){
-            apop_matrix_increment(out->matrix, k, j, gsl_vector_get(dscore, j)/2);
-            apop_matrix_increment(out->matrix, j, k, gsl_vector_get(dscore, j)/2);
-        }
-        gsl_vector_free(dscore);
+    gsl_matrix *grads = gsl_matrix_alloc(betasize, betasize);
+    pthread_t thread_id[threadct];
+    hessian_pass hp[threadct];
+    for (int t=0; t< threadct; t++)
+        hp[t] = (hessian_pass){.data=data, .grads=grads, .delta=delta,
+                    .method = mp ? mp->deriv_method : 'c',
+                    .model = t ? apop_model_copy(*model) : model,
+                    .lo = t*betasize/threadct, .hi = (t+1)*betasize/threadct};
+    if (threadct==1) hessian_loop(hp);
+    else {
+        for (int t=0; t< threadct; t++)
+            pthread_create(&thread_id[t], NULL, hessian_loop, hp+t);
+        for (int t=0; t< threadct; t++)
+            pthread_join(thread_id[t], NULL);
     }
+    for (int t=1; t< threadct; t++) apop_model_free(hp[t].model);
+    //We get two estimates of the (k,j)th element, which are often very close,
+    //and take the mean.
+    for (size_t k=0; k< betasize; k++)
+        for (size_t j=0; j< betasize; j++)
+            gsl_matrix_set(out->matrix, k, j, gsl_matrix_get(grads, k, j)/2 + gsl_matrix_get(grads, j, k)/2);
+    gsl_matrix_free(grads);
     if (model->parameters->names->row){
         apop_name_stack(out->names, model->parameters->names, 'r');
         apop_name_stack(out->names, model->parameters->names, 'c', 'r');
@@ -392,7 +508,7 @@ Finally, reverse the sign, since the GSL is trying to minimize instead of maximi
         i->model->score(i->data, g, i->model);
     else {
         apop_fn_with_params ll  = i->model->log_likelihood ? i->model->log_likelihood : i->model->p;
-        apop_internal_numerical_gradient(ll, i, g, mp->delta);
+        apop_internal_numerical_gradient(ll, i, g, mp->delta, mp->deriv_method, deriv_threads(mp));
     }
     if (i->trace_path && strlen(i->trace_path))
         negshell (beta,  in);
@@ -406,8 +522,8 @@ static void fdf_shell(const gsl_vector *beta, void *i, double *f, gsl_vector *df
     dnegshell(beta, i, df);
 }
 
-static int ctrl_c;
-static void mle_sigint(){ ctrl_c ++; }
+static volatile sig_atomic_t ctrl_c;
+static void mle_sigint(){ ctrl_c = 1; }
 
 static int setup_starting_point(apop_mle_settings *mp, gsl_vector *x){
     Apop_stopif(!x, return -1, 0, "The vector I'm trying to optimize over is NULL.");
@@ -480,9 +596,12 @@ Inside the infostruct, you'll find these elements:
         .fdf	= (apop_fdf_with_void) fdf_shell,
         .n		= betasize,
         .params	= i};
-    ctrl_c = 0;
+    void (*prior_handler)(int) = NULL;
+    if (i->in_multistart != 'y'){
+        ctrl_c = 0;
+        prior_handler = signal(SIGINT, mle_sigint);
+    }
 	gsl_multimin_fdfminimizer_set (s, &minme, i->beta, mp->step_size, mp->tolerance);
-    signal(SIGINT, mle_sigint);
     do { 	
         iter++;
         if (setjmp(i->bad_eval_jump)) {
@@ -499,7 +618,7 @@ Inside the infostruct, you'll find these elements:
             printf ("%5i %.5f  f()=%10.5f gradient=%.3f\n", iter, gsl_vector_get (s->x, 0),  s->f, gsl_vector_get(s->gradient,0));
         Apop_stopif(status == GSL_SUCCESS, apopstatus=0, 2, "Optimum found.");
     } while (status == GSL_CONTINUE && iter < mp->max_iterations && !ctrl_c);
-    signal(SIGINT, NULL);
+    if (i->in_multistart != 'y') signal(SIGINT, prior_handler);
 	Apop_stopif(iter==mp->max_iterations, apopstatus = -1, 1, "Max iterations reached, implying that I did not find an optimum.");
 	//Clean up, copy results to output estimate.
     apop_data_unpack(s->x, est->parameters);
@@ -523,13 +642,16 @@ static apop_model *	apop_maximum_likelihood_no_d(apop_data * data, infostruct *
     double size;
     s = gsl_multimin_fminimizer_alloc(gsl_multimin_fminimizer_nmsimplex, betasize);
     ss = gsl_vector_alloc(betasize);
-    ctrl_c      =
     apopstatus = 0; //assume failure until we score a success.
     gsl_vector_set_all (ss,  mp->step_size);
     gsl_multimin_function  minme = {.f = negshell, .n= betasize, .params = i};
     gsl_multimin_fminimizer_set (s, &minme, i->beta,  ss);
     //i->beta = s->x;
-    signal(SIGINT, mle_sigint);
+    void (*prior_handler)(int) = NULL;
+    if (i->in_multistart != 'y'){
+        ctrl_c = 0;
+        prior_handler = signal(SIGINT, mle_sigint);
+    }
     do {  
         iter++;
         if (setjmp(i->bad_eval_jump)) {
@@ -554,12 +676,14 @@ static apop_model *	apop_maximum_likelihood_no_d(apop_data * data, infostruct *
             }
         }
     } while (status == GSL_CONTINUE && iter < mp->max_iterations && !ctrl_c);
-    signal(SIGINT, NULL);
+    if (i->in_multistart != 'y') signal(SIGINT, prior_handler);
 	Apop_stopif(iter == mp->max_iterations && mp->verbose, /*continue*/, 
                 1, "Optimization reached maximum number of iterations.");
     if (status == GSL_SUCCESS) apopstatus = 0;
     apop_data_unpack(s->x, est->parameters);
 	gsl_multimin_fminimizer_free(s);
+    gsl_vector_free(ss);
+    gsl_vector_free(i->beta);
     auxinfo(est->parameters, i, apopstatus, i->best_ll);
 	return est;
 }
@@ -575,6 +699,8 @@ static double get_ll(apop_data *d, apop_model *est){
     return apop_log_likelihood(d, est);
 }
 
+static apop_model *mle_dispatch(apop_data *data, apop_model *dist, char in_multistart);
+
 static apop_model * dim_cycle(apop_data *d, apop_model *est, infostruct info){
     double last_ll, this_ll = GSL_NEGINF;
     int iteration = 0;
@@ -594,7 +720,7 @@ static apop_model * dim_cycle(apop_data *d, apop_model *est, infostruct info){
             apop_data_unpack(info.beta, est->parameters);
             apop_model *m_onedim = apop_model_fix_params(est);
             apop_prep(d, m_onedim);
-            apop_maximum_likelihood(d, m_onedim);
+            mle_dispatch(d, m_onedim, info.in_multistart);
             gsl_vector_set(info.beta, i, m_onedim->parameters->vector->data[0]);
             apop_model *full_est = apop_model_fix_params_get_base(m_onedim);//points to est, but filled.
             this_ll = get_ll(d, full_est);//only used on the last iteration.
@@ -621,6 +747,149 @@ void get_desires(apop_model *m, infostruct *info){
     info->want_predicted = (want && want->predicted =='y') ? 'y' : 'n';
 }
 
+typedef struct {
+    apop_data *d;
+    apop_model **starts;
+    int lo, hi;
+} start_pass;
+
+static void *start_loop(void *in){
+    start_pass *sp = in;
+    for (int i=sp->lo; i< sp->hi; i++)
+        mle_dispatch(sp->d, sp->starts[i], 'y');
+    return NULL;
+}
+
+static double start_ll(apop_data *d, apop_model *m){
+    if (m->info){
+        int index = apop_name_find(m->info->names, "log likelihood", 'r');
+        if (index>-2) return apop_data_get(m->info, index);
+    }
+    return apop_log_likelihood(d, m);
+}
+
+/* Run one search per starting point, each on its own copy of the model, then keep
+   the best. The copies only report their info page; covariance and tests, if wanted,
+   are done once on the winner. */
+static apop_model *multistart(apop_data *data, apop_model *dist, apop_mle_settings *mp){
+    int start_ct = mp->start_count;
+    infostruct info = {.model=dist};
+    get_desires(dist, &info);
+    gsl_vector *beta0 = apop_data_pack(dist->parameters, NULL, .all_pages='y');
+    Apop_stopif(setup_starting_point(mp, beta0), gsl_vector_free(beta0); dist->error='p'; return dist,
+                0, "Couldn't set up the starting point for the multistart search.");
+    int k = beta0->size;
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_alloc(apop_opts.rng_seed++);
+    apop_model **starts = malloc(sizeof(apop_model*)*start_ct);
+    double **start_pts = malloc(sizeof(double*)*start_ct);
+    for (int i=0; i< start_ct; i++){
+        start_pts[i] = malloc(sizeof(double)*k);
+        if (!i) memcpy(start_pts[i], beta0->data, sizeof(double)*k);
+        else if (mp->start_model) apop_draw(start_pts[i], r, mp->start_model);
+        else for (int j=0; j< k; j++)
+            start_pts[i][j] = beta0->data[j] + gsl_ran_gaussian(r, mp->start_spread);
+        starts[i] = apop_model_copy(*dist);
+        apop_data_free(starts[i]->info);
+        starts[i]->info = NULL;
+        Apop_model_add_group(starts[i], apop_parts_wanted, .info='y');
+        Apop_settings_set(starts[i], apop_mle, start_count, 1);
+        Apop_settings_set(starts[i], apop_mle, starting_pt, start_pts[i]);
+    }
+    if (!mp->rng) gsl_rng_free(r);
+    gsl_vector_free(beta0);
+
+    /* One SIGINT handler for all the starts, installed and restored here; the searches
+       (maybe in other threads) just watch ctrl_c. */
+    ctrl_c = 0;
+    void (*prior_handler)(int) = signal(SIGINT, mle_sigint);
+
+    //annealing and the trace file both use file-level state, so run those serially.
+    int threadct = (mp->method == APOP_SIMAN || mp->trace_path) ? 1
+                        : GSL_MAX(1, GSL_MIN(start_ct, apop_opts.thread_count));
+    start_pass sp[threadct];
+    pthread_t thread_id[threadct];
+    for (int t=0; t< threadct; t++)
+        sp[t] = (start_pass){.d=data, .starts=starts, .lo=t*start_ct/threadct, .hi=(t+1)*start_ct/threadct};
+    if (threadct==1) start_loop(sp);
+    else {
+        for (int t=0; t< threadct; t++) pthread_create(&thread_id[t], NULL, start_loop, sp+t);
+        for (int t=0; t< threadct; t++) pthread_join(thread_id[t], NULL);
+    }
+    signal(SIGINT, prior_handler);
+
+    apop_data *report = apop_data_alloc(start_ct, 2);
+    apop_name_add(report->names, "log likelihood", 'c');
+    apop_name_add(report->names, "status", 'c');
+    int best = 0;
+    double best_ll = GSL_NEGINF;
+    for (int i=0; i< start_ct; i++){
+        char name[100];
+        sprintf(name, "start %i", i);
+        apop_name_add(report->names, name, 'r');
+        double ll = start_ll(data, starts[i]);
+        int index = apop_name_find(starts[i]->info->names, "status", 'r');
+        int status = (index>-2) ? apop_data_get(starts[i]->info, index) : -1;
+        apop_data_set(report, i, 0, ll);
+        apop_data_set(report, i, 1, status);
+        if (gsl_finite(ll) && ll > best_ll) {best_ll = ll; best = i;}
+    }
+    Apop_notify(2, "Best of %i starts: start %i, log likelihood %g.", start_ct, best, best_ll);
+
+    apop_data_free(dist->parameters);
+    dist->parameters = starts[best]->parameters;
+    starts[best]->parameters = NULL;
+    if (info.want_info=='y'){
+        apop_data_free(dist->info);
+        dist->info = starts[best]->info;
+        starts[best]->info = NULL;
+    } else if (!dist->info) dist->info = apop_data_alloc();
+    snprintf(dist->info->names->title, 100, "Info");
+    apop_data_add_page(dist->info, report, "<Multistart>");
+    dist->data = data;
+    if (info.want_cov=='y' && dist->parameters->vector && !dist->parameters->matrix){
+        apop_model_numerical_covariance(data, dist, mp->delta);
+        if (info.want_tests=='y')
+            apop_estimate_parameter_tests(dist);
+    }
+    for (int i=0; i< start_ct; i++){
+        apop_model_free(starts[i]);
+        free(start_pts[i]);
+    }
+    free(starts);
+    free(start_pts);
+    return dist;
+}
+
+/* in_multistart=='y' for searches run by multistart, which handles SIGINT for them. */
+static apop_model *mle_dispatch(apop_data *data, apop_model *dist, char in_multistart){
+    apop_mle_settings   *mp = apop_settings_get_group(dist, apop_mle);
+    if (!mp) mp = Apop_model_add_group(dist, apop_mle);
+    if (mp->method == APOP_UNKNOWN_ML)
+        mp->method = (dist->score) ? APOP_CG_FR : APOP_SIMPLEX_NM;
+
+    Apop_assert(dist->parameters, "Not enough information to allocate parameters over which to optimize. If this was not called from apop_estimate, did you call apop_prep first?")
+    if (mp->start_count > 1) return multistart(data, dist, mp);
+    infostruct info = {.data           = data,
+                       .use_constraint = 1,
+                       .trace_file     = malloc(sizeof(FILE *)),
+                       .in_multistart  = in_multistart,
+                       .model          = dist};
+    get_desires(dist, &info);
+    info.beta = apop_data_pack(dist->parameters, NULL, .all_pages='y');
+    if (setup_starting_point(mp, info.beta)) return NULL;
+    *info.trace_file = NULL;
+    info.model->data = data;
+    if (mp->dim_cycle_tolerance)          return dim_cycle(data, dist, info);
+    if (mp->trace_path)                   info.trace_path = mp->trace_path;
+	if (mp->method == APOP_SIMAN)         return apop_annealing(&info);  //below.
+    else if (mp->method==APOP_SIMPLEX_NM) return apop_maximum_likelihood_no_d(data, &info);
+    else if (mp->method == APOP_RF_NEWTON ||
+            mp->method == APOP_RF_HYBRID_NOSCALE ||
+            mp->method == APOP_RF_HYBRID) return  find_roots (info);
+	//else, Conjugate Gradient:
+	return apop_maximum_likelihood_w_d(data, &info);
+}
+
 /** The maximum likelihood calculations. All of the settings are specified by adding a
   \ref apop_mle_settings struct to your model, so see the many notes there. Notably,
   the default method is the Fletcher-Reeves conjugate gradient method, and if your model
@@ -648,33 +917,16 @@ else
     //optimum found
 \endcode
 
-\li During the search for an optimum, ctrl-C (SIGINT) will halt the search, and the function will return whatever parameters the search was on at the time.
+\li During the search for an optimum, ctrl-C (SIGINT) will halt the search, and the function will return whatever parameters the search was on at the time. With several starting points (below), ctrl-C halts all of the searches.
+
+\li If the likelihood has several local optima, set <tt>.start_count</tt> in the \ref
+apop_mle_settings group to search from several starting points (in parallel, given
+threads) and keep the best. The \c info element of the output model then has a
+<tt>\<Multistart\></tt> page listing each search's log likelihood and status.
+\exception out->error=='p' With several starts, I couldn't set up the starting point from the model's parameters.
  \ingroup mle */
 apop_model *apop_maximum_likelihood(apop_data * data, apop_model *dist){
-    apop_mle_settings   *mp = apop_settings_get_group(dist, apop_mle);
-    if (!mp) mp = Apop_model_add_group(dist, apop_mle);
-    if (mp->method == APOP_UNKNOWN_ML)
-        mp->method = (dist->score) ? APOP_CG_FR : APOP_SIMPLEX_NM;
-
-    Apop_assert(dist->parameters, "Not enough information to allocate parameters over which to optimize. If this was not called from apop_estimate, did you call apop_prep first?")
-    infostruct info = {.data           = data,
-                       .use_constraint = 1,
-                       .trace_file     = malloc(sizeof(FILE *)),
-                       .model          = dist};
-    get_desires(dist, &info);
-    info.beta = apop_data_pack(dist->parameters, NULL, .all_pages='y');
-    if (setup_starting_point(mp, info.beta)) return NULL;
-    *info.trace_file = NULL;
-    info.model->data = data;
-    if (mp->dim_cycle_tolerance)          return dim_cycle(data, dist, info);
-    if (mp->trace_path)                   info.trace_path = mp->trace_path;
-	if (mp->method == APOP_SIMAN)         return apop_annealing(&info);  //below.
-    else if (mp->method==APOP_SIMPLEX_NM) return apop_maximum_likelihood_no_d(data, &info);
-    else if (mp->method == APOP_RF_NEWTON ||
-            mp->method == APOP_RF_HYBRID_NOSCALE ||
-            mp->method == APOP_RF_HYBRID) return  find_roots (info);
-	//else, Conjugate Gradient:
-	return apop_maximum_likelihood_w_d(data, &info);
+    return mle_dispatch(data, dist, 'n');
 }
 
 /** 
@@ -877,8 +1129,9 @@ static apop_model * apop_annealing(infostruct *i){
         apopstatus = -1;
         goto done;
     }
+    void (* volatile prior_handler)(int) = NULL; //volatile: set between setjmp and longjmp.
     if (!setjmp(anneal_jump)){
-        signal(SIGINT, anneal_sigint);
+        prior_handler = signal(SIGINT, anneal_sigint);
         gsl_siman_solve(r,    // const gsl_rng * r
           i,                  // void * x0_p
           annealing_energy,   // gsl_siman_Efunc_t Ef
@@ -891,7 +1144,7 @@ static apop_model * apop_annealing(infostruct *i){
           betasize,           // size_t element_size
           simparams);         // gsl_siman_params_t params
     }
-    signal(SIGINT, NULL);
+    signal(SIGINT, prior_handler);
     apop_data_unpack(i->beta, i->model->parameters); 
     apop_estimate_parameter_tests(i->model);
     apopstatus = 0;
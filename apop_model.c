@@ -2,6 +2,7 @@
 /* Copyright (c) 2006--2011 by Ben Klemens.  Licensed under the modified GNU GPL v2; see COPYING and COPYING2.  */
 
 #include "apop_internal.h"
+#include "vtables.h"
 
 /** Allocate an \ref apop_model.
 
@@ -260,6 +261,92 @@ double apop_log_likelihood(apop_data *d, apop_model *m){
     return GSL_NAN;
 }
 
+static void batch_setup(){
+    static int setup=0; if (!(setup++)){
+        apop_log_likelihoods_insert(apop_normal_log_likelihoods, apop_normal);
+        apop_log_likelihoods_insert(apop_lognormal_log_likelihoods, apop_lognormal);
+        apop_log_likelihoods_insert(apop_exponential_log_likelihoods, apop_exponential);
+        apop_log_likelihoods_insert(apop_gamma_log_likelihoods, apop_gamma);
+        apop_log_likelihoods_insert(apop_poisson_log_likelihoods, apop_poisson);
+        apop_log_likelihoods_insert(apop_multinormal_log_likelihoods, apop_multivariate_normal);
+    }
+}
+
+//Unpack each row into a copy of the model and call fn; a copy so m's parameters are left alone.
+static gsl_vector *batch_loop(apop_data *d, apop_model *m, gsl_matrix const *params,
+                                        double (*fn)(apop_data*, apop_model*)){
+    gsl_vector *out = gsl_vector_alloc(params->size1);
+    apop_model *cp = apop_model_copy(*m);
+    for (size_t i=0; i< params->size1; i++){
+        gsl_vector_const_view row = gsl_matrix_const_row(params, i);
+        apop_data_unpack(&row.vector, cp->parameters);
+        gsl_vector_set(out, i, fn(d, cp));
+    }
+    apop_model_free(cp);
+    return out;
+}
+
+static int batch_check(apop_model *m, gsl_matrix const *params){
+    Get_vmsizes(m->parameters); //tsize, wsize
+    Apop_stopif(!m->parameters, return 1, 0, "The model's parameters aren't allocated, so I "
+            "don't know their shape. Try apop_prep(your_data, your_model) first.");
+    Apop_stopif(params->size2 != tsize+wsize, return 1, 0, "Each row of the parameter matrix should "
+            "have the model's %i parameters, packed as by apop_data_pack; I have %zu columns.",
+            tsize+wsize, params->size2);
+    return 0;
+}
+
+/** Find the log likelihood of a data set under each of many parameter sets for one model.
+
+Most models have closed-form likelihoods that only need a few sums over the data, so
+evaluating several parameter sets at once can be much faster than calling \ref
+apop_log_likelihood for each of them in turn. If the model has a routine for evaluating
+many parameter sets at once (registered in the \c apop_log_likelihoods vtable; see
+vtables.h), I use that. The \ref apop_normal, \ref apop_lognormal, \ref
+apop_exponential, \ref apop_gamma, \ref apop_poisson, and \ref
+apop_multivariate_normal have one, which gathers sufficient statistics from the data once
+and then evaluates each parameter set from those. Otherwise, I unpack each
+row into a copy of the model and call \ref apop_log_likelihood.
+
+\param d    The data
+\param m    The model. Its parameters must be allocated, because I use them as the template for the rows of \c params; they are not modified.
+\param params A matrix with one parameter set per row, in the form produced by \ref apop_data_pack.
+\return A vector whose element \f$i\f$ is the log likelihood of the data given the parameters in row \f$i\f$, or \c NULL on error.
+
+\ingroup models
+*/
+gsl_vector *apop_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params){
+    Nullcheck_m(m, NULL);
+    Apop_stopif(!params, return NULL, 0, "You gave me a NULL matrix of parameter sets.");
+    if (batch_check(m, params)) return NULL;
+    batch_setup();
+    apop_log_likelihoods_type batch = apop_log_likelihoods_get(*m);
+    if (batch){
+        gsl_vector *out = gsl_vector_alloc(params->size1);
+        batch(d, m, params, out);
+        return out;
+    }
+    return batch_loop(d, m, params, apop_log_likelihood);
+}
+
+/** Find the probability of a data set under each of many parameter sets for one model. 
+
+This is the exponentiated form of \ref apop_log_likelihoods; see that function for details.
+If the model has no batched routine, I call \ref apop_p for each row.
+
+\ingroup models
+*/
+gsl_vector *apop_ps(apop_data *d, apop_model *m, gsl_matrix const *params){
+    Nullcheck_m(m, NULL);
+    Apop_stopif(!params, return NULL, 0, "You gave me a NULL matrix of parameter sets.");
+    if (batch_check(m, params)) return NULL;
+    batch_setup();
+    if (!apop_log_likelihoods_get(*m)) return batch_loop(d, m, params, apop_p);
+    gsl_vector *out = apop_log_likelihoods(d, m, params);
+    for (size_t i=0; i< out->size; i++) out->data[i] = exp(out->data[i]);
+    return out;
+}
+
 /** Find the vector of derivatives of the log likelihood of a data/parametrized model pair.
 
 \param d    The data
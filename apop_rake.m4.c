@@ -1,6 +1,7 @@
 //#define __USE_POSIX //for strtok_r
 #include "apop_internal.h"
 #include <stdbool.h>
+#include <time.h>
 #include <gsl/gsl_sort_vector.h>
 void xprintf(char **q, char *format, ...); //in apop_conversions.c
 
@@ -26,75 +27,97 @@ raking. */
 /* This section indexes a PMF-type apop_data struct. The index is held in a 2-d grid
 of nodes. The index's first index is the dimension, and will hold one column for each
 column in the original data set. The index's second index goes over all of the values
-in the given column.
+in the given column, in sorted order.
 
-PS: this was intended to one day become a general-purpose index for PMFs; making that
-happen remains on the to-do list.
+Each node holds a posting list for each of the two data sets being indexed (the margins and
+the fit): the sorted list of rows in that data set with the given value. So memory use
+is one entry per nonzero cell per dimension, not one per possible cell per value, and
+finding the rows that match a set of values is an intersection of sorted lists. The
+lists don't know anything about raking, so this index could serve other PMF work too.
 
 mnode[i] = a dimension row
 mnode[i][j] = a value in a given dimension
-mnode[i][j].margin_ptrs = a list of all of the rows in the data set with the given value.
-mnode[i][j].margin_ptrs[k] = the kth item for the value.
+mnode[i][j].margin.rows = a list of all of the rows in the margin data with the given value.
+mnode[i][j].margin.rows[k] = the kth item for the value.
   */
 
+typedef struct {
+    size_t *rows, ct;
+} posting_t;
+
 typedef struct {
     double val;
-    bool *margin_ptrs, *fit_ptrs;
+    posting_t margin, fit;
 } mnode_t;
 
 typedef void(*index_apply_f)(mnode_t * const * const, int, void*);
 
-static int find_val(double findme, mnode_t *nodecol){
-    for (int i=0; nodecol[i].val <= findme || gsl_isnan(findme); i++)
-        if (nodecol[i].val == findme || (gsl_isnan(findme) && gsl_isnan(nodecol[i].val)))
-           return i;
+//Binary search over the sorted values. NaNs sort to the end.
+static int find_val(double findme, mnode_t *nodecol, size_t ct){
+    if (gsl_isnan(findme))
+        return (ct && gsl_isnan(nodecol[ct-1].val)) ? ct-1 : -1;
+    size_t lo=0, hi=ct;
+    while (lo < hi){
+        size_t mid = (lo+hi)/2;
+        double v = nodecol[mid].val;
+        if (v == findme) return mid;
+        if (!gsl_isnan(v) && v < findme) lo = mid+1;
+        else hi = mid;
+    }
     return -1;
 }
 
-//returns -1 if the given row/col doesn't exist.
-int index_add_node(mnode_t **mnodes, size_t dim, size_t row, double val, bool is_margin){
-    int index = find_val(val, mnodes[dim]);
-    if (index == -1) return -1;
-    if (is_margin) mnodes[dim][index].margin_ptrs[row] = true;
-    else           mnodes[dim][index].fit_ptrs[row] = true;
+/* Fill one posting list per value for one column of one data set. The first pass
+   finds each row's value and counts, the second lays the rows out, in order. */
+static int index_fill(mnode_t *nodecol, size_t valct, apop_data const *d, size_t col, bool is_margin){
+    size_t rows = d->matrix->size1;
+    int *where = malloc(sizeof(int)*rows);
+    #define plist(j) (is_margin ? &nodecol[(j)].margin : &nodecol[(j)].fit)
+    for (size_t j=0; j < valct; j++) plist(j)->ct = 0;
+    for (size_t r=0; r < rows; r++){
+        where[r] = find_val(apop_data_get(d, r, col), nodecol, valct);
+        if (where[r] != -1) plist(where[r])->ct++; //fit values may not be present; ignore them.
+    }
+    for (size_t j=0; j < valct; j++){
+        posting_t *p = plist(j);
+        p->rows = p->ct ? malloc(sizeof(size_t)*p->ct) : NULL;
+        Apop_stopif(p->ct && !p->rows, free(where); return -1, 0, "Allocation error building the raking index.");
+        p->ct = 0;
+    }
+    for (size_t r=0; r < rows; r++)
+        if (where[r] != -1){
+            posting_t *p = plist(where[r]);
+            p->rows[p->ct++] = r;
+        }
+    free(where);
     return 0;
+    #undef plist
 }
 
 mnode_t **index_generate(apop_data const *in, apop_data const *in2){
     size_t margin_ct = in->matrix->size2;
-    size_t margin_rows = in->matrix->size1;
-    size_t fit_rows = in2->matrix->size1;
     mnode_t **mnodes = malloc(sizeof(mnode_t*)*(margin_ct+1));
-    //allocate every node
     for(size_t i=0; i < margin_ct; i ++){
         Apop_col(in, i, col);
         gsl_vector *vals = apop_vector_unique_elements(col);
         mnodes[i] = malloc(sizeof(mnode_t)*(vals->size+1));
         for(size_t j=0; j < vals->size; j ++)
-            mnodes[i][j] = (mnode_t) {.val = gsl_vector_get(vals, j),
-                        .margin_ptrs = calloc(margin_rows, sizeof(bool)),
-                        .fit_ptrs = calloc(fit_rows, sizeof(bool))
-            };
+            mnodes[i][j] = (mnode_t) {.val = gsl_vector_get(vals, j)};
         mnodes[i][vals->size] = (mnode_t) {.val = GSL_POSINF}; //end-of-array sentinel
+        //put data from the matrix into the right pigeonhole
+        index_fill(mnodes[i], vals->size, in, i, true);
+        index_fill(mnodes[i], vals->size, in2, i, false);
         gsl_vector_free(vals);
     }
     mnodes[margin_ct] = NULL; //end-of-array sentinel
-    //put data from the matrix into the right pigeonhole
-    for(size_t i=0; i < margin_ct; i++){
-        for(size_t j=0; j < in->matrix->size1; j++)
-            Apop_stopif(index_add_node(mnodes, i, j, apop_data_get(in, j, i), true) == -1, return mnodes,
-            0, "I can't find a value, %g, that should've already been inserted.", apop_data_get(in, j, i));
-        for(size_t j=0; j < in2->matrix->size1; j++) //these values may not be present, in which case ignore them.
-            index_add_node(mnodes, i, j, apop_data_get(in2, j, i), false);
-    }
     return mnodes;
 }
 
 void index_free(mnode_t **in){
 	for (int i=0; in[i]; i++){
 		for (int j=0; !isinf(in[i][j].val); j++){
-			free(in[i][j].margin_ptrs);
-			free(in[i][j].fit_ptrs);
+			free(in[i][j].margin.rows);
+			free(in[i][j].fit.rows);
         }
         free(in[i]);
 	}
@@ -139,21 +162,52 @@ void index_foreach(mnode_t *index[], index_apply_f f, void *args){
     free(values[j]);
 }
 
-/* Check whether an observation falls into all of the given margins.
+/* Intersect two sorted row lists into out, which may be a. When one list is much
+   shorter than the other, binary-search the long one for each element of the short one;
+   else walk them in step. */
+static size_t list_intersect(size_t const *a, size_t an, size_t const *b, size_t bn, size_t *out){
+    size_t n = 0;
+    if (bn > 8*an){
+        size_t lo = 0;
+        for (size_t i=0; i < an; i++){
+            size_t hi = bn;
+            while (lo < hi){
+                size_t mid = (lo+hi)/2;
+                if (b[mid] < a[i]) lo = mid+1;
+                else hi = mid;
+            }
+            if (lo < bn && b[lo] == a[i]) out[n++] = a[i];
+        }
+    } else
+        for (size_t i=0, j=0; i < an && j < bn; )
+            if (a[i] < b[j]) i++;
+            else if (a[i] > b[j]) j++;
+            else out[n++] = a[i], i++, j++;
+    return n;
+}
 
-This is for a contrast. We've already calculated the in/out vector for each value on
-each margin, and now need to && each dimension into one vector.
+/* Find the rows that fall into all of the given margins.
+
+This is for a contrast. We've already got the list of rows for each value on
+each margin, and now need to intersect across dimensions.
 
 \param index Is actually a partial index: for each dimension, there should be only one value. Useful for the center of an index_foreach loop.
-\param d Should already be allocated to the right size, may be filled with garbage.
-\return d will be zero or one to indicate which rows of the indexed data set meet all criteria.  */
-void index_get_element_list(mnode_t *const * index, bool *d, size_t len, bool is_margin){
-    memcpy(d, is_margin ? index[0]->margin_ptrs: index[0]->fit_ptrs, len *  sizeof(bool));
-    for(size_t i=1; !isinf(index[i]->val); i++){
-        bool *ptr_list = is_margin ? index[i]->margin_ptrs: index[i]->fit_ptrs;
-        for(size_t j=0; j < len; j++)
-             d[j] &= ptr_list[j];
-    }
+\param out Will be allocated (or set to \c NULL if there are no rows) and filled with the rows of the indexed data set that meet all criteria, in order.
+\return The number of rows in \c out.  */
+size_t index_get_element_list(mnode_t *const * index, size_t **out, bool is_margin){
+    #define plist(i) (is_margin ? &index[(i)]->margin : &index[(i)]->fit)
+    size_t shortest = 0;
+    for(size_t i=1; !isinf(index[i]->val); i++)
+        if (plist(i)->ct < plist(shortest)->ct) shortest = i;
+    size_t n = plist(shortest)->ct;
+    if (!n) {*out = NULL; return 0;}
+    *out = malloc(sizeof(size_t)*n);
+    memcpy(*out, plist(shortest)->rows, sizeof(size_t)*n);
+    for(size_t i=0; n && !isinf(index[i]->val); i++)
+        if (i != shortest) n = list_intersect(*out, n, plist(i)->rows, plist(i)->ct, *out);
+    if (!n) {free(*out); *out = NULL;}
+    return n;
+    #undef plist
 }
 
 ////End index.c
@@ -205,10 +259,6 @@ static void scaling(size_t const *elmts, size_t const n,  gsl_vector *weights, d
 */
 static void one_set_of_values(mnode_t *const * const margincons, int ctr, void *in){
     rake_t *r = in;
-    size_t marginsize = r->indata->matrix->size1;
-    size_t fitsize = r->fit->matrix->size1;
-    bool melmts[marginsize];
-    bool fitelmts[fitsize];
 	bool first_pass = false;
     double in_sum;
 	if (ctr < r->ct)
@@ -216,24 +266,15 @@ static void one_set_of_values(mnode_t *const * const margincons, int ctr, void *
     else {
         r->ct++;
         if (ctr >= r->al || r->al==0) rakeinfo_grow(r);
-   		index_get_element_list(margincons, melmts, marginsize, true);
-   		index_get_element_list(margincons, fitelmts, fitsize, false);
+        size_t *melmts;
+        size_t mct = index_get_element_list(margincons, &melmts, true);
         in_sum = 0;
-        int n=0, al=0;
-        r->elmtlist[ctr] = NULL;
         //use margin index to get total for this margin.
-        for(int m=0; m < marginsize; m++)
-            if (melmts[m]) in_sum += r->indata->weights->data[m];
+        for(size_t m=0; m < mct; m++)
+            in_sum += r->indata->weights->data[melmts[m]];
+        free(melmts);
         //use fit index to get elements involved in this margin
-        for(int m=0; m < fitsize; m++)
-            if (fitelmts[m]){
-                if (n >= al) {
-                    al = (al+1)*2;
-                    r->elmtlist[ctr] = realloc(r->elmtlist[ctr], al*sizeof(size_t));
-                }
-                r->elmtlist[ctr][n++] = m;
-            }
-        r->elmtlist_sizes[ctr] = n;
+        r->elmtlist_sizes[ctr] = index_get_element_list(margincons, r->elmtlist+ctr, false);
         r->indata_values->data[ctr] = in_sum;
 		first_pass = true;
 	}
@@ -242,14 +283,40 @@ static void one_set_of_values(mnode_t *const * const margincons, int ctr, void *
     scaling(r->elmtlist[ctr], r->elmtlist_sizes[ctr], r->fit->weights, in_sum, r->maxdev);
 }
 
+/* After the first pass, each margin's combinations of values are a flat list, and
+   since every cell of the fit has exactly one value in each dimension, no two
+   combinations share a cell. So the list can be cut into chunks and scaled on the
+   thread pool with the same result as scaling it in order. Each chunk keeps its own
+   max deviation, and the max of those is the same whatever the schedule. */
+typedef struct {
+    rake_t *r;
+    double *devs;
+    size_t chunk;
+} rakepass;
+
+static void scale_chunk(void *in, size_t lo, size_t hi, int worker){
+    rakepass *rp = in;
+    rake_t *r = rp->r;
+    double dev = 0;
+    for (size_t m=lo; m < hi; m++)
+        if (r->elmtlist_sizes[m] && r->indata_values->data[m])
+            scaling(r->elmtlist[m], r->elmtlist_sizes[m], r->fit->weights, r->indata_values->data[m], &dev);
+    rp->devs[lo/rp->chunk] = dev;
+}
+
 /* For each configuration margin, for each combination for that margin, 
-   call the above one_set_of_values() function. */
+   call the above one_set_of_values() function. The first pass has to build
+   each combination's element list, and so runs in order. */
 static void main_loop(int config_ct, rake_t *rakeinfo, int k){
     for (size_t i=0; i < config_ct; i ++)
 		if (k==1) index_foreach(rakeinfo[i].index, one_set_of_values, rakeinfo+i);
-		else
-			for(int m=0; m < rakeinfo[i].ct; m++)
-				one_set_of_values(NULL, m, rakeinfo+i);
+		else if (rakeinfo[i].ct){
+            size_t ct = rakeinfo[i].ct, chunk = apop_pool_chunk(ct);
+            double devs[(ct + chunk - 1)/chunk];
+            apop_pool_run(scale_chunk, &(rakepass){.r=rakeinfo+i, .devs=devs, .chunk=chunk}, ct, chunk);
+            for (size_t c=0; c < (ct + chunk - 1)/chunk; c++)
+                *rakeinfo[i].maxdev = GSL_MAX(*rakeinfo[i].maxdev, devs[c]);
+        }
 }
 
 /* Following the FORTRAN, 1 contrast ==> icon. Here, icon will be a
@@ -282,8 +349,10 @@ Re: the contrast array: Each _column_ is a contrast. Put a one in each col
  1 0<br>
  1 1<br>
  0 1
+
+\return An info page with the max deviation and the wall-clock time of each round.
  */
-static void c_loglin(const apop_data *config, const apop_data *indata, 
+static apop_data *c_loglin(const apop_data *config, const apop_data *indata, 
                         apop_data *fit, double tolerance, int maxit) {
     mnode_t ** index = index_generate(indata, fit);
 
@@ -309,9 +378,20 @@ static void c_loglin(const apop_data *config, const apop_data *indata,
     }
     int k;
     gsl_vector *previous = apop_vector_copy(fit->weights);
+    apop_data *info = apop_data_alloc(maxit, 2);
+    apop_name_add(info->names, "max deviation", 'c');
+    apop_name_add(info->names, "seconds", 'c');
     for (k = 1; k <= maxit; ++k) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
         maxdev = 0;
         main_loop(contrast_ct, rakeinfos, k);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        char name[100];
+        sprintf(name, "round %i", k);
+        apop_name_add(info->names, name, 'r');
+        apop_data_set(info, k-1, 0, maxdev);
+        apop_data_set(info, k-1, 1, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1e9);
         Apop_notify(3, "Data set after round %i of raking.\n", k);
         if (apop_opts.verbose >=3) apop_data_print(fit, .output_pipe=apop_opts.log_file);
         if (maxdev < tolerance) break;// Normal termination 
@@ -319,7 +399,9 @@ static void c_loglin(const apop_data *config, const apop_data *indata,
     }
     cleanup(index, rakeinfos,contrast_ct);
     gsl_vector_free(previous);
-    Apop_stopif(k == maxit, fit->error='c', 0, "Maximum number of iterations reached.");
+    info->matrix = apop_matrix_realloc(info->matrix, GSL_MIN(k, maxit), 2);
+    Apop_stopif(k > maxit, fit->error='c', 0, "Maximum number of iterations reached.");
+    return info;
 }
 
 char *pipe_parse = "[ \n\t]*([^| \n\t]+)[ \n\t]*([|]|$)";
@@ -526,6 +608,15 @@ apop_query("update data_table set count_col = 1e-3 where count_col = 0");
 
 \return An \ref apop_data set where every row is a single combination of variable values
 and the \c weights vector gives the most likely value for each cell.
+\li If <tt>apop_opts.thread_count</tt> is greater than one, each round after the first
+scales the cells for each margin on several threads. The cells for different
+combinations of a margin's values never overlap, so the output is the same at any thread
+count.
+
+\li The output has an <tt>\<Info\></tt> page, with one row per round of raking, giving
+the largest change in a margin total during that round and the round's wall-clock time
+in seconds.
+
 \exception out->error='i' Input was somehow wrong.
 \exception out->error='c' Raking did not converge, reached max. iteration count.
 \li This function uses the \ref designated syntax for inputs.
@@ -632,7 +723,7 @@ APOP_VAR_ENDHEAD
     if (!init_table || nudge)
         for (int i=0; i< contrast_ct; i++) apop_data_free(contras[i]);
 
-    c_loglin(contrast_grid, d, fit, tolerance, max_iterations);
+    apop_data_add_page(fit, c_loglin(contrast_grid, d, fit, tolerance, max_iterations), "<Info>");
     apop_data_free(d);
     
     all_vars_d->textsize[0] = tt;
@@ -641,3 +732,103 @@ APOP_VAR_ENDHEAD
 	apop_data_free(contrast_grid);
 	return fit;
 }
+
+/** Rake an in-memory table, without the database. This is \ref apop_rake for the case
+where the margin data and the starting table are already \ref apop_data sets in
+PMF form: one column of the matrix per variable, and the \c weights vector giving the
+count for each row.
+
+\code
+apop_data *fitted = apop_rake_data(margin_data, .init=starting_table,
+                        .contrasts=(char*[]){"age|sex", "sex|region"}, .contrast_ct=2);
+\endcode
+
+The raking itself is the same as with \ref apop_rake; see that function for the
+details of the algorithm and its output.
+
+\param margins The observations the margins are calculated from. Rows may repeat;
+their weights are added up. If the \c weights vector is \c NULL, each row is one
+observation. The matrix columns have to be named, as the contrasts refer to them by
+name. No default.
+
+\param init The starting table, with the same columns, in the same order, as \c margins.
+Every cell that may be nonzero after raking has to be a row here; the raking will not
+add rows. There is no <tt>structural_zeros</tt> option, because a structural zero is just
+a row you leave out. If the \c weights vector is \c NULL, every cell starts at one. I
+don't modify this table. No default.
+
+\param contrasts The contrasts describing your model, each a pipe-delimited list of
+column names, as with \ref apop_rake.
+
+\param contrast_ct The number of contrasts in the list of contrasts.
+
+\param max_iterations Number of rounds of raking at which the algorithm halts. Default: 1000.
+
+\param tolerance Stop when the largest change in a margin total over a round is smaller
+than this. Default: 1e-5.
+
+\param nudge If nonzero, add this to every zero cell of \c init before raking. Default: 0.
+
+\return A copy of \c init, whose \c weights vector gives the most likely value for each
+cell, plus the <tt>\<Info\></tt> page described at \ref apop_rake.
+\exception out->error='i' Input was somehow wrong.
+\exception out->error='c' Raking did not converge, reached max. iteration count.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data * apop_rake_data(apop_data const *margins, apop_data const *init, char * const *contrasts, int contrast_ct, int max_iterations, double tolerance, double nudge){
+    apop_data const * apop_varad_var(margins, NULL);
+    Apop_stopif(!margins || !margins->matrix, apop_return_data_error(i), 0, "I need a margins table with a matrix of variables.");
+    apop_data const * apop_varad_var(init, NULL);
+    Apop_stopif(!init || !init->matrix, apop_return_data_error(i), 0, "I need a starting table with a matrix of variables.");
+    char *const * apop_varad_var(contrasts, NULL);
+    int apop_varad_var(contrast_ct, 0);
+    Apop_stopif(contrasts&&!contrast_ct, apop_return_data_error(i),
+            0, "you gave me a list of contrasts but not the count. "
+            "This is C--I can't count them myself. Please provide the count and re-run.");
+    int apop_varad_var(max_iterations, 1e3);
+    double apop_varad_var(tolerance, 1e-5);
+    double apop_varad_var(nudge, 0);
+APOP_VAR_ENDHEAD
+    int var_ct = margins->matrix->size2;
+    Apop_stopif(init->matrix->size2 != var_ct, apop_return_data_error(i), 0,
+            "The margins have %i columns but the starting table has %zu.", var_ct, init->matrix->size2);
+    Apop_stopif(contrast_ct && (!margins->names || margins->names->colct < var_ct), apop_return_data_error(i), 0,
+            "The contrasts name columns, but the margin table's columns aren't named.");
+    if (init->names && init->names->colct >= var_ct && margins->names && margins->names->colct >= var_ct)
+        for (int i=0; i< var_ct; i++)
+            Apop_stopif(strcmp(init->names->column[i], margins->names->column[i]), apop_return_data_error(i), 0,
+                "Column %i is %s in the margins but %s in the starting table.", i, margins->names->column[i], init->names->column[i]);
+
+    apop_data *contrast_grid = apop_data_calloc(var_ct, contrast_ct);
+	apop_data **contras = generate_list_of_contrasts(contrasts, contrast_ct);
+    int bad_name = 0;
+	for (int i=0; i< contrast_ct; i++){
+		for (int j=0; j< contras[i]->textsize[0] && !bad_name; j++){
+            int col = get_var_index(margins->names->column, var_ct, contras[i]->text[j][0]);
+            if (col == -1) bad_name = 1;
+            else apop_data_set(contrast_grid, col, i, 1);
+        }
+        apop_data_free(contras[i]);
+    }
+    free(contras);
+    Apop_stopif(bad_name, apop_data_free(contrast_grid); apop_return_data_error(i), 0,
+            "A contrast names a variable that isn't a column of the margin table.");
+
+    apop_data m = *margins; //a shallow copy, so I can fill in weights if need be.
+    if (!m.weights){
+        m.weights = gsl_vector_alloc(m.matrix->size1);
+        gsl_vector_set_all(m.weights, 1);
+    }
+    apop_data *fit = apop_data_copy(init);
+    if (!fit->weights){
+        fit->weights = gsl_vector_alloc(fit->matrix->size1);
+        gsl_vector_set_all(fit->weights, 1);
+    }
+    apop_vector_apply(fit->weights, nan_to_zero);
+    if (nudge) apop_map(fit, .fn_rp=nudge_zeros, .param=&nudge);
+
+    apop_data_add_page(fit, c_loglin(contrast_grid, &m, fit, tolerance, max_iterations), "<Info>");
+    if (!margins->weights) gsl_vector_free(m.weights);
+	apop_data_free(contrast_grid);
+	return fit;
+}
@@ -9,7 +9,7 @@
  */
 
 #include "apop_internal.h"
-#include <search.h> //lsearch; bsearch is in stdlib.
+#include <stdint.h>
 
 /** For many, it is a knee-jerk reaction to a parameter estimation to test whether each individual parameter differs from zero. This function does that.
 
@@ -56,11 +56,91 @@ static int compare_doubles (const void *a, const void *b) {
     return (*da > *db) - (*da < *db);
 }
 
-typedef const char * ccp;
-static int strcmpwrap(const void *a, const void *b){
-    const ccp *aa = a;
-    const ccp *bb = b;
-    return strcmp(*aa, *bb);
+/* Finding unique elements: one pass over the data puts each element in an open-addressed
+ hash table (unless an equal element is already there), recording the distinct elements in
+ the order first seen, and, if the caller wants them, each row's first-seen number. Then
+ the distinct elements are sorted once, and the first-seen numbers are mapped to
+ positions in the sorted list. As with compare_doubles, all NaNs are one element, as are
+ 0 and -0; the hash is the one in internal.h, as for the PMF's index. */
+typedef struct {
+    double val;
+    char *text;     //NULL for numeric data.
+    size_t id;      //order first seen.
+} uniq_elmt;
+
+typedef struct {
+    uniq_elmt *elmts;
+    size_t ct, space, mask;
+    size_t *slots;  //indices into elmts; SIZE_MAX for empty.
+    unsigned long long *hashes;
+} uniq_set;
+
+static unsigned long long uniq_hash(double val, char const *text){
+    unsigned long long h = text ? apop_hash_bytes(apop_hash_start, text, strlen(text))
+                                : apop_hash_double(apop_hash_start, val);
+    return h ^ (h >> 32); //FNV's high bits are better mixed than the low bits the mask keeps.
+}
+
+static int compare_uniq(const void *a, const void *b){
+    uniq_elmt const *ua = a, *ub = b;
+    return ua->text ? strcmp(ua->text, ub->text) : compare_doubles(&ua->val, &ub->val);
+}
+
+static void uniq_rehash(uniq_set *u, size_t size){
+    free(u->slots);
+    free(u->hashes);
+    u->mask = size-1;
+    u->slots = malloc(sizeof(size_t)*size);
+    u->hashes = malloc(sizeof(unsigned long long)*size);
+    for (size_t i=0; i< size; i++) u->slots[i] = SIZE_MAX;
+    for (size_t i=0; i< u->ct; i++){
+        unsigned long long h = uniq_hash(u->elmts[i].val, u->elmts[i].text);
+        size_t slot = h & u->mask;
+        while (u->slots[slot] != SIZE_MAX) slot = (slot+1) & u->mask;
+        u->slots[slot] = i;
+        u->hashes[slot] = h;
+    }
+}
+
+//Returns the first-seen number of the element, adding it if it's new.
+static size_t uniq_add(uniq_set *u, double val, char *text){
+    if (2*(u->ct+1) > u->mask+1) uniq_rehash(u, 2*(u->mask+1)); //keep chains short.
+    unsigned long long h = uniq_hash(val, text);
+    size_t slot = h & u->mask;
+    uniq_elmt this = {.val=val, .text=text, .id=u->ct};
+    for ( ; u->slots[slot] != SIZE_MAX; slot = (slot+1) & u->mask)
+        if (u->hashes[slot] == h && !compare_uniq(&this, u->elmts + u->slots[slot]))
+            return u->slots[slot];
+    if (u->ct == u->space){
+        u->space = 2*u->space + 16;
+        u->elmts = realloc(u->elmts, sizeof(uniq_elmt)*u->space);
+    }
+    u->elmts[u->ct] = this;
+    u->slots[slot] = u->ct;
+    u->hashes[slot] = h;
+    return u->ct++;
+}
+
+/* Read every element (from v, or else from text column col of d); sort the distinct
+   elements; if codes is not NULL, fill it with each row's position in the sorted list. */
+static uniq_set uniq_find(gsl_vector const *v, apop_data const *d, size_t col, gsl_vector *codes){
+    uniq_set u = {};
+    uniq_rehash(&u, 16);
+    size_t n = v ? v->size : d->textsize[0];
+    for (size_t i=0; i< n; i++){
+        size_t id = v ? uniq_add(&u, gsl_vector_get(v, i), NULL) : uniq_add(&u, 0, d->text[i][col]);
+        if (codes) gsl_vector_set(codes, i, id);
+    }
+    qsort(u.elmts, u.ct, sizeof(uniq_elmt), compare_uniq);
+    if (codes){
+        size_t *rank = malloc(sizeof(size_t)*(u.ct+1));
+        for (size_t i=0; i< u.ct; i++) rank[u.elmts[i].id] = i;
+        for (size_t i=0; i< n; i++) gsl_vector_set(codes, i, rank[(size_t)gsl_vector_get(codes, i)]);
+        free(rank);
+    }
+    free(u.slots);
+    free(u.hashes);
+    return u;
 }
 
 /** Give me a vector of numbers, and I'll give you a sorted list of the unique elements. 
@@ -69,23 +149,33 @@ static int strcmpwrap(const void *a, const void *b){
   \param v a vector of items
   \return a sorted vector of the distinct elements that appear in the input.
   \li NaNs appear at the end of the sort order.
-  \see apop_text_unique_elements 
+  \li This takes one pass over the data, using a hash table to find new elements, and one sort of the distinct elements.
+  \see apop_text_unique_elements, apop_vector_unique_codes
 */
 gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
-    size_t prior_elmt_ctr = 107;
-    size_t elmt_ctr = 0;
-    double *elmts = NULL;
-    for (size_t i=0; i< v->size; i++){
-        if (prior_elmt_ctr != elmt_ctr)
-            elmts = realloc(elmts, sizeof(double)*(elmt_ctr+1));
-        prior_elmt_ctr = elmt_ctr;
-        double val = gsl_vector_get(v, i);
-        lsearch(&val, elmts, &elmt_ctr, sizeof(double), compare_doubles);
-        if (prior_elmt_ctr < elmt_ctr)
-            qsort(elmts, elmt_ctr, sizeof(double), compare_doubles);
-    }
-    gsl_vector *out = apop_array_to_vector(elmts, elmt_ctr);
-    free(elmts);
+    return apop_vector_unique_codes(v, NULL);
+}
+
+/** Find the sorted list of unique elements of a vector, as per \ref apop_vector_unique_elements,
+  and, in the same pass, the position in that list of every element of the input.
+  That is, after <tt>gsl_vector *u = apop_vector_unique_codes(v, codes)</tt>,
+  <tt>gsl_vector_get(u, gsl_vector_get(codes, i)) == gsl_vector_get(v, i)</tt> for every \c i
+  (where NaN equals NaN).
+
+  \param v a vector of items
+  \param codes A vector the same size as \c v, which I will fill with the factor codes
+  \f$0, 1, \dots\f$. If \c NULL, this is \ref apop_vector_unique_elements.
+  \return a sorted vector of the distinct elements that appear in the input, NaNs last.
+  Returns \c NULL if \c codes is not the same size as \c v.
+  \see apop_text_unique_codes
+*/
+gsl_vector * apop_vector_unique_codes(const gsl_vector *v, gsl_vector *codes){
+    Apop_stopif(codes && codes->size != v->size, return NULL, 0, "The input vector has size %zu, "
+            "but the codes vector has size %zu. Returning NULL.", v->size, codes->size);
+    uniq_set u = uniq_find(v, NULL, 0, codes);
+    gsl_vector *out = u.ct ? gsl_vector_alloc(u.ct) : NULL;
+    for (size_t i=0; i< u.ct; i++) gsl_vector_set(out, i, u.elmts[i].val);
+    free(u.elmts);
     return out;
 }
 
@@ -97,31 +187,32 @@ gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
   \param d An \ref apop_data set with a text component
   \param col The text column you want me to use.
   \return An \ref apop_data set with a single sorted column of text, where each unique text input appears once.
-  \see apop_vector_unique_elements
+  \see apop_vector_unique_elements, apop_text_unique_codes
 */
 apop_data * apop_text_unique_elements(const apop_data *d, size_t col){
-  char   **tval;
-
-  //first element for free
-  size_t prior_elmt_ctr, elmt_ctr = 1;
-  char **telmts = malloc(sizeof(char**)*2);
-  telmts[0] = d->text[0][col];
-
-    for (int i=1; i< d->textsize[0]; i++){
-        prior_elmt_ctr  = elmt_ctr;
-        tval    =  &(d->text[i][col]);
-        lsearch (tval, telmts, &elmt_ctr, sizeof(char*), strcmpwrap);
-        if (prior_elmt_ctr  < elmt_ctr){
-            qsort(telmts, elmt_ctr, sizeof(char*), strcmpwrap);
-            telmts = realloc(telmts, sizeof(char**)*(elmt_ctr+1));
-        }
-    }
+    return apop_text_unique_codes(d, col, NULL);
+}
+
+/** Find the sorted list of unique elements of a column of text, as per \ref
+  apop_text_unique_elements, and, in the same pass, the position in that list of every row
+  of the input column.
 
-    //pack and ship
-    apop_data *out = apop_text_alloc(NULL, elmt_ctr, 1);
-    for (int j=0; j< elmt_ctr; j++)
-        apop_text_add(out, j, 0, telmts[j]);
-    free(telmts);
+  \param d An \ref apop_data set with a text component
+  \param col The text column you want me to use.
+  \param codes A vector with one element for each row of text, which I will fill with
+  the factor codes \f$0, 1, \dots\f$. If \c NULL, this is \ref apop_text_unique_elements.
+  \return An \ref apop_data set with a single sorted column of text, where each unique text input appears once.
+  Returns \c NULL if \c codes is not the right size.
+  \see apop_vector_unique_codes
+*/
+apop_data * apop_text_unique_codes(const apop_data *d, size_t col, gsl_vector *codes){
+    Apop_stopif(codes && codes->size != d->textsize[0], return NULL, 0, "The input has %zu rows "
+            "of text, but the codes vector has size %zu. Returning NULL.", d->textsize[0], codes->size);
+    uniq_set u = uniq_find(NULL, d, col, codes);
+    apop_data *out = apop_text_alloc(NULL, u.ct, 1);
+    for (size_t j=0; j< u.ct; j++)
+        apop_text_add(out, j, 0, "%s", u.elmts[j].text);
+    free(u.elmts);
     return out;
 }
 
@@ -155,32 +246,32 @@ static char *make_catname (apop_data *d, int col, char type){
 /* Producing dummies consists of finding the index of element i, for all i, then
  setting (i, index) to one.
  Producing factors consists of finding the index and then setting (i, datacol) to index.
- Otherwise the work is basically identical.  
+ Otherwise the work is basically identical. The indices come from the same pass that
+ finds the unique elements.
  Also, add a ->more page to the input data giving the translation.
  */
 static apop_data * dummies_and_factors_core(apop_data *d, int col, char type, 
                             int keep_first, int datacol, char dummyfactor, 
                             apop_data **factor_list){
-    size_t index, elmt_ctr = 0;
+    size_t elmt_ctr = 0;
     gsl_vector *delmts = NULL;
-    char **telmts = NULL;//unfortunately needed for the bsearch.
+    int s = type == 't' 
+            ? d->textsize[0]
+            : (col >=0 ? d->matrix->size1 : d->vector->size);
+    gsl_vector *codes = gsl_vector_alloc(s);
 
     //first, create an ordered list of unique elements.
     //Record that list for use in this function, and in a ->more page of the data set.
     char *catname =  make_catname(d, col, type);
     if (type == 't'){
-        *factor_list = apop_data_add_page(d, apop_text_unique_elements(d, col), catname);
+        *factor_list = apop_data_add_page(d, apop_text_unique_codes(d, col, codes), catname);
         elmt_ctr = (*factor_list)->textsize[0];
-        //awkward format conversion:
-        telmts = malloc(sizeof(char*)*elmt_ctr);
-        for (size_t j=0; j< elmt_ctr; j++)
-            asprintf(&(telmts[j]), "%s", (*factor_list)->text[j][0]);
         (*factor_list)->vector = gsl_vector_alloc(elmt_ctr);
         for (size_t i=0; i< (*factor_list)->vector->size; i++)
             apop_data_set(*factor_list, i, -1, i);
     } else {
         APOP_COL(d, col, to_search);
-        delmts = apop_vector_unique_elements(to_search);
+        delmts = apop_vector_unique_codes(to_search, codes);
         elmt_ctr = delmts->size;
         *factor_list = apop_data_add_page(d, apop_data_alloc(elmt_ctr), catname);
         apop_text_alloc((*factor_list), delmts->size, 1);
@@ -191,21 +282,14 @@ static apop_data * dummies_and_factors_core(apop_data *d, int col, char type,
         }
     }
 
-    //Now go through the input vector, and for row i find the posn of the vector's
+    //Now go through the input vector, and for row i take the posn of the vector's
     //name in the element list created above (j), then change (i,j) in
     //the dummy matrix to one.
-    int s = type == 't' 
-            ? d->textsize[0]
-            : (col >=0 ? d->matrix->size1 : d->vector->size);
     apop_data *out = (dummyfactor == 'd')
                 ? apop_data_calloc(0, s, (keep_first ? elmt_ctr : elmt_ctr-1))
                 : d;
     for (size_t i=0; i< s; i++){
-        if (type == 'd'){
-            double val = apop_data_get(d, i, col);
-            index = ((size_t)bsearch(&val, delmts->data, elmt_ctr, sizeof(double), compare_doubles) - (size_t)delmts->data)/sizeof(double);
-        } else 
-            index   = ((size_t)bsearch(&(d->text[i][col]), telmts, elmt_ctr, sizeof(char**), strcmpwrap) - (size_t)telmts)/sizeof(char**);
+        size_t index = gsl_vector_get(codes, i);
         if (dummyfactor == 'd'){
             if (keep_first)
                 gsl_matrix_set(out->matrix, i, index,1); 
@@ -222,17 +306,14 @@ static apop_data * dummies_and_factors_core(apop_data *d, int col, char type,
             if (type =='d'){
                 sprintf(n, "%s dummy %g", basename, gsl_vector_get(delmts,i));
             } else
-                sprintf(n, "%s", telmts[i]);
+                sprintf(n, "%s", (*factor_list)->text[i][0]);
             apop_name_add(out->names, n, 'c');
         }
+        free(basename);
     }
     if (delmts)
         gsl_vector_free(delmts);
-    if (telmts){
-        for (size_t j=0; j< elmt_ctr; j++)
-            free(telmts[j]);
-        free(telmts);
-    }
+    gsl_vector_free(codes);
     free(catname);
     return out;
 }
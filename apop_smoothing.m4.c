@@ -0,0 +1,190 @@
+/** \file apop_smoothing.c	A few smoothing-type functions, like moving averages. */
+
+/* Copyright (c) 2007 by Ben Klemens.  Licensed under the modified GNU GPL v2; see COPYING and COPYING2.  */
+
+#include "apop_internal.h"
+
+/* The running sums for a window: x is shifted by K before summing, and every
+   resync_every steps the sums are recomputed from scratch (with K reset to the
+   window's mean), so rounding error from the add-one/drop-one updates can't pile up
+   over a long series. A window holding any NaNs gives NaN. */
+typedef struct {
+    gsl_vector const *v, *w;
+    double K, s1, s2, sw;
+    size_t nan_ct;
+    char want_sq;
+} window_sums;
+
+static void window_in(window_sums *ws, size_t i, int sign){
+    double x = gsl_vector_get(ws->v, i);
+    double w = ws->w ? gsl_vector_get(ws->w, i) : 1;
+    if (isnan(x) || isnan(w)) {ws->nan_ct += sign; return;}
+    double d = x - ws->K;
+    ws->s1 += sign * w * d;
+    if (ws->want_sq) ws->s2 += sign * w * d * d;
+    ws->sw += sign * w;
+}
+
+static void window_resync(window_sums *ws, size_t lo, size_t width){
+    ws->K = ws->s1 = ws->s2 = ws->sw = ws->nan_ct = 0;
+    for (size_t i=lo; i< lo+width; i++) window_in(ws, i, 1);
+    if (ws->sw) ws->K = ws->s1/ws->sw;
+    ws->s1 = ws->s2 = ws->sw = ws->nan_ct = 0;
+    for (size_t i=lo; i< lo+width; i++) window_in(ws, i, 1);
+}
+
+static double window_stat(window_sums const *ws, char stat){
+    if (ws->nan_ct) return GSL_NAN;
+    if (stat == 's') return ws->s1 + ws->K * ws->sw;
+    if (stat == 'm') return ws->K + ws->s1/ws->sw;
+    //'v': frequency-weighted sample variance; the shift by K drops out.
+    return (ws->s2 - ws->s1*ws->s1/ws->sw)/(ws->sw - 1);
+}
+
+static void moving_moments(gsl_vector const *v, gsl_vector const *w, size_t width, char stat, gsl_vector *out){
+    window_sums ws = {.v=v, .w=w, .want_sq=(stat=='v')};
+    for (size_t i=0; i< out->size; i++){
+        if (!(i % width)) window_resync(&ws, i, width);
+        else {
+            window_in(&ws, i-1, -1);
+            window_in(&ws, i+width-1, 1);
+        }
+        gsl_vector_set(out, i, window_stat(&ws, stat));
+    }
+}
+
+/* Rolling min ('l') or max ('h') via a monotone deque of indices, held in a ring
+   buffer: each element enters and leaves the deque once, so this is O(n) for any width.
+   The front of the deque is the index of the window's extreme value. */
+static void moving_extreme(gsl_vector const *v, size_t width, char stat, gsl_vector *out){
+    size_t *deque = malloc(sizeof(size_t)*width);
+    size_t head = 0, len = 0, nan_ct = 0;
+    int sign = (stat == 'l') ? 1 : -1;
+    for (size_t j=0; j< v->size; j++){
+        double x = gsl_vector_get(v, j);
+        if (len && deque[head] + width <= j) {head = (head+1)%width; len--;}
+        if (isnan(x)) nan_ct++;
+        else {
+            while (len && sign*gsl_vector_get(v, deque[(head+len-1)%width]) >= sign*x) len--;
+            deque[(head+len++)%width] = j;
+        }
+        if (j < width-1) continue;
+        size_t lo = j-width+1;
+        gsl_vector_set(out, lo, (nan_ct || !len) ? GSL_NAN : gsl_vector_get(v, deque[head]));
+        if (isnan(gsl_vector_get(v, lo))) nan_ct--;
+    }
+    free(deque);
+}
+
+/** Return a new vector that is the moving average of the input vector.
+
+Each element of the output is the mean of the \c bandwidth elements centered on the
+corresponding element of the input, so the output is shorter than the input by \c
+bandwidth-1 elements (or \c bandwidth, if \c bandwidth is even, as the window is
+rounded up to an odd width). This is \ref apop_vector_moving_stat with the default
+<tt>.stat='m'</tt>, and takes time proportional to the length of the input, regardless
+of the bandwidth.
+
+ \param v The input vector, unsmoothed
+ \param bandwidth The number of elements to be smoothed. 
+ */
+gsl_vector *apop_vector_moving_average(gsl_vector *v, size_t bandwidth){
+    apop_assert_c(v,  NULL, 0, "You asked me to smooth a NULL vector; returning NULL.\n");
+    apop_assert_s(bandwidth, "Bandwidth must be >=1.\n");
+    return apop_vector_moving_stat(v, bandwidth);
+}
+
+/** Return a new vector giving a statistic for a window sliding along the input vector.
+
+Windows are as in \ref apop_vector_moving_average: element \f$i\f$ of the output
+summarizes elements \f$i\f$ through \f$i+2h\f$ of the input, where \f$h\f$ is
+<tt>bandwidth/2</tt> rounded down, so the output has \f$2h\f$ fewer elements than
+the input. Each window is updated by dropping one element and adding one, so the
+whole series takes time proportional to its length, not to length times bandwidth.
+
+\code
+gsl_vector *avg = apop_vector_moving_stat(sensor, 1001);
+gsl_vector *sd  = apop_vector_moving_stat(sensor, 1001, .stat='v');
+gsl_vector *top = apop_vector_moving_stat(sensor, 1001, .stat='h');
+\endcode
+
+\param v The input vector (No default; must not be \c NULL)
+\param bandwidth The width of the window. (Default: 3)
+\param stat <tt>'m'</tt>: mean; <tt>'s'</tt>: sum; <tt>'v'</tt>: sample variance;
+<tt>'l'</tt>: lowest value; <tt>'h'</tt>: highest value. (Default: <tt>'m'</tt>)
+\param weights If not \c NULL, a vector of the same size as \c v giving a weight for
+each element, for weighted sums, means, and variances. As with \ref
+apop_vector_weighted_var given weights summing to more than one, the variance reads the
+weights as frequencies, dividing by the window's total weight minus one. The min and
+max ignore the weights. (Default: \c NULL)
+\return A new vector of length <tt>v->size - 2h</tt>, or \c NULL on error.
+
+\li A window including a \c NaN (in the data or the weights) gives \c NaN.
+\li The sums are rebuilt from scratch once per window width, so rounding error doesn't
+build up over long series.
+\li This function uses the \ref designated syntax for inputs.
+\see apop_vector_ewma
+*/
+APOP_VAR_HEAD gsl_vector * apop_vector_moving_stat(gsl_vector const *v, size_t bandwidth, char stat, gsl_vector const *weights){
+    gsl_vector const * apop_varad_var(v, NULL);
+    Apop_stopif(!v, return NULL, 0, "You asked me to smooth a NULL vector; returning NULL.");
+    size_t apop_varad_var(bandwidth, 3);
+    char apop_varad_var(stat, 'm');
+    gsl_vector const * apop_varad_var(weights, NULL);
+APOP_VAR_ENDHEAD
+    Apop_stopif(!bandwidth, return NULL, 0, "Bandwidth must be >=1. Returning NULL.");
+    Apop_stopif(!strchr("msvlh", stat), return NULL, 0, "I don't know the statistic '%c'; "
+                    "use 'm', 's', 'v', 'l', or 'h'. Returning NULL.", stat);
+    Apop_stopif(weights && weights->size != v->size, return NULL, 0, "data vector has size %zu; "
+                    "weighting vector has size %zu. Returning NULL.", v->size, weights->size);
+    size_t width = (bandwidth/2)*2 + 1;
+    Apop_stopif(width > v->size, return NULL, 0, "A window of width %zu is longer than the "
+                    "vector (size %zu). Returning NULL.", width, v->size);
+    gsl_vector *out = gsl_vector_alloc(v->size - width + 1);
+    if (stat == 'l' || stat == 'h') moving_extreme(v, width, stat, out);
+    else moving_moments(v, weights, width, stat, out);
+    return out;
+}
+
+/** Return a new vector giving the exponentially-weighted moving mean or variance of
+the input vector.
+
+The mean starts at the first element, and then \f$m_t = m_{t-1} + \alpha (x_t - m_{t-1})\f$.
+The variance starts at zero, and then \f$s^2_t = (1-\alpha)(s^2_{t-1} + \alpha (x_t - m_{t-1})^2)\f$.
+Larger \f$\alpha\f$ means the average tracks recent elements more closely.
+
+\param v The input vector (No default; must not be \c NULL)
+\param alpha The weight on the newest element, in (0, 1]. (Default: 0.1)
+\param stat <tt>'m'</tt>: mean; <tt>'v'</tt>: variance. (Default: <tt>'m'</tt>)
+\return A new vector the same size as \c v, or \c NULL on error.
+
+\li A \c NaN in the input leaves the mean and variance unchanged, and the output
+repeats the prior value. Outputs before the first non-\c NaN element are \c NaN.
+\li This function uses the \ref designated syntax for inputs.
+\see apop_vector_moving_stat
+*/
+APOP_VAR_HEAD gsl_vector * apop_vector_ewma(gsl_vector const *v, double alpha, char stat){
+    gsl_vector const * apop_varad_var(v, NULL);
+    Apop_stopif(!v, return NULL, 0, "You asked me to smooth a NULL vector; returning NULL.");
+    double apop_varad_var(alpha, 0.1);
+    char apop_varad_var(stat, 'm');
+APOP_VAR_ENDHEAD
+    Apop_stopif(!(alpha > 0 && alpha <= 1), return NULL, 0, "alpha must be in (0, 1], "
+                    "but it's %g. Returning NULL.", alpha);
+    Apop_stopif(stat != 'm' && stat != 'v', return NULL, 0, "I don't know the statistic '%c'; "
+                    "use 'm' or 'v'. Returning NULL.", stat);
+    gsl_vector *out = gsl_vector_alloc(v->size);
+    double mean = GSL_NAN, var = GSL_NAN;
+    for (size_t i=0; i< v->size; i++){
+        double x = gsl_vector_get(v, i);
+        if (isnan(x)) ;
+        else if (isnan(mean)) {mean = x; var = 0;}
+        else {
+            double d = x - mean;
+            mean += alpha * d;
+            var = (1-alpha) * (var + alpha*d*d);
+        }
+        gsl_vector_set(out, i, stat=='m' ? mean : var);
+    }
+    return out;
+}
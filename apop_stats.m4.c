@@ -399,20 +399,140 @@ void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var)
     *var  = avg2 - gsl_pow_2(avg); //E[x^2] - E^2[x]
 }
 
+/* Return the kth-smallest of the n elements of x, partially reordering x (that is, C++'s
+   nth_element). Median-of-three quickselect, falling back to a sort of what's left if the
+   partitions keep coming out lopsided. */
+static int compare_summary_doubles(const void *a, const void *b){
+    return (*(double const*)a > *(double const*)b) - (*(double const*)a < *(double const*)b);
+}
+
+static double select_kth(double *x, size_t n, size_t k){
+    ptrdiff_t lo = 0, hi = n-1;
+    for (int rounds=0; hi > lo; rounds++){
+        if (rounds > 64){
+            qsort(x+lo, hi-lo+1, sizeof(double), compare_summary_doubles);
+            break;
+        }
+        double a = x[lo], b = x[lo + (hi-lo)/2], c = x[hi];
+        double pivot = a < b ? (b < c ? b : (a < c ? c : a))
+                             : (a < c ? a : (b < c ? c : b));
+        ptrdiff_t i = lo, j = hi;
+        while (i <= j){
+            while (x[i] < pivot) i++;
+            while (x[j] > pivot) j--;
+            if (i <= j){
+                double tmp = x[i]; x[i] = x[j]; x[j] = tmp;
+                i++; j--;
+            }
+        }
+        //Now x[lo..j] <= pivot, x[i..hi] >= pivot, and anything between equals the pivot.
+        if ((ptrdiff_t)k <= j) hi = j;
+        else if ((ptrdiff_t)k >= i) lo = i;
+        else return x[k];
+    }
+    return x[k];
+}
+
+/* apop_data_summarize does one column per pooled task, and each task writes only its own
+   row of the output. A column is read once, into a contiguous copy, picking up the mean,
+   min, and max (and the weighted sums) along the way; the variance is a pass over the
+   copy, and the median is a selection on the copy. NaNs are put at the end of the copy,
+   as if they sort last. The unweighted mean and variance are calculated as by
+   gsl_stats_mean and gsl_stats_variance_m, so they match apop_vector_mean and
+   apop_vector_var_m exactly.
+
+   With approx=='y', there's no copy: the variance is a running (Welford) sum of
+   squares, and the median comes from a quantile sketch built in the same pass. */
+typedef struct {
+    gsl_matrix const *in;
+    gsl_vector const *w;
+    gsl_matrix *out;
+    char approx;
+} summarypass;
+
+static void summarize_col(summarypass const *sp, size_t col){
+    size_t n = sp->in->size1, nonnan = 0, nan_ct = 0;
+    int approx = (sp->approx == 'y');
+    double *copy = approx ? NULL : malloc(sizeof(double)*GSL_MAX(n, 1));
+    apop_quantile_sketch *sketch = approx ? apop_quantile_sketch_alloc() : NULL;
+    double min = GSL_NAN, max = GSL_NAN, mean, var;
+    long double runmean = 0, sumsq = 0, wx = 0, wxx = 0, wsum = 0;
+    for (size_t i=0; i< n; i++){
+        double x = gsl_matrix_get(sp->in, i, col);
+        long double delta = x - runmean;
+        runmean += delta/(i+1);
+        if (approx) sumsq += delta * (x - runmean);
+        if (sp->w){
+            long double w = gsl_vector_get(sp->w, i);
+            wx   += w * x;
+            wxx  += w * gsl_pow_2(x);
+            wsum += w;
+        }
+        if (gsl_isnan(x)){
+            nan_ct++;
+            if (!approx) copy[n - nan_ct] = x;
+            continue;
+        }
+        if (!nonnan || x < min) min = x;
+        if (!nonnan || x > max) max = x;
+        if (approx) apop_quantile_sketch_add(sketch, x);
+        else copy[nonnan] = x;
+        nonnan++;
+    }
+    if (nan_ct) max = GSL_NAN;
+    if (!sp->w){
+        mean = runmean;
+        var = approx ? sumsq/(n-1.) : gsl_stats_variance_m(copy, 1, n, mean);
+    } else {
+        double len = (wsum < 1.1 ? n : wsum);
+        mean = wx/wsum;
+        var = (wxx/len - gsl_pow_2(wx/len)) * len/(len -1.);
+    }
+    size_t mid = (n-1)/2; //as per apop_vector_percentiles(v)[50], which rounds down.
+    double median = (!n || mid >= nonnan) ? GSL_NAN
+                  : approx ? apop_quantile_sketch_quantile(sketch, (mid + 0.5)/nonnan)
+                  : select_kth(copy, nonnan, mid);
+    free(copy);
+    apop_quantile_sketch_free(sketch);
+    double row[] = {mean, sqrt(var), var, min, median, max};
+    for (int j=0; j< 6; j++) gsl_matrix_set(sp->out, col, j, row[j]);
+}
+
+static void summarize_chunk(void *ctx, size_t lo, size_t hi, int worker){
+    for (size_t col=lo; col< hi; col++) summarize_col(ctx, col);
+}
+
 /** Put summary information about the columns of a table (mean, std dev, variance, min, median, max) in a table.
 
-\param indata The table to be summarized. An \ref apop_data structure.
-\return     An \ref apop_data structure with one row for each column in the original table, and a column for each summary statistic. May have a <tt>weights</tt> element.
+\param indata The table to be summarized. An \ref apop_data structure. May have a <tt>weights</tt> element.
+\param approx If \c 'y', find the median via an \ref apop_quantile_sketch_alloc "approximate
+quantile sketch", built in the same pass over each column as the mean, min, and max,
+rather than via a selection on a copy of the column. This saves a copy of each column,
+at the cost of a median that is typically within a few tenths of a percentile (in
+rank) of the exact one. The variance is then a running sum of squares, which may
+differ from the exact version in the last few digits. (Default: \c 'n')
+\return     An \ref apop_data structure with one row for each column in the original table, and a column for each summary statistic.
 \exception out->error='a'  Allocation error.
 
 \li This function gives more columns than you probably want; use \ref apop_data_prune_columns to pick the ones you want to see.
+\li The min, median, and max are the same as <tt>apop_vector_percentiles(v)[0]</tt>,
+<tt>[50]</tt>, and <tt>[100]</tt>, but there is no full sort: the min and max come from the
+same pass over the data as the mean, and the median is found via a selection algorithm. NaNs
+count as greater than every number.
+\li The columns are split among threads given <tt>\ref apop_opts_type "apop_opts".thread_count > 1</tt>.
+\li This function uses the \ref designated syntax for inputs.
 \todo We should probably let this summarize rows as well. 
 \ingroup    output */
-apop_data * apop_data_summarize(apop_data *indata){
+APOP_VAR_HEAD apop_data * apop_data_summarize(apop_data *indata, char approx){
+    apop_data * apop_varad_var(indata, NULL);
+    char apop_varad_var(approx, 'n');
+APOP_VAR_ENDHEAD
     Apop_assert_c(indata, NULL, 0, "You sent me a NULL apop_data set. Returning NULL.");
     Apop_assert_c(indata->matrix, NULL, 0, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
+    Apop_stopif(indata->weights && indata->weights->size != indata->matrix->size1, return NULL, 0,
+            "The data has %zu rows but the weighting vector has size %zu. Returning NULL.",
+            indata->matrix->size1, indata->weights->size);
     apop_data *out = apop_data_alloc(indata->matrix->size2, 6);
-    double mean, var;
     char rowname[10000]; //crashes on more than 10^9995 columns.
 	apop_name_add(out->names, "mean", 'c');
 	apop_name_add(out->names, "std dev", 'c');
@@ -434,24 +554,10 @@ apop_data * apop_data_summarize(apop_data *indata){
 			sprintf(rowname, "col %zu", i);
 			apop_name_add(out->names, rowname, 'r');
 		}
-	for (size_t i=0; i< indata->matrix->size2; i++){
-        Apop_matrix_col(indata->matrix, i, v);
-        if (!indata->weights){
-            mean	= apop_vector_mean(v);
-            var 	= apop_vector_var_m(v,mean);
-        } else {
-            mean	= apop_vector_weighted_mean(v,indata->weights);
-            var 	= apop_vector_weighted_var(v,indata->weights);
-        } 
-        double *pctiles = apop_vector_percentiles(v);
-		gsl_matrix_set(out->matrix, i, 0, mean);
-		gsl_matrix_set(out->matrix, i, 1, sqrt(var));
-		gsl_matrix_set(out->matrix, i, 2, var);
-		gsl_matrix_set(out->matrix, i, 3, pctiles[0]);
-		gsl_matrix_set(out->matrix, i, 4, pctiles[50]);
-		gsl_matrix_set(out->matrix, i, 5, pctiles[100]);
-        free(pctiles);
-	}
+    summarypass sp = {.in=indata->matrix, .w=indata->weights, .out=out->matrix, .approx=approx};
+    size_t cols = indata->matrix->size2;
+    if (apop_opts.thread_count <= 1) summarize_chunk(&sp, 0, cols, 0);
+    else apop_pool_run(summarize_chunk, &sp, cols, 1);
 	return out;
 }
 
@@ -574,11 +680,77 @@ double apop_vector_weighted_cov(const gsl_vector *v1, const gsl_vector *v2, cons
     return (sumsq/len  - sum1*sum2/gsl_pow_2(len)) *(len/(len-1));
 }
 
+/* apop_data_covariance centers the data once and then finds X'X as a set of column
+   blocks: a dsyrk for each block on the diagonal and a dgemm for each block above it.
+   Each block of the output is written by exactly one task. The column sums are taken
+   in chunks of apop_pool_fixed_chunk rows, each to its own slot, with the slots added
+   in order, so the means are bit-for-bit the same with or without threads. */
+typedef struct {
+    gsl_matrix const *in;
+    gsl_vector const *w;
+    gsl_matrix *centered, *out;
+    long double *sums;  //p+1 per chunk: the weighted column sums, then the total weight.
+    double *means;
+    size_t chunk, block;
+} covpass;
+
+static void cov_sum_chunk(void *ctx, size_t lo, size_t hi, int worker){
+    covpass *cp = ctx;
+    size_t p = cp->in->size2;
+    long double *sums = cp->sums + (lo/cp->chunk)*(p+1);
+    for (size_t i=lo; i< hi; i++){
+        double w = cp->w ? gsl_vector_get(cp->w, i) : 1;
+        double const *row = gsl_matrix_const_ptr(cp->in, i, 0);
+        for (size_t j=0; j< p; j++) sums[j] += w * row[j];
+        sums[p] += w;
+    }
+}
+
+static void cov_center_chunk(void *ctx, size_t lo, size_t hi, int worker){
+    covpass *cp = ctx;
+    for (size_t i=lo; i< hi; i++){
+        double sqrtw = cp->w ? sqrt(gsl_vector_get(cp->w, i)) : 1;
+        double const *row = gsl_matrix_const_ptr(cp->in, i, 0);
+        double *out = gsl_matrix_ptr(cp->centered, i, 0);
+        for (size_t j=0; j< cp->in->size2; j++) out[j] = (row[j] - cp->means[j]) * sqrtw;
+    }
+}
+
+//Task t is the t-th block of the upper triangle, counting across rows of blocks.
+static void cov_block_chunk(void *ctx, size_t lo, size_t hi, int worker){
+    covpass *cp = ctx;
+    gsl_matrix *out = cp->out;
+    size_t p = out->size2, n = cp->centered->size1, nb = (p + cp->block - 1)/cp->block;
+    for (size_t t=lo; t< hi; t++){
+        size_t bi = 0, tasks = t;
+        while (tasks >= nb - bi) tasks -= nb - bi++;
+        size_t bj = bi + tasks;
+        size_t i0 = bi*cp->block, j0 = bj*cp->block,
+               iw = GSL_MIN(cp->block, p-i0), jw = GSL_MIN(cp->block, p-j0);
+        gsl_matrix_view xi = gsl_matrix_submatrix(cp->centered, 0, i0, n, iw),
+                        xj = gsl_matrix_submatrix(cp->centered, 0, j0, n, jw),
+                        oij = gsl_matrix_submatrix(out, i0, j0, iw, jw);
+        if (bi == bj) gsl_blas_dsyrk(CblasUpper, CblasTrans, 1, &xi.matrix, 0, &oij.matrix);
+        else gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, &xi.matrix, &xj.matrix, 0, &oij.matrix);
+    }
+}
+
+static void covpass_run(apop_pool_fn *fn, covpass *cp, size_t n, size_t chunk){
+    if (apop_opts.thread_count <= 1) for (size_t lo=0; lo< n; lo+=chunk) fn(cp, lo, GSL_MIN(n, lo+chunk), 0);
+    else apop_pool_run(fn, cp, n, chunk);
+}
+
 /** Returns the sample variance/covariance matrix relating each column of the matrix to each other column.
 
 \param in 	An \ref apop_data set. If the weights vector is set, I'll take it into account.
 
 \li This is the sample covariance---dividing by \f$n-1\f$, not \f$n\f$.
+\li The weights are read as per \ref apop_vector_weighted_var, and each element of the
+output matches \ref apop_vector_weighted_cov of the corresponding pair of columns.
+\li I make one copy of the data, centered (and scaled by the square root of the weights),
+and find the cross products in blocks of columns, which is much faster than taking the
+columns a pair at a time when there are many columns. Given <tt>\ref apop_opts_type
+"apop_opts".thread_count > 1</tt>, the blocks are split among threads.
 
 \return Returns a \ref apop_data set the variance/covariance matrix relating each column with each other.
 \exception out->error='a'  Allocation error.
@@ -586,19 +758,50 @@ double apop_vector_weighted_cov(const gsl_vector *v1, const gsl_vector *v2, cons
 apop_data *apop_data_covariance(const apop_data *in){
     Apop_assert_c(in,  NULL, 1, "You sent me a NULL apop_data set. Returning NULL.");
     Apop_assert_c(in->matrix,  NULL, 1, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
-    apop_data *out = apop_data_alloc(in->matrix->size2, in->matrix->size2);
+    Apop_stopif(in->weights && in->weights->size != in->matrix->size1, return NULL, 0,
+            "The data has %zu rows but the weighting vector has size %zu. Returning NULL.",
+            in->matrix->size1, in->weights->size);
+    size_t n = in->matrix->size1, p = in->matrix->size2;
+    apop_data *out = apop_data_alloc(p, p);
     Apop_stopif(out->error, return out, 0, "allocation error.");
-    for (size_t i=0; i < in->matrix->size2; i++){
-        for (size_t j=i; j < in->matrix->size2; j++){
-            Apop_col(in, i, v1);
-            Apop_col(in, j, v2);
-            double var = apop_vector_weighted_cov(v1, v2, in->weights);
-            gsl_matrix_set(out->matrix, i,j, var);
-            if (i!=j) gsl_matrix_set(out->matrix, j,i, var);
+    Apop_stopif(n < 2, gsl_matrix_set_all(out->matrix, GSL_NAN); return out, 1,
+            "I need at least two rows of data to find a sample covariance. Returning NaNs.");
+    size_t chunk = apop_pool_fixed_chunk(n), chunk_ct = (n + chunk - 1)/chunk;
+    covpass cp = {.in=in->matrix, .w=in->weights, .out=out->matrix, .chunk=chunk, .block=64,
+                  .sums=calloc(chunk_ct*(p+1), sizeof(long double)),
+                  .means=malloc(sizeof(double)*p), .centered=gsl_matrix_alloc(n, p)};
+    Apop_stopif(!cp.sums || !cp.means || !cp.centered, out->error='a'; goto done, 0, "allocation error.");
+
+    covpass_run(cov_sum_chunk, &cp, n, chunk);
+    long double *colsums = cp.sums; //add the other chunks' sums to the first's, in order.
+    for (size_t c=1; c< chunk_ct; c++)
+        for (size_t j=0; j<= p; j++) colsums[j] += cp.sums[c*(p+1) + j];
+    long double wsum = colsums[p];
+    for (size_t j=0; j< p; j++) cp.means[j] = colsums[j]/wsum;
+    covpass_run(cov_center_chunk, &cp, n, chunk);
+
+    size_t nb = (p + cp.block - 1)/cp.block;
+    covpass_run(cov_block_chunk, &cp, nb*(nb+1)/2, 1);
+
+    //Fill in the lower triangle and divide by n-1. If the weights sum to about one, the
+    //count is the number of rows, and the sum of cross-products differs from the centered
+    //form by (1/wsum - 1/len) * (sum x_i)(sum x_j), as in apop_vector_weighted_cov.
+    double len = (!in->weights || wsum >= 1.1) ? wsum : n;
+    double correction = (1/wsum - 1/len);
+    for (size_t i=0; i< p; i++)
+        for (size_t j=i; j< p; j++){
+            double cov = (gsl_matrix_get(out->matrix, i, j)
+                            + (correction ? correction * colsums[i] * colsums[j] : 0)) / (len-1);
+            gsl_matrix_set(out->matrix, i, j, cov);
+            gsl_matrix_set(out->matrix, j, i, cov);
         }
-    }
     apop_name_stack(out->names, in->names, 'c');
     apop_name_stack(out->names, in->names, 'r', 'c');
+
+    done:
+    free(cp.sums);
+    free(cp.means);
+    if (cp.centered) gsl_matrix_free(cp.centered);
     return out;
 }
 
@@ -606,19 +809,21 @@ apop_data *apop_data_covariance(const apop_data *in){
 
 \param in 	A data matrix: rows are observations, columns are variables. If you give me a weights vector, I'll use it.
 
+\li This is \ref apop_data_covariance, with each row and column rescaled in place by the
+standard deviations on its diagonal.
+
 \return Returns the variance/covariance matrix relating each column with each other. This function allocates the matrix for you.
 \exception out->error='a'  Allocation error.
 \ingroup matrix_moments */
 apop_data *apop_data_correlation(const apop_data *in){
     apop_data *out = apop_data_covariance(in);
-    for(size_t i=0; i< in->matrix->size2; i++){
-        Apop_col(in, i, cvin);
-        Apop_col(out, i, cvout);
-        Apop_row(out, i, rvout);
-        double std_dev = sqrt(apop_vector_weighted_var(cvin, in->weights));
-        gsl_vector_scale(cvout, 1.0/std_dev);
-        gsl_vector_scale(rvout, 1.0/std_dev);
-    }
+    if (!out || out->error) return out;
+    size_t p = out->matrix->size1;
+    double inv_sd[p];
+    for (size_t i=0; i< p; i++) inv_sd[i] = 1/sqrt(gsl_matrix_get(out->matrix, i, i));
+    for (size_t i=0; i< p; i++)
+        for (size_t j=0; j< p; j++)
+            *gsl_matrix_ptr(out->matrix, i, j) *= inv_sd[i] * inv_sd[j];
     return out;
 }
 
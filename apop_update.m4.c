@@ -9,6 +9,7 @@ Apop_settings_init(apop_update,
    Apop_varad_set(periods, 6e3);
    Apop_varad_set(burnin, 0.05);
    Apop_varad_set(method, 'd'); //default
+   Apop_varad_set(chain_count, 1);
    //all else defaults to zero/NULL
 )
 
@@ -87,6 +88,213 @@ likelihood. If you give me a parametrized normal, with no data, then I'll take t
     return outp;
 }
 
+typedef struct {
+    apop_data *data, *out;
+    apop_model *prior, *likelihood;
+    apop_update_settings *s;
+    gsl_rng *rng;
+    long int first_row, accept_count;
+} chain_pass;
+
+/* The original sampler: every proposal is a fresh draw from the prior, so the
+   acceptance odds are just the likelihood ratio. */
+static void independence_chain(chain_pass *cp){
+    apop_update_settings *s = cp->s;
+    apop_model *likelihood = cp->likelihood, *prior = cp->prior;
+    gsl_rng *rng = cp->rng;
+    Get_vmsizes(likelihood->parameters) //vsize, msize1, msize2
+    double    ratio, ll, cp_ll = GSL_NEGINF;
+    double    *draw          = malloc(sizeof(double)* (vsize+msize1*msize2));
+    apop_data *current_param = apop_data_alloc(vsize , msize1, msize2);
+
+    apop_draw(draw, rng, prior); //set starting point.
+    apop_data_fill_base(current_param, draw);
+
+    for (int i=0; i< s->periods; i++){     //main loop
+        newdraw:
+        apop_draw(draw, rng, prior);
+        apop_data_fill_base(likelihood->parameters, draw);
+        ll = apop_log_likelihood(cp->data, likelihood);
+
+        Apop_notify(3, "ll=%g for parameters:\t", ll);
+        if (apop_opts.verbose >=3) apop_data_print(likelihood->parameters);
+
+        Apop_stopif(gsl_isnan(ll), goto newdraw, 
+                1, "Trouble evaluating the "
+                "likelihood function at vector beginning with %g. "
+                "Throwing it out and trying again.\n"
+                , likelihood->parameters->vector->data[0]);
+        ratio = ll - cp_ll;
+        if (ratio >= 0 || log(gsl_rng_uniform(rng)) < ratio){
+            apop_data_memcpy(current_param, likelihood->parameters);
+            cp_ll = ll;
+            cp->accept_count++;
+        } else {
+            Apop_notify(3, "reject, with exp(ll_now-ll_prior) = exp(%g-%g) = %g.", ll, cp_ll, exp(ratio));
+        }
+        if (i >= s->periods * s->burnin){
+            Apop_row(cp->out, cp->first_row + i-(s->periods *s->burnin), v)
+            apop_data_pack(current_param, v);
+        }
+    }
+    apop_data_free(current_param);
+    free(draw);
+}
+
+/* In-place lower-triangular Cholesky factor. Returns nonzero if the matrix isn't
+   positive definite, in which case the caller keeps its old factor. This is
+   run from inside threads, so it doesn't go via the GSL's global error handler. */
+static int chol_lower(gsl_matrix *a){
+    size_t n = a->size1;
+    for (size_t j=0; j< n; j++){
+        double s = gsl_matrix_get(a, j, j);
+        for (size_t k=0; k< j; k++) s -= gsl_pow_2(gsl_matrix_get(a, j, k));
+        if (!(s > 0)) return 1;
+        double d = sqrt(s);
+        gsl_matrix_set(a, j, j, d);
+        for (size_t i=j+1; i< n; i++){
+            double t = gsl_matrix_get(a, i, j);
+            for (size_t k=0; k< j; k++) t -= gsl_matrix_get(a, i, k) * gsl_matrix_get(a, j, k);
+            gsl_matrix_set(a, i, j, t/d);
+        }
+        for (size_t i=0; i< j; i++) gsl_matrix_set(a, i, j, 0);
+    }
+    return 0;
+}
+
+//Log posterior, up to a constant: log prior + log likelihood.
+static double log_posterior(apop_data *pt, chain_pass *cp){
+    double lp = apop_log_likelihood(pt, cp->prior);
+    if (gsl_isnan(lp) || gsl_isinf(lp)==-1) return GSL_NEGINF;
+    apop_data_fill_base(cp->likelihood->parameters, pt->matrix->data);
+    return lp + apop_log_likelihood(cp->data, cp->likelihood);
+}
+
+/* Adaptive random-walk Metropolis. Proposals are current + scale * L z, with z
+   iid N(0,1). During burn-in, L L' tracks the covariance of the chain so far (at the
+   outset, it is the diagonal of the spread of some prior draws), and the log scale
+   follows a Robbins-Monro step toward an acceptance rate of 0.234. After burn-in,
+   the proposal is fixed, so the recorded chain is a plain Metropolis chain. */
+static void rw_chain(chain_pass *cp){
+    apop_update_settings *s = cp->s;
+    gsl_rng *rng = cp->rng;
+    Get_vmsizes(cp->likelihood->parameters) //vsize, msize1, msize2
+    int n = vsize+msize1*msize2, tries = 0, have_cov = 0;
+    long int burn = ceil(s->periods * s->burnin);
+    apop_data *current = apop_data_alloc(1, n), *proposal = apop_data_alloc(1, n);
+    Apop_matrix_row(current->matrix, 0, cur);
+    Apop_matrix_row(proposal->matrix, 0, prop);
+    gsl_vector *mean = gsl_vector_calloc(n), *z = gsl_vector_alloc(n);
+    gsl_matrix *sumsq = gsl_matrix_calloc(n, n), *chol = gsl_matrix_calloc(n, n),
+               *newchol = gsl_matrix_alloc(n, n);
+
+    //Initial proposal: independent, with the spread of 10n draws from the prior.
+    int prior_draws = 10*n;
+    for (int k=1; k<= prior_draws; k++){
+        apop_draw(prop->data, rng, cp->prior);
+        for (int j=0; j< n; j++){
+            double delta = prop->data[j] - mean->data[j];
+            mean->data[j] += delta/k;
+            *gsl_matrix_ptr(sumsq, j, j) += delta*(prop->data[j] - mean->data[j]);
+        }
+    }
+    for (int j=0; j< n; j++){
+        double var = gsl_matrix_get(sumsq, j, j)/(prior_draws-1.);
+        gsl_matrix_set(chol, j, j, (var > 0 && !gsl_isinf(var)) ? sqrt(var) : 1);
+    }
+    gsl_vector_set_zero(mean);
+    gsl_matrix_set_zero(sumsq);
+    double log_scale = log(2.38/sqrt(n));
+
+    double cur_ll;
+    do {
+        apop_draw(cur->data, rng, cp->prior); //set starting point.
+        cur_ll = log_posterior(current, cp);
+    } while ((gsl_isnan(cur_ll) || gsl_isinf(cur_ll)) && tries++ < 1000);
+    Apop_stopif(gsl_isnan(cur_ll) || gsl_isinf(cur_ll), , 1, "Couldn't find a starting point "
+            "with finite posterior density after 1,000 draws from the prior. Starting anyway.");
+
+    for (long int i=0; i< s->periods; i++){
+        for (int j=0; j< n; j++) z->data[j] = gsl_ran_gaussian(rng, 1);
+        gsl_vector_memcpy(prop, cur);
+        gsl_blas_dgemv(CblasNoTrans, exp(log_scale), chol, z, 1, prop);
+        double ll = log_posterior(proposal, cp);
+
+        Apop_notify(3, "ll=%g for parameters:\t", ll);
+        if (apop_opts.verbose >=3) apop_data_print(proposal);
+
+        double ratio = ll - cur_ll;
+        int accept = !gsl_isnan(ll) && (ratio >= 0 || log(gsl_rng_uniform(rng)) < ratio);
+        if (accept){
+            gsl_vector_memcpy(cur, prop);
+            cur_ll = ll;
+            cp->accept_count++;
+        } else
+            Apop_notify(3, "reject, with exp(ll_now-ll_prior) = exp(%g-%g) = %g.", ll, cur_ll, exp(ratio));
+
+        if (i < burn){ //adapt
+            log_scale += pow(i+1, -0.6) * (accept - 0.234);
+            long int t = i+1;
+            gsl_vector_memcpy(z, cur);
+            gsl_vector_sub(z, mean);              //z = x - old mean
+            gsl_blas_daxpy(1./t, z, mean);
+            for (int j=0; j< n; j++)
+                for (int k=0; k<= j; k++)
+                    *gsl_matrix_ptr(sumsq, j, k) += z->data[j] * (cur->data[k] - mean->data[k]);
+            if (t % 100 == 0 && t > 2*n){
+                double eps = 0;
+                for (int j=0; j< n; j++) eps += gsl_matrix_get(sumsq, j, j);
+                eps = 1e-8 * (eps/(n*(t-1.)) + 1e-10);
+                for (int j=0; j< n; j++)
+                    for (int k=0; k<= j; k++)
+                        gsl_matrix_set(newchol, j, k, gsl_matrix_get(sumsq, j, k)/(t-1.) + (j==k ? eps : 0));
+                if (!chol_lower(newchol)){
+                    gsl_matrix_memcpy(chol, newchol);
+                    if (!have_cov++) log_scale = log(2.38/sqrt(n));
+                }
+            }
+        } else gsl_matrix_set_row(cp->out->matrix, cp->first_row + i - burn, cur);
+    }
+    apop_data_free(current);
+    apop_data_free(proposal);
+    gsl_vector_free(mean);
+    gsl_vector_free(z);
+    gsl_matrix_free(sumsq);
+    gsl_matrix_free(chol);
+    gsl_matrix_free(newchol);
+}
+
+typedef struct {
+    chain_pass *chains;
+    int lo, hi;
+} chain_block;
+
+static void *chain_loop(void *in){
+    chain_block *b = in;
+    for (int c=b->lo; c< b->hi; c++)
+        (b->chains[c].s->method == 'r' ? rw_chain : independence_chain)(b->chains+c);
+    return NULL;
+}
+
+/* Split-R-hat (Gelman et al.): cut each chain in half, and compare the variance of
+   the half-chain means to the mean of the within-half variances. Near one means the
+   chains have mixed. */
+static double split_rhat(gsl_matrix *out, int col, int chain_count, long int kept){
+    long int m = kept/2;
+    int seqs = 2*chain_count;
+    double means[seqs], w = 0;
+    for (int q=0; q< seqs; q++){
+        long int start = (q/2)*kept + (q%2)*m;
+        Apop_matrix_col(out, col, thiscol);
+        gsl_vector_view seq = gsl_vector_subvector(thiscol, start, m);
+        means[q] = apop_vector_mean(&seq.vector);
+        w += apop_vector_var(&seq.vector)/seqs;
+    }
+    gsl_vector_view mv = gsl_vector_view_array(means, seqs);
+    double b_over_m = apop_vector_var(&mv.vector);
+    return sqrt(((m-1.)/m * w + b_over_m)/w);
+}
+
 /** Take in a prior and likelihood distribution, and output a posterior distribution.
 
 This function first checks a table of conjugate distributions for the pair you
@@ -110,6 +318,26 @@ undefined when this exits. This may be settled at a later date.
 
 \li If you set <tt>apop_opts.verbose=2</tt>, I will report the accept rate of the Gibbs sampler. It is a common rule of thumb to select a prior so that this is between 20% and 50%. Set <tt>apop_opts.verbose=3</tt> to see the proposal points, their likelihoods, and the acceptance odds.
 
+\li By default, each proposal is a fresh draw from the prior. If the posterior is much
+tighter than the prior, few of these will be accepted. Set <tt>.method='r'</tt> in the
+\ref apop_update_settings group to use an adaptive random-walk Metropolis sampler instead:
+each proposal is a step from the current point, and the proposal covariance and step size
+adapt during the burn-in to the chain's own history, toward an acceptance rate of about
+23%. This sampler needs the prior's density (via \c log_likelihood or \c p), and so
+won't work with a discrete prior like the PMF output of a prior run of this function.
+
+\li Set <tt>.chain_count</tt> in the \ref apop_update_settings group to run several
+chains, each from its own starting draw and for \c periods steps. They run in parallel
+if <tt>apop_opts.thread_count</tt> is greater than one, in which case the prior and
+likelihood models' methods have to be thread-safe (not the case for a model from
+\ref apop_model_fix_params, whose copies all share one base model). Each chain gets its own RNG, seeded in
+turn from \c rng. The output PMF pools the post-burn-in draws of every chain.
+
+\li The output model's \c info page lists the acceptance rate of each chain
+(<tt>accept rate, chain 0</tt>, ...) and the split-\f$\hat R\f$ convergence statistic
+for each element of the packed parameters (<tt>R-hat 0</tt>, ...). Values near one
+indicate that the chains, and the halves of each chain, agree.
+
 Here are the conjugate distributions currently defined:
 
 <table>
@@ -166,6 +394,9 @@ APOP_VAR_END_HEAD
 
     apop_update_settings *s = apop_settings_get_group(prior, apop_update);
     if (!s) s = Apop_model_add_group(prior, apop_update);
+    Apop_stopif(s->method == 'r' && !prior->log_likelihood && !prior->p, return NULL, 0,
+            "The random-walk sampler needs the prior's density, but your prior "
+            "has neither a log_likelihood nor a p method.");
     int ll_is_a_copy=0;
     if (!likelihood->parameters){
         if ( likelihood->vbase  >= 0 &&     // A hackish indication that
@@ -178,50 +409,55 @@ APOP_VAR_END_HEAD
         likelihood->parameters = apop_data_alloc(likelihood->vbase, likelihood->m1base, likelihood->m2base);
     }
     Get_vmsizes(likelihood->parameters) //vsize, msize1, msize2
-    double    ratio, ll, cp_ll = GSL_NEGINF;
-    double    *draw          = malloc(sizeof(double)* (vsize+msize1*msize2));
-    apop_data *current_param = apop_data_alloc(vsize , msize1, msize2);
     Apop_stopif(s->burnin > 1, s->burnin/=(s->periods+0.0), 
                 1, "Burn-in should be a fraction of the number of periods, "
                     "not a whole number of periods. Rescaling to burnin=%g", s->burnin/=(s->periods+0.0));
-    apop_data *out = apop_data_alloc(s->periods*(1-s->burnin), vsize+msize1*msize2);
-    int accept_count = 0;
-
-    apop_draw(draw, rng, prior); //set starting point.
-    apop_data_fill_base(current_param, draw);
+    int chain_count = GSL_MAX(s->chain_count, 1);
+    long int kept = s->periods - ceil(s->periods*s->burnin);
+    apop_data *out = apop_data_alloc(chain_count*kept, vsize+msize1*msize2);
 
-    for (int i=0; i< s->periods; i++){     //main loop
-        newdraw:
-        apop_draw(draw, rng, prior);
-        apop_data_fill_base(likelihood->parameters, draw);
-        ll = apop_log_likelihood(data,likelihood);
-
-        Apop_notify(3, "ll=%g for parameters:\t", ll);
-        if (apop_opts.verbose >=3) apop_data_print(likelihood->parameters);
-
-        Apop_stopif(gsl_isnan(ll), goto newdraw, 
-                1, "Trouble evaluating the "
-                "likelihood function at vector beginning with %g. "
-                "Throwing it out and trying again.\n"
-                , likelihood->parameters->vector->data[0]);
-        ratio = ll - cp_ll;
-        if (ratio >= 0 || log(gsl_rng_uniform(rng)) < ratio){
-            apop_data_memcpy(current_param, likelihood->parameters);
-            cp_ll = ll;
-            accept_count++;
-        } else {
-            Apop_notify(3, "reject, with exp(ll_now-ll_prior) = exp(%g-%g) = %g.", ll, cp_ll, exp(ratio));
-        }
-        if (i >= s->periods * s->burnin){
-            APOP_ROW(out, i-(s->periods *s->burnin), v)
-            apop_data_pack(current_param, v);
-        }
+    //With several chains, each gets its own copies of the models and its own RNG.
+    chain_pass chains[chain_count];
+    for (int c=0; c< chain_count; c++)
+        chains[c] = (chain_pass){.data=data, .out=out, .s=s, .first_row=c*kept,
+                .prior      = chain_count==1 ? prior : apop_model_copy(*prior),
+                .likelihood = chain_count==1 ? likelihood : apop_model_copy(*likelihood),
+                .rng        = chain_count==1 ? rng : apop_rng_alloc(gsl_rng_get(rng))};
+    int threadct = GSL_MAX(1, GSL_MIN(chain_count, apop_opts.thread_count));
+    pthread_t thread_id[threadct];
+    chain_block blocks[threadct];
+    for (int t=0; t< threadct; t++)
+        blocks[t] = (chain_block){.chains=chains,
+                        .lo=t*chain_count/threadct, .hi=(t+1)*chain_count/threadct};
+    if (threadct==1) chain_loop(blocks);
+    else {
+        for (int t=0; t< threadct; t++)
+            pthread_create(&thread_id[t], NULL, chain_loop, blocks+t);
+        for (int t=0; t< threadct; t++)
+            pthread_join(thread_id[t], NULL);
     }
-    out->weights = gsl_vector_alloc(s->periods*(1-s->burnin));
+
+    out->weights = gsl_vector_alloc(chain_count*kept);
     gsl_vector_set_all(out->weights, 1);
     apop_model *outp   = apop_estimate(out, apop_pmf);
-    free(draw);
+    long int accept_count = 0;
+    char name[100];
+    for (int c=0; c< chain_count; c++){
+        accept_count += chains[c].accept_count;
+        snprintf(name, 100, "accept rate, chain %i", c);
+        apop_data_add_named_elmt(outp->info, name, chains[c].accept_count/(s->periods+0.0));
+        if (chain_count > 1){
+            apop_model_free(chains[c].prior);
+            apop_model_free(chains[c].likelihood);
+            gsl_rng_free(chains[c].rng);
+        }
+    }
+    if (kept >= 4)
+        for (int j=0; j< out->matrix->size2; j++){
+            snprintf(name, 100, "R-hat %i", j);
+            apop_data_add_named_elmt(outp->info, name, split_rhat(out->matrix, j, chain_count, kept));
+        }
     if (ll_is_a_copy) apop_model_free(likelihood);
-    Apop_notify(2, "Gibbs sampling accept percent = %3.3f%%\n", 100*(0.0+accept_count)/s->periods);
+    Apop_notify(2, "Gibbs sampling accept percent = %3.3f%%\n", 100*(0.0+accept_count)/(s->periods*chain_count));
     return outp;
 }
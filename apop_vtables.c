@@ -32,7 +32,7 @@ int apop_vtable_insert(char *tabname, void *fn_in, unsigned long hash){
 
     //add a table if need be.
     if (!v->hashed_name){
-        vtable_list=realloc(vtable_list, ctr+2* sizeof(apop_vtable_s));
+        vtable_list=realloc(vtable_list, (ctr+2)* sizeof(apop_vtable_s));
         vtable_list[ctr] = (apop_vtable_s){.name=tabname, .hashed_name = h, .elmts=calloc(1, sizeof(apop_vtable_elmt_s))};
         vtable_list[ctr+1] = (apop_vtable_s){ };
         v = vtable_list+ctr;
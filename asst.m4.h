@@ -25,9 +25,12 @@ int apop_system(const char *fmt, ...) __attribute__ ((format (printf,1,2)));
 
 //Histograms and PMFs
 gsl_vector * apop_vector_moving_average(gsl_vector *, size_t);
+Apop_var_declare( gsl_vector * apop_vector_moving_stat(gsl_vector const *v, size_t bandwidth, char stat, gsl_vector const *weights) )
+Apop_var_declare( gsl_vector * apop_vector_ewma(gsl_vector const *v, double alpha, char stat) )
 apop_data * apop_histograms_test_goodness_of_fit(apop_model *h0, apop_model *h1);
 apop_data * apop_test_kolmogorov(apop_model *m1, apop_model *m2);
 apop_data *apop_data_pmf_compress(apop_data *in);
+void apop_pmf_invalidate(apop_model *pmf);
 Apop_var_declare( apop_data * apop_data_to_bins(apop_data *indata, apop_data *binspec, int bin_count, char close_top_bin) )
 Apop_var_declare( apop_model * apop_model_to_pmf(apop_model *model, apop_data *binspec, long int draws, int bin_count, gsl_rng *rng) )
 
@@ -73,7 +76,7 @@ Apop_var_declare( char* apop_text_paste(apop_data const*strings, char *between,
 #define apop_errorlevel -5
 
 //For use in stopif, to return a blank apop_data set with an error attached.
-#define apop_return_data_error(E) {apop_data *out=apop_data_alloc(); out->error='E'; return out;}
+#define apop_return_data_error(E) {apop_data *out=apop_data_alloc(); out->error=*#E; return out;}
 
 /* The Apop_stopif macro is currently favored, but there's a long history of prior
    error-handling setups. Consider all of the Assert... macros below to be deprecated.
@@ -104,6 +107,24 @@ Apop_var_declare( double apop_test(double statistic, char *distribution, double
 
 //Sorting (apop_asst.c)
 Apop_var_declare( double * apop_vector_percentiles(gsl_vector *data, char rounding)  )
+
+/** A mergeable sketch of a distribution, for approximate quantiles of data that doesn't
+fit in memory. See \ref apop_quantile_sketch_alloc; the elements are internal. */
+typedef struct {
+    double compression;
+    size_t centroid_ct, buffer_ct, space;
+    double *centroids;  //(mean, weight) pairs: sorted centroids, then an unsorted buffer.
+    long double total_weight;
+    double min, max;
+} apop_quantile_sketch;
+
+Apop_var_declare( apop_quantile_sketch * apop_quantile_sketch_alloc(double compression) )
+Apop_var_declare( void apop_quantile_sketch_add(apop_quantile_sketch *s, double value, double weight) )
+void apop_quantile_sketch_add_vector(apop_quantile_sketch *s, gsl_vector const *v, gsl_vector const *weights);
+void apop_quantile_sketch_merge(apop_quantile_sketch *into, apop_quantile_sketch const *from);
+double apop_quantile_sketch_quantile(apop_quantile_sketch *s, double q);
+double * apop_quantile_sketch_percentiles(apop_quantile_sketch *s);
+void apop_quantile_sketch_free(apop_quantile_sketch *s);
 Apop_var_declare( apop_data * apop_data_sort(apop_data *data, int sortby, char asc) )
 
 //raking
@@ -112,6 +133,9 @@ Apop_var_declare( apop_data * apop_rake(char const *margin_table, char * const*v
                     char const *structural_zeros, int max_iterations, double tolerance, 
                     char const *count_col, int run_number, char const *init_table, 
                     char const *init_count_col, double nudge, char const* table_name) )
+Apop_var_declare( apop_data * apop_rake_data(apop_data const *margins, apop_data const *init, 
+                    char * const *contrasts, int contrast_ct, int max_iterations, 
+                    double tolerance, double nudge) )
 
 //asprintf, vararg, &c
 #include <stdarg.h>
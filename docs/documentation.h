@@ -959,6 +959,8 @@ Outlineheader  sumstats  Summary stats
 
 \li\ref apop_data_summarize ()
 \li\ref apop_vector_moving_average()
+\li\ref apop_vector_moving_stat()
+\li\ref apop_vector_ewma()
 \li\ref apop_vector_percentiles()
 
         See also:
@@ -0,0 +1,63 @@
+/* Compare the exact kernel density sum with the fast, windowed Normal-kernel mode.
+
+Draw a few thousand points spread over a range much wider than the kernel's standard
+deviation, then evaluate the density and CDF on a grid using the exact sum and using
+<tt>.method='f'</tt> at a few cutoffs. For each cutoff, print the largest absolute
+error against the exact sum and the time each version took.
+
+At the default cutoff of 8 standard deviations, the fast version should agree with
+the exact sum to within rounding error.
+*/
+
+#include <apop.h>
+#include <time.h>
+
+double seconds(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//Evaluate the p and CDF on a grid; return the elapsed time and fill the outputs.
+double eval_grid(apop_model *k, gsl_vector *ps, gsl_vector *cdfs){
+    apop_data *onept = apop_data_alloc(1, 1);
+    double start = seconds();
+    for (size_t i=0; i< ps->size; i++){
+        apop_data_set(onept, .val= -20 + 1040.*i/ps->size);
+        gsl_vector_set(ps, i, apop_p(onept, k));
+        gsl_vector_set(cdfs, i, apop_cdf(onept, k));
+    }
+    apop_data_free(onept);
+    return seconds() - start;
+}
+
+double max_gap(gsl_vector *a, gsl_vector *b){
+    double out = 0;
+    for (size_t i=0; i< a->size; i++)
+        out = GSL_MAX(out, fabs(gsl_vector_get(a, i) - gsl_vector_get(b, i)));
+    return out;
+}
+
+int main(){
+    int draws = 5000, gridsize = 400;
+    gsl_rng *r = apop_rng_alloc(24);
+    apop_model *unif = apop_model_set_parameters(apop_uniform, 0, 1000);
+    apop_data *d = apop_model_draws(unif, draws, r);
+
+    apop_model *exact = apop_estimate(d, apop_kernel_density);
+    gsl_vector *p_exact = gsl_vector_alloc(gridsize), *cdf_exact = gsl_vector_alloc(gridsize),
+               *p_fast = gsl_vector_alloc(gridsize), *cdf_fast = gsl_vector_alloc(gridsize);
+    double exact_time = eval_grid(exact, p_exact, cdf_exact);
+    printf("exact sum:\t\t\t\t\t\t%g sec\n", exact_time);
+
+    for (double cutoff = 3; cutoff <= 8; cutoff += 2.5){
+        apop_model *fast = apop_model_copy(apop_kernel_density);
+        Apop_model_add_group(fast, apop_kernel_density, .base_data=d, .method='f', .cutoff=cutoff);
+        double fast_time = eval_grid(fast, p_fast, cdf_fast);
+        double p_err = max_gap(p_exact, p_fast), cdf_err = max_gap(cdf_exact, cdf_fast);
+        printf("cutoff %g sd:\tmax p error %g\tmax CDF error %g\t%g sec (%.1fx)\n",
+                cutoff, p_err, cdf_err, fast_time, exact_time/fast_time);
+        if (cutoff == 8) assert(p_err < 1e-12 && cdf_err < 1e-12);
+        apop_model_free(fast);
+    }
+}
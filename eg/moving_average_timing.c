@@ -0,0 +1,75 @@
+/* Compare the windowed moving average with the old version that re-sums each window.
+
+Make a long, noisy series, then find its moving average at a few bandwidths, once via
+\ref apop_vector_moving_average, which slides a running sum along the series, and once
+via the old loop that adds up all \c bandwidth elements for every output element. Print
+the time each took and the largest difference between them; the time for the running
+sum should barely change as the bandwidth grows.
+
+Then find the rolling variance, min, and max, and the exponentially-weighted mean, to
+show their times for the same series.
+*/
+
+#include <apop.h>
+#include <time.h>
+
+double seconds(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//The old implementation, which takes time proportional to size times bandwidth.
+gsl_vector *resum_moving_average(gsl_vector *v, size_t bandwidth){
+    int halfspan = bandwidth/2;
+    gsl_vector *vout = gsl_vector_calloc(v->size - halfspan*2);
+    for(size_t i=0; i < vout->size; i ++){
+        double *item = gsl_vector_ptr(vout, i);
+        for (int j=-halfspan; j < halfspan+1; j ++)
+            *item += gsl_vector_get(v, j+ i+ halfspan);
+        *item /= halfspan*2 +1;
+    }
+    return vout;
+}
+
+double max_gap(gsl_vector *a, gsl_vector *b){
+    double out = 0;
+    for (size_t i=0; i< a->size; i++)
+        out = GSL_MAX(out, fabs(gsl_vector_get(a, i) - gsl_vector_get(b, i)));
+    return out;
+}
+
+int main(){
+    int n = 1e6;
+    gsl_rng *r = apop_rng_alloc(25);
+    gsl_vector *v = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++)
+        gsl_vector_set(v, i, 100*sin(i/1e4) + gsl_ran_gaussian(r, 1));
+
+    for (size_t bw = 11; bw <= 1001; bw = bw*10 - 9){
+        double start = seconds();
+        gsl_vector *fast = apop_vector_moving_average(v, bw);
+        double fast_time = seconds() - start;
+        start = seconds();
+        gsl_vector *slow = resum_moving_average(v, bw);
+        double slow_time = seconds() - start;
+        double err = max_gap(fast, slow);
+        printf("bandwidth %zu:\tmax difference %g\trunning sum %g sec\tre-summing %g sec (%.1fx)\n",
+                bw, err, fast_time, slow_time, slow_time/fast_time);
+        assert(err < 1e-9);
+        gsl_vector_free(fast);
+        gsl_vector_free(slow);
+    }
+
+    char stats[] = "vlh";
+    for (char *s = stats; *s; s++){
+        double start = seconds();
+        gsl_vector *out = apop_vector_moving_stat(v, 1001, *s);
+        printf("moving stat '%c', bandwidth 1001:\t%g sec\n", *s, seconds() - start);
+        gsl_vector_free(out);
+    }
+    double start = seconds();
+    gsl_vector *ewma = apop_vector_ewma(v, .alpha=0.01);
+    printf("exponentially weighted mean:\t\t%g sec\n", seconds() - start);
+    gsl_vector_free(ewma);
+}
@@ -0,0 +1,70 @@
+/* Compare apop_query_to_data with the old way of reading a query's results.
+
+The old version ran the query via sqlite3_exec, whose callback receives every cell as
+text; each cell was then parsed with atof, and the output matrix was reallocated one row
+at a time. \ref apop_query_to_text still takes that callback path, so <tt>via_text</tt>
+below reproduces the old version: get the text, then parse it into a matrix grown a row at
+a time. \ref apop_query_to_data now steps through the query and reads numeric columns as
+doubles, with no text in between.
+
+Build a table of a few hundred thousand rows of random numbers, read it both ways, and
+print the time each took and the largest difference between the two (which comes from the
+text version's rounding to 15 significant digits).
+*/
+
+#include <apop.h>
+#include <time.h>
+
+double seconds(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//The old path: text from the callback, parsed a cell at a time, one realloc per row.
+apop_data *via_text(char const *query){
+    apop_data *txt = apop_query_to_text("%s", query);
+    size_t rows = txt->textsize[0], cols = txt->textsize[1];
+    apop_data *out = apop_data_alloc();
+    for (size_t i=0; i< rows; i++){
+        out->matrix = apop_matrix_realloc(out->matrix, i+1, cols);
+        for (size_t j=0; j< cols; j++)
+            gsl_matrix_set(out->matrix, i, j, !strcmp(txt->text[i][j], apop_opts.db_nan)
+                                                ? GSL_NAN : atof(txt->text[i][j]));
+    }
+    apop_data_free(txt);
+    return out;
+}
+
+int main(){
+    //2^18 = 262,144 rows, via a self-join of a two-row table.
+    apop_query("create table two(b); insert into two values(1); insert into two values(1);"
+               "create table nums as select ran() as a, ran()*1e6 as b, ran()-0.5 as c, "
+               "ran()*ran() as d, round(ran()*100) as e "
+               "from two, two, two, two, two, two, two, two, two, two, two, two, two, "
+               "two, two, two, two, two;");
+    char *q = "select * from nums";
+
+    double start = seconds();
+    apop_data *old = via_text(q);
+    double old_time = seconds() - start;
+
+    start = seconds();
+    apop_data *new = apop_query_to_data(q);
+    double new_time = seconds() - start;
+
+    assert(old->matrix->size1 == new->matrix->size1 && old->matrix->size2 == new->matrix->size2);
+    double max_gap = 0;
+    for (size_t i=0; i< new->matrix->size1; i++)
+        for (size_t j=0; j< new->matrix->size2; j++){
+            double n = apop_data_get(new, i, j), o = apop_data_get(old, i, j);
+            max_gap = GSL_MAX(max_gap, fabs(n - o)/GSL_MAX(1, fabs(n)));
+        }
+    printf("%zu rows x %zu columns\n", new->matrix->size1, new->matrix->size2);
+    printf("text callback:\t%g sec\n", old_time);
+    printf("typed columns:\t%g sec (%.1fx)\n", new_time, old_time/new_time);
+    printf("largest relative difference: %g\n", max_gap);
+    assert(max_gap < 1e-13);
+    apop_data_free(old);
+    apop_data_free(new);
+}
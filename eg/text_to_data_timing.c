@@ -0,0 +1,185 @@
+/* Throughput of apop_text_to_data on a synthetic wide CSV file.
+
+Write a file of random numbers, a couple of hundred columns wide, and read it back three ways:
+
+\li <tt>old_text_to_data</tt> below, a copy of the old version of \ref apop_text_to_data
+(trimmed to delimited files without row names): it reallocates the matrix for every line,
+reallocates each field's string as it parses the field, and checks every character against
+the delimiter list via \c strchr.
+\li \ref apop_text_to_data with one thread, which grows the matrix geometrically, reuses
+its field buffers from line to line, and classifies characters via a table.
+\li \ref apop_text_to_data with four threads, which maps the file into memory and parses
+runs of lines in parallel. This only helps if you have several processors.
+
+For each, print the throughput in MB/sec, and check that all three read the same numbers.
+*/
+
+#include <apop.h>
+#include <time.h>
+
+double seconds(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+////// The old reader.
+
+#define bs 100000
+typedef struct {int ct; int eof;} line_parse_t;
+typedef struct { char c, type; } char_info;
+
+static char get_next(char *buffer, size_t *ptr, FILE *infile){
+    if (*ptr>=bs){
+        size_t len=fread(buffer, 1, bs, infile);
+        if (len < bs) buffer[len]=EOF;
+        *ptr=0;
+    }
+    return buffer[(*ptr)++];
+}
+
+static char_info parse_next_char(char *buffer, size_t *ptr, FILE *f, char const *delimiters){
+    char c = get_next(buffer, ptr, f);
+    int is_delimiter = !!strchr(delimiters, c);
+    return (char_info){.c=c, 
+            .type = (c==' '||c=='\t' || c==0)? (is_delimiter ? 'W'  : 'w')
+                    :is_delimiter    ? 'd'
+                    :(c == '\n')     ? 'n'
+                    :(c == '"')      ? '"'
+                    :(c == '\'')     ? '\''
+                    :(c == '\\')     ? '\\'
+                    :(c == EOF)      ? 'E'
+                    :(c == '#')      ? '#'
+                                     : 'r'
+            };
+}
+
+static line_parse_t parse_a_line(FILE *infile, char *buffer, size_t *ptr, apop_data *fn, char const *delimiters){
+    int ct=0, thisflen=0, inq=0, inqq=0, infield=0, mlen=5,
+            lastwhite=0, lastnonwhite=0; 
+    char_info ci;
+    do {
+        ci = parse_next_char(buffer, ptr, infile, delimiters);
+        if (ci.type=='#' && !(inq||inqq)){
+            for(char c='x'; (c!='\n' && c!=EOF); )
+                c = get_next(buffer, ptr, infile);
+            ci.type='n';
+        }
+        if (ci.type=='\\'){
+            ci=parse_next_char(buffer, ptr, infile, delimiters);
+            if (ci.type!='E')
+                ci.type='r';
+        }
+        if (((inq && ci.type !='\'') ||(inqq && ci.type !='"')) && ci.type !='E')
+            ci.type='r';
+        if (ci.type=='\'') inq = !inq;
+        else if (ci.type=='"') inqq = !inqq;
+
+        if (ci.type=='W' && lastwhite==1) 
+            continue;
+        lastwhite=(ci.type=='W');
+
+        if (!infield){
+            if (ci.type=='w') continue;
+            if (ci.type=='r' || ci.type=='d' || (strchr("nE", ci.type) && ct>0)){
+                if (++ct > fn->textsize[0]) apop_text_alloc(fn, ct, 1);
+                *fn->text[ct-1] = realloc(*fn->text[ct-1], 5);
+                thisflen = 0;
+                mlen=5;
+                infield=1;
+            } 
+        } 
+        if (infield){
+            if (ci.type=='d'||ci.type=='n' || ci.type=='E' || ci.type=='W'){
+                fn->text[ct-1][0][lastnonwhite] = '\0';
+                infield =
+                thisflen =
+                lastnonwhite = 0;
+            } else if (ci.type=='w' || ci.type=='r'){
+                thisflen++;
+                if (thisflen+2 > mlen){
+                    mlen *=2;
+                    *fn->text[ct-1] = realloc(*fn->text[ct-1], mlen);
+                }
+                fn->text[ct-1][0][thisflen-1] = ci.c;
+                if (ci.type!='w')
+                    lastnonwhite = thisflen;
+            }
+        }
+    } while (ci.type != 'n' && ci.type != 'E');
+    return (line_parse_t) {.ct=ct, .eof= (ci.type == 'E')};
+}
+
+apop_data *old_text_to_data(char const *text_file){
+    char const *delimiters = apop_opts.input_delimiters;
+    FILE *infile = fopen(text_file, "r");
+    char *buffer = malloc(bs), *str;
+    size_t ptr=bs;
+    apop_data *add_this_line = apop_data_alloc(), *set = NULL;
+    int row = 0;
+    line_parse_t L = {};
+    while (add_this_line->textsize[0]==0) parse_a_line(infile, buffer, &ptr, add_this_line, delimiters); //header
+    L=parse_a_line(infile, buffer, &ptr, add_this_line, delimiters);
+	while(!set || !L.eof || L.ct){
+        if (!L.ct) {
+            L=parse_a_line(infile,buffer, &ptr,  add_this_line, delimiters);
+            continue;
+        }
+        if (!set) set = apop_data_alloc(0, 1, L.ct);
+        row++;
+        set->matrix = apop_matrix_realloc(set->matrix, row, set->matrix->size2);
+        for (int col=0; col < L.ct; col++){
+            char *thisstr = *add_this_line->text[col];
+            double val = strtod(thisstr, &str);
+            gsl_matrix_set(set->matrix, row-1, col, (strlen(thisstr) && thisstr != str) ? val : GSL_NAN);
+        }
+        if (L.eof) break;
+        L=parse_a_line(infile, buffer, &ptr, add_this_line, delimiters);
+	}
+    apop_data_free(add_this_line);
+    free(buffer);
+    fclose(infile);
+	return set;
+}
+
+////// The comparison.
+
+int main(){
+    int rows = 20000, cols = 200;
+    char *filename = "text_to_data_timing.csv";
+    gsl_rng *r = apop_rng_alloc(2);
+    FILE *f = fopen(filename, "w");
+    for (int j=0; j< cols; j++) fprintf(f, "%sc%i", j ? "," : "", j);
+    fprintf(f, "\n");
+    for (int i=0; i< rows; i++)
+        for (int j=0; j< cols; j++)
+            fprintf(f, "%.10g%s", gsl_ran_gaussian(r, 100), j < cols-1 ? "," : "\n");
+    double megabytes = ftell(f)/1e6;
+    fclose(f);
+
+    double start = seconds();
+    apop_data *old = old_text_to_data(filename);
+    double old_time = seconds() - start;
+    printf("%.1f MB file, %i rows x %i columns\n", megabytes, rows, cols);
+    printf("old apop_text_to_data:\t\t%.1f MB/sec\n", megabytes/old_time);
+    assert(old->matrix->size1 == rows && old->matrix->size2 == cols);
+
+    int threads = apop_opts.thread_count;
+    for (int t=1; t<= 4; t+=3){
+        apop_opts.thread_count = t;
+        start = seconds();
+        apop_data *new = apop_text_to_data(filename);
+        double new_time = seconds() - start;
+        printf("apop_text_to_data, %i thread%s:\t%.1f MB/sec (%.1fx)\n", t, t==1 ? "" : "s",
+                megabytes/new_time, old_time/new_time);
+        assert(new->matrix->size1 == rows && new->matrix->size2 == cols);
+        for (int i=0; i< rows; i++)
+            for (int j=0; j< cols; j++)
+                assert(apop_data_get(new, i, j) == apop_data_get(old, i, j));
+        apop_data_free(new);
+    }
+    apop_opts.thread_count = threads;
+    apop_data_free(old);
+    gsl_rng_free(r);
+    remove(filename);
+}
@@ -37,7 +37,45 @@ void xprintf(char **q, char *format, ...);
 int apop_use_sqlite_prepared_statements(size_t col_ct);
 int apop_prepare_prepared_statements(char const *tabname, size_t col_ct, sqlite3_stmt **statement);
 char *prep_string_for_sqlite(int prepped_statements, char const *astring);//apop_conversions.c
+struct apop_data;
+int apop_query_to_blocks(char const *query, size_t block_rows,
+                int (*block_fn)(struct apop_data *, void *), void *info); //apop_db.c
 void apop_gsl_error(char const *reason, char const *file, int line, int gsl_errno); //apop_linear_algebra.c
+#include <gsl/gsl_matrix.h>
+int apop_same_matrix(gsl_matrix const *a, gsl_matrix const *b); //apop_linear_algebra.c
+
+/* in apop_asst.c: FNV-1a hashing, for hash tables of rows or elements. Start from
+ apop_hash_start and fold in each element. apop_hash_double hashes all NaNs alike, and 0
+ and -0 alike, so elements that compare equal get the same hash. */
+#define apop_hash_start 14695981039346656037ULL
+unsigned long long apop_hash_bytes(unsigned long long h, void const *bytes, size_t len);
+unsigned long long apop_hash_double(unsigned long long h, double x);
+
+/* Batch routines in the model/ directory, registered in the vtables of vtables.h by the
+ functions that use them. */
+#include <gsl/gsl_rng.h>
+struct apop_data;
+struct apop_model;
+void apop_pmf_draws(struct apop_data *out, gsl_rng *r, struct apop_model *m); //apop_model_draws; model/apop_pmf.c
+void apop_mvn_draws(struct apop_data *out, gsl_rng *r, struct apop_model *m); //apop_model_draws; model/apop_multivariate_normal.c
+//apop_log_likelihoods; in the model file for each distribution:
+#include <gsl/gsl_matrix.h>
+void apop_normal_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+void apop_lognormal_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+void apop_exponential_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+void apop_gamma_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+void apop_poisson_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+void apop_multinormal_log_likelihoods(struct apop_data *d, struct apop_model *m, gsl_matrix const *params, gsl_vector *out);
+
+/* in apop_mapply.c: a pool of worker threads that persists across calls. apop_pool_run
+ cuts [0, n) into chunks of the given size and runs fn on every chunk, using up to
+ apop_opts.thread_count threads (the caller is one of them). Idle threads steal
+ chunks from busy ones. If the pool is busy, as for a call from inside a pooled
+ function or from another thread, the chunks run in order in the calling thread. */
+typedef void apop_pool_fn(void *ctx, size_t lo, size_t hi, int worker);
+void apop_pool_run(apop_pool_fn *fn, void *ctx, size_t n, size_t chunk);
+size_t apop_pool_chunk(size_t n);
+size_t apop_pool_fixed_chunk(size_t n); //depends only on n, for sums that shouldn't vary with thread count.
 
 //For when we're forced to use a global variable.
 #undef threadlocal
@@ -36,6 +36,18 @@ static double exponential_log_likelihood(apop_data *d, apop_model *p){
 	return llikelihood;
 }
 
+//The batched version, for apop_log_likelihoods.
+void apop_exponential_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(d, );
+    Get_vmsizes(d) //tsize
+    double sum = (d->matrix ? apop_matrix_sum(d->matrix):0) + (d->vector ? apop_sum(d->vector) : 0);
+    for (size_t i=0; i< params->size1; i++){
+        double mu = gsl_matrix_get(params, i, 0);
+        gsl_vector_set(out, i, -sum/mu - tsize * log(mu));
+    }
+}
+
 /* \adoc estimated_info   Reports <tt>log likelihood</tt>. */
 static apop_model * exponential_estimate(apop_data * data,  apop_model *est){
     apop_name_add(est->parameters->names, "mu", 'r');
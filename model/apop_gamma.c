@@ -47,6 +47,26 @@ static double gamma_log_likelihood(apop_data *d, apop_model *p){
     return llikelihood;
 }
 
+static double ln_nonzero(double x){ return x ? log(x) : 0; }
+static double is_nonzero(double x){ return x != 0; }
+static double ident(double x){ return x; }
+
+/* The batched version, for apop_log_likelihoods. Zeros contribute nothing (as in
+ apply_for_gamma), so the sufficient statistics are the sums of x and ln x over nonzero x,
+ and the count of nonzero x. */
+void apop_gamma_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(d, );
+    double sum_ln = apop_map_sum(d, .fn_d = ln_nonzero),
+           sum = apop_map_sum(d, .fn_d = ident),
+           nonzeros = apop_map_sum(d, .fn_d = is_nonzero);
+    for (size_t i=0; i< params->size1; i++){
+        double a = gsl_matrix_get(params, i, 0),
+               b = gsl_matrix_get(params, i, 1);
+        gsl_vector_set(out, i, (a-1)*sum_ln - sum/b - nonzeros*(gsl_sf_lngamma(a) + a*log(b)));
+    }
+}
+
 static double a_callback(double x, void *ab){ return log(x)- *(double*)ab; }
 
 static double b_callback(double x, void *abv){ 
@@ -6,6 +6,7 @@ Copyright (c) 2007, 2010, 2013 by Ben Klemens.  Licensed under the modified GNU
 
 #include "apop_internal.h"
 #include <gsl/gsl_math.h>
+#include <gsl/gsl_sort.h>
 
 
 /*\amodel apop_kernel_density The kernel density smoothing of a PMF or histogram.
@@ -40,6 +41,29 @@ void set_midpoint(apop_data * in, apop_model *m){
 }
 \endcode
 
+\li \c method If \c 'f', use the fast mode described below. Default: \c 'e', the exact sum.
+\li \c cutoff In fast mode, points farther than this many kernel standard deviations from the point being evaluated are skipped. Default: 8.
+
+The exact \c p and \c cdf methods re-center the kernel over every point in the base PMF,
+so each evaluation takes time linear in the size of the base data. For the common case
+of a Normal kernel (the default) over one-dimensional data, set <tt>.method='f'</tt> and
+the base points are sorted when the settings group is added or the model is estimated;
+every evaluation then binary-searches for the points within \c cutoff standard
+deviations of the input and sums only those. Points below the window add their full
+weight to the CDF; points above it add nothing. At the default cutoff of 8, the terms
+dropped are below \f$10^{-14}\f$ of the kernel's peak. If the kernel is not an \ref
+apop_normal, \c set_fn is not the default, the data has more than one dimension or has
+NaNs, or you ask for the density of more than one point at a time, I fall back to the
+exact sum.
+
+\li Set <tt>.method='f'</tt> when adding the settings group, e.g.
+<tt>Apop_model_add_group(k, apop_kernel_density, .base_data=d, .method='f')</tt>. If you
+set it later, or modify the base data in place, re-estimate the model so the sort is
+redone. Until then, I use the exact sum if the base PMF's data set is not the one that
+was sorted, or its row count has changed.
+\li The fast \c p and \c cdf methods only read the settings group, so they can be
+called from several threads at once, as by a threaded \ref apop_map.
+
 \adoc Input_format  I'll estimate a \ref apop_pmf internally, so I
                    follow that format, which is one observation (of any format) per line.
 \adoc Parameter_format  None
@@ -58,34 +82,143 @@ static void apop_set_first_param(apop_data *in, apop_model *m){
                                                  : gsl_matrix_get(in->matrix, 0, 0);
 }
 
+//Fast mode needs the data to be one column, in either the vector or the matrix.
+static int one_column(apop_data const *d){
+    return d && (d->vector ? d->matrix == NULL : (d->matrix && d->matrix->size2 == 1));
+}
+
+static void fast_clear(apop_kernel_density_settings *ks){
+    free(ks->sorted_rows);
+    free(ks->sorted_vals);
+    free(ks->cum_wts);
+    ks->sorted_rows = NULL;
+    ks->sorted_vals = ks->cum_wts = NULL;
+    ks->sorted_from = NULL;
+    ks->sorted_ct = 0;
+}
+
+/* Sort the base points and accumulate their weights, so that fast mode can find the
+ window around a point via binary search. This runs when the settings group is set up
+ and when the model is estimated, never from p or cdf, which only read the result.
+ If there are NaNs, which the exact sum would propagate, leave the cache empty, so p and
+ cdf use the exact sum. */
+static void fast_setup(apop_kernel_density_settings *ks){
+    fast_clear(ks);
+    apop_data *pmf_data = ks->base_pmf ? ks->base_pmf->data : NULL;
+    if (ks->method != 'f' || !one_column(pmf_data)) return;
+    Get_vmsizes(pmf_data); //maxsize
+    size_t n = maxsize;
+    Apop_col(pmf_data, (pmf_data->vector ? -1 : 0), v);
+    for (size_t i=0; i< n; i++)
+        if (isnan(gsl_vector_get(v, i))){
+            Apop_notify(1, "NaNs in the base data; using the exact KDE sum.");
+            return;
+        }
+    ks->sorted_rows = malloc(sizeof(size_t)*n);
+    ks->sorted_vals = malloc(sizeof(double)*n);
+    ks->cum_wts = malloc(sizeof(double)*(n+1));
+    Apop_stopif(!ks->sorted_rows || !ks->sorted_vals || !ks->cum_wts, fast_clear(ks); return,
+            0, "Allocation error sorting the base data; using the exact KDE sum.");
+    gsl_sort_index(ks->sorted_rows, v->data, v->stride, n);
+    ks->cum_wts[0] = 0;
+    for (size_t i=0; i< n; i++){
+        size_t row = ks->sorted_rows[i];
+        ks->sorted_vals[i] = gsl_vector_get(v, row);
+        ks->cum_wts[i+1] = ks->cum_wts[i] + (pmf_data->weights ? gsl_vector_get(pmf_data->weights, row) : 1);
+    }
+    ks->sorted_from = pmf_data;
+    ks->sorted_ct = n;
+}
+
 Apop_settings_init(apop_kernel_density, 
     //If there's a PMF associated with the model, run with it.
     //else, generate one from the data.
     Apop_varad_set(base_pmf, apop_estimate(in.base_data, apop_pmf));
     Apop_varad_set(kernel, apop_model_set_parameters(apop_normal, 0, 1));
     Apop_varad_set(set_fn, apop_set_first_param);
+    Apop_varad_set(method, 'e');
+    Apop_varad_set(cutoff, 8);
     out->own_pmf = !in.base_pmf;
     out->own_kernel = !in.kernel;
     if (!out->kernel->parameters) apop_prep(out->base_data, out->kernel);
+    out->sorted_rows = NULL;
+    out->sorted_vals = out->cum_wts = NULL;
+    fast_setup(out);
 )
 
 Apop_settings_copy(apop_kernel_density,
     out->own_pmf    =
     out->own_kernel = 0;
+    if (in->sorted_vals){ //the copy shares the base PMF, so the sort is still good.
+        size_t n = in->sorted_ct;
+        out->sorted_rows = malloc(sizeof(size_t)*n);
+        out->sorted_vals = malloc(sizeof(double)*n);
+        out->cum_wts = malloc(sizeof(double)*(n+1));
+        memcpy(out->sorted_rows, in->sorted_rows, sizeof(size_t)*n);
+        memcpy(out->sorted_vals, in->sorted_vals, sizeof(double)*n);
+        memcpy(out->cum_wts, in->cum_wts, sizeof(double)*(n+1));
+    }
 )
 
 Apop_settings_free(apop_kernel_density,
     if (in->own_pmf)    apop_model_free(in->base_pmf);
     if (in->own_kernel) apop_model_free(in->kernel);
+    fast_clear(in);
 )
 
 static apop_model *apop_kernel_estimate(apop_data *d, apop_model *m){
     Nullcheck_d(d, NULL);
-    if (!apop_settings_get_group(m, apop_kernel_density))
-        apop_model_add_group(m, apop_kernel_density, .base_data=d);
+    apop_kernel_density_settings *ks = apop_settings_get_group(m, apop_kernel_density);
+    if (!ks) apop_model_add_group(m, apop_kernel_density, .base_data=d);
+    else fast_setup(ks); //the base data or method may have changed since the last sort.
     return m;
 }
 
+//The first index i such that vals[i] >= target.
+static size_t lower_bound(double const *vals, size_t n, double target){
+    size_t lo = 0, hi = n;
+    while (lo < hi){
+        size_t mid = lo + (hi-lo)/2;
+        if (vals[mid] < target) lo = mid+1;
+        else                    hi = mid;
+    }
+    return lo;
+}
+
+static int fast_ok(apop_data *d, apop_kernel_density_settings *ks, apop_data *pmf_data, size_t pmf_ct){
+    if (ks->method != 'f' || !ks->sorted_vals || ks->sorted_from != pmf_data || ks->sorted_ct != pmf_ct
+            || ks->set_fn != apop_set_first_param
+            || ks->kernel->log_likelihood != apop_normal.log_likelihood
+            || ks->kernel->cdf != apop_normal.cdf)
+        return 0;
+    Get_vmsizes(d); //maxsize
+    return maxsize == 1 && one_column(d);
+}
+
+/* The sum over the points in the window around x. The kernel is re-centered over each
+ point, so this works on a copy of the kernel's parameters, leaving the shared kernel
+ untouched for other threads. */
+static double fast_sum(apop_data *d, apop_kernel_density_settings *ks, apop_data *pmf_data,
+        double (*fn)(apop_data*,apop_model*)){
+    size_t n = ks->sorted_ct;
+    double x = apop_data_get(d, 0, d->vector ? -1 : 0);
+    if (isnan(x)) return GSL_NAN;
+    double reach = ks->cutoff * fabs(ks->kernel->parameters->vector->data[1]);
+    size_t lo = lower_bound(ks->sorted_vals, n, x - reach),
+           hi = lower_bound(ks->sorted_vals, n, nextafter(x + reach, INFINITY));
+    apop_model kernel = *ks->kernel;
+    kernel.parameters = apop_data_copy(ks->kernel->parameters);
+    long double total = (fn == apop_cdf) ? ks->cum_wts[lo] : 0;
+    for (size_t i = lo; i < hi; i++){
+        Apop_data_row(pmf_data, ks->sorted_rows[i], r);
+        double wt = r->weights ? r->weights->data[0] : 1;
+        apop_set_first_param(r, &kernel);
+        total += fn(d, &kernel)*wt;
+    }
+    apop_data_free(kernel.parameters);
+    return total/ks->cum_wts[n];
+}
+
 static double kernel_p_cdf_base(apop_data *d, apop_model *m,
         double (*fn)(apop_data*,apop_model*)){
     Nullcheck_d(d, GSL_NAN);
@@ -94,6 +227,7 @@ static double kernel_p_cdf_base(apop_data *d, apop_model *m,
     apop_kernel_density_settings *ks = apop_settings_get_group(m, apop_kernel_density);
     apop_data *pmf_data = apop_settings_get(m, apop_kernel_density, base_pmf)->data;
     Get_vmsizes(pmf_data); //maxsize
+    if (fast_ok(d, ks, pmf_data, maxsize)) return fast_sum(d, ks, pmf_data, fn);
     for (size_t k = 0; k < maxsize; k++){
         Apop_data_row(pmf_data, k, r);
         double wt = r->weights ? r->weights->data[0] : 1;
@@ -8,7 +8,14 @@
                             means, and whose matrix is the covariances.
 
 If you had only one dimension, the mean would be a vector of size one, and the covariance matrix a \f$1\times 1\f$ matrix. This differs from the setup for \ref apop_normal, which outputs a single vector with \f$\mu\f$ in element zero and \f$\sigma\f$ in element one.
-\adoc    Settings   None.    */
+The log likelihood and RNG use the Cholesky factor of the covariance matrix, which is
+computed on first use and stored (with the log determinant) in an \ref
+apop_mvn_settings group attached to the model. It is recomputed only when the covariance
+in the parameters changes, so repeated evaluations or draws with the same covariance
+don't refactor. If the covariance is not positive definite, the log likelihood is
+<tt>GSL_NEGINF</tt>, which tells maximizers to look elsewhere.
+
+\adoc    Settings   \ref apop_mvn_settings, which you never need to set.    */
  
 #include "apop_internal.h"
 
@@ -21,31 +28,127 @@ static double x_prime_sigma_x(gsl_vector *x, gsl_matrix *sigma){
     return the_result;
 }
 
+Apop_settings_init(apop_mvn, )
+
+Apop_settings_copy(apop_mvn,
+    if (in->cholesky) out->cholesky = apop_matrix_copy(in->cholesky);
+    if (in->factored) out->factored = apop_matrix_copy(in->factored);
+)
+
+Apop_settings_free(apop_mvn,
+    if (in->cholesky) gsl_matrix_free(in->cholesky);
+    if (in->factored) gsl_matrix_free(in->factored);
+)
+
+/* Get the settings group holding the Cholesky factor of the current covariance, adding
+ the group or refactoring if the covariance has changed since the last call. Returns
+ NULL if the covariance isn't positive definite (and remembers that, too). */
+static apop_mvn_settings *mvn_factor(apop_model *m){
+    apop_mvn_settings *ms = Apop_settings_get_group(m, apop_mvn);
+    if (!ms) ms = Apop_model_add_group(m, apop_mvn);
+    gsl_matrix *cov = m->parameters->matrix;
+    if (!ms->factored || !apop_same_matrix(ms->factored, cov)){
+        if (ms->factored) gsl_matrix_free(ms->factored);
+        if (ms->cholesky) gsl_matrix_free(ms->cholesky);
+        ms->factored = apop_matrix_copy(cov);
+        ms->cholesky = apop_matrix_copy(cov);
+        gsl_error_handler_t *prior_handler = gsl_set_error_handler(apop_gsl_error);
+        int status = gsl_linalg_cholesky_decomp(ms->cholesky);
+        gsl_set_error_handler(prior_handler);
+        ms->log_det = 0;
+        for (size_t i=0; !status && i< cov->size1; i++)
+            ms->log_det += 2*log(gsl_matrix_get(ms->cholesky, i, i));
+        if (status) ms->log_det = GSL_NAN;
+    }
+    return isnan(ms->log_det) ? NULL : ms;
+}
+
+/* With L the Cholesky factor, (x-mu)' Sigma^{-1} (x-mu) is the squared norm of
+ L^{-1}(x-mu). So take the data a block of rows at a time, subtract mu, and do one
+ triangular solve for the whole block. */
 static double apop_multinormal_ll(apop_data *data, apop_model * m){
     Nullcheck_mpd(data, m, GSL_NAN);
-    double determinant = 0;
-    gsl_matrix* inverse = NULL;
-    int i, dimensions  = data->matrix->size2;
-    gsl_vector* x_minus_mu= gsl_vector_alloc(data->matrix->size2);
-    double ll = 0;
-    determinant = apop_det_and_inv(m->parameters->matrix, &inverse, 1,1);
-    if (determinant == 0) { //tell maximizers to look elsewhere.
-        gsl_vector_free(x_minus_mu);
-        Apop_assert_c(0, GSL_NEGINF, 1, "the determinant of the given covariance is zero. Returning GSL_NEGINF."); 
+    apop_mvn_settings *ms = mvn_factor(m);
+    Apop_assert_c(ms, GSL_NEGINF, 1, "The covariance matrix isn't positive definite. Returning GSL_NEGINF.");
+    size_t n = data->matrix->size1, dimensions = data->matrix->size2;
+    if (!n) return 0;
+    size_t blocksize = GSL_MIN(n, 256);
+    gsl_matrix *block = gsl_matrix_alloc(blocksize, dimensions);
+    long double sumsq = 0;
+    for (size_t lo = 0; lo < n; lo += blocksize){
+        size_t rows = GSL_MIN(blocksize, n - lo);
+        gsl_matrix_view z = gsl_matrix_submatrix(block, 0, 0, rows, dimensions);
+        gsl_matrix_const_view x = gsl_matrix_const_submatrix(data->matrix, lo, 0, rows, dimensions);
+        gsl_matrix_memcpy(&z.matrix, &x.matrix);
+        for (size_t i=0; i< rows; i++){
+            Apop_matrix_row(&z.matrix, i, onerow);
+            gsl_vector_sub(onerow, m->parameters->vector);
+        }
+        //Solve Z L' = X - mu, so row i of Z is L^{-1}(x_i - mu).
+        gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1, ms->cholesky, &z.matrix);
+        for (size_t i=0; i< rows; i++){
+            Apop_matrix_row(&z.matrix, i, onerow);
+            double sq;
+            gsl_blas_ddot(onerow, onerow, &sq);
+            sumsq += sq;
+        }
     }
-    apop_assert(determinant > 0, "The determinant of the covariance matrix you gave me "
-            "is negative, but a covariance matrix must always be positive semidefinite "
-            "(and so have nonnegative determinant). Maybe run apop_matrix_to_positive_semidefinite?");
-    for (i=0; i< data->matrix->size1; i++){
-        Apop_row(data,i, vv);
-        gsl_vector_memcpy(x_minus_mu, vv);
-        gsl_vector_sub(x_minus_mu, m->parameters->vector);
-        ll += - x_prime_sigma_x(x_minus_mu, inverse) / 2;
+    gsl_matrix_free(block);
+    return -sumsq/2 - n * (log(2 * M_PI)* dimensions/2. + .5 * ms->log_det);
+}
+
+/* The batched version, for apop_log_likelihoods. With S the scatter matrix about the
+ sample mean xbar, sum_i (x_i-mu)' Sigma^{-1} (x_i-mu) = tr(Sigma^{-1} S) + n (xbar-mu)' Sigma^{-1} (xbar-mu),
+ so the data is read once, and each parameter set costs one inversion. */
+void apop_multinormal_log_likelihoods(apop_data *data, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(data, );
+    Apop_stopif(!data->matrix, return, 0, "The data should be in the matrix, one observation per row.");
+    size_t n = data->matrix->size1, dimensions = data->matrix->size2;
+    gsl_vector *xbar = gsl_vector_alloc(dimensions);
+    for (size_t j=0; j< dimensions; j++){
+        Apop_matrix_col(data->matrix, j, onecol);
+        gsl_vector_set(xbar, j, apop_vector_mean(onecol));
     }
-    ll -= data->matrix->size1 * (log(2 * M_PI)* dimensions/2. + .5 * log(determinant));
-    gsl_matrix_free(inverse);
-    gsl_vector_free(x_minus_mu);
-    return ll;
+    gsl_matrix *centered = apop_matrix_copy(data->matrix);
+    for (size_t i=0; i< n; i++){
+        Apop_matrix_row(centered, i, onerow);
+        gsl_vector_sub(onerow, xbar);
+    }
+    gsl_matrix *scatter = gsl_matrix_alloc(dimensions, dimensions);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, centered, centered, 0, scatter);
+    gsl_matrix_free(centered);
+
+    apop_data *p = apop_data_alloc(dimensions, dimensions, dimensions);
+    gsl_vector *diff = gsl_vector_alloc(dimensions);
+    for (size_t i=0; i< params->size1; i++){
+        gsl_vector_const_view row = gsl_matrix_const_row(params, i);
+        apop_data_unpack(&row.vector, p);
+        gsl_matrix *inverse = NULL;
+        double determinant = apop_det_and_inv(p->matrix, &inverse, 1, 1);
+        if (determinant == 0){
+            gsl_matrix_free(inverse);
+            gsl_vector_set(out, i, GSL_NEGINF);
+            Apop_notify(1, "the determinant of covariance %zu is zero. Returning GSL_NEGINF.", i);
+            continue;
+        }
+        Apop_stopif(determinant < 0, gsl_matrix_free(inverse); continue, 0,
+                "The determinant of covariance %zu is negative, but a covariance matrix must "
+                "always be positive semidefinite. Returning NaN for that parameter set.", i);
+        long double trace = 0;
+        for (size_t j=0; j< dimensions; j++)
+            for (size_t k=0; k< dimensions; k++)
+                trace += gsl_matrix_get(inverse, j, k) * gsl_matrix_get(scatter, k, j);
+        gsl_vector_memcpy(diff, xbar);
+        gsl_vector_sub(diff, p->vector);
+        gsl_vector_set(out, i, -(trace + n*x_prime_sigma_x(diff, inverse))/2
+                        - n * (log(2 * M_PI)* dimensions/2. + .5 * log(determinant)));
+        gsl_matrix_free(inverse);
+    }
+    apop_data_free(p);
+    gsl_vector_free(diff);
+    gsl_vector_free(xbar);
+    gsl_matrix_free(scatter);
 }
 
 static double a_mean(gsl_vector * in){ return apop_vector_mean(in); }
@@ -66,24 +169,40 @@ static apop_model * multivariate_normal_estimate(apop_data * data, apop_model *p
 
 /* \adoc    RNG  The RNG fills an input array whose length is based on the input parameters.
 
- The nice, easy method from Devroye, p 565 */
+ The nice, easy method from Devroye, p 565: draw a vector of independent Normal(0,1)s
+ and multiply by the Cholesky factor of the covariance. The factor is computed on the first
+ draw and kept until the covariance changes.
+
+ \ref apop_model_draws draws all of the Normal(0,1)s at once and multiplies the whole
+ matrix by the factor.
+
+ If the covariance is not positive definite, I return \c NaNs.*/
 static void mvnrng(double *out, gsl_rng *r, apop_model *eps){
-    apop_data *params = eps->parameters;
-    gsl_vector *v = gsl_vector_alloc(params->vector->size);
-    gsl_vector *dotted = gsl_vector_calloc(params->vector->size);
-    for (size_t i=0; i< params->vector->size; i++)
-        gsl_vector_set(v, i, gsl_ran_gaussian(r, 1));
-    gsl_matrix *copy  = apop_matrix_copy(params ->matrix);
-        gsl_linalg_cholesky_decomp(copy); //returns upper and lower triangle; we want just one.
-    for (size_t i=0; i< copy->size1; i++)
-        for (size_t j=i+1; j< copy->size2; j++)
-            gsl_matrix_set(copy, i, j, 0);
-    gsl_blas_dgemv(CblasNoTrans, 1, copy, v, 0, dotted);
-    for (size_t i=0; i< params->vector->size; i++)
-        out[i]  = gsl_vector_get(dotted, i) + gsl_vector_get(params->vector,i);
-    gsl_vector_free(v);
-    gsl_vector_free(dotted);
-    gsl_matrix_free(copy);
+    size_t dimensions = eps->parameters->vector->size;
+    apop_mvn_settings *ms = mvn_factor(eps);
+    Apop_stopif(!ms, for (size_t i=0; i< dimensions; i++) out[i] = GSL_NAN; return,
+            0, "The covariance matrix isn't positive definite; returning NaNs.");
+    for (size_t i=0; i< dimensions; i++)
+        out[i] = gsl_ran_gaussian(r, 1);
+    gsl_vector_view v = gsl_vector_view_array(out, dimensions);
+    gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit, ms->cholesky, &v.vector);
+    gsl_vector_add(&v.vector, eps->parameters->vector);
+}
+
+//For apop_model_draws. Consumes the RNG in the same order as repeated calls to mvnrng.
+void apop_mvn_draws(apop_data *out, gsl_rng *r, apop_model *m){
+    apop_mvn_settings *ms = mvn_factor(m);
+    Apop_stopif(!ms, gsl_matrix_set_all(out->matrix, GSL_NAN); return,
+            0, "The covariance matrix isn't positive definite; returning NaNs.");
+    gsl_matrix *z = out->matrix;
+    for (size_t i=0; i< z->size1; i++)
+        for (size_t j=0; j< z->size2; j++)
+            gsl_matrix_set(z, i, j, gsl_ran_gaussian(r, 1));
+    gsl_blas_dtrmm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1, ms->cholesky, z);
+    for (size_t i=0; i< z->size1; i++){
+        Apop_matrix_row(z, i, onerow);
+        gsl_vector_add(onerow, m->parameters->vector);
+    }
 }
 
 static void mvn_prep(apop_data *d, apop_model *m){
@@ -50,6 +50,23 @@ static double normal_log_likelihood(apop_data *d, apop_model *params){
 	return ll;
 }
 
+/* The batched version, for apop_log_likelihoods: get the mean and the sum of squares
+ about the mean once, then for each (mu, sigma), sum (x-mu)^2 = ss + n(mean-mu)^2. */
+void apop_normal_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(d, );
+    Get_vmsizes(d) //tsize
+    double zero = 0;
+    double mean = apop_map_sum(d, .fn_dp = apply_me, .param = &zero)/tsize;
+    long double ss = apop_map_sum(d, .fn_dp = apply_me2, .param = &mean);
+    for (size_t i=0; i< params->size1; i++){
+        double mu = gsl_matrix_get(params, i, 0);
+        double sd = gsl_matrix_get(params, i, 1);
+        gsl_vector_set(out, i, -(ss + tsize*gsl_pow_2(mean-mu))/(2*gsl_pow_2(sd))
+                                - tsize*(M_LNPI+M_LN2+log(sd)));
+    }
+}
+
 /*\adoc estimated_parameters Zeroth vector element is \f$\mu\f$, element 1 is \f$\sigma\f$.
  A page is added named <tt>\<Covariance\></tt> with the 2 \f$\times\f$ 2 covariance matrix for these two parameters
  \adoc estimated_info Reports the log likelihood.*/
@@ -160,6 +177,24 @@ static double lognormal_log_likelihood(apop_data *d, apop_model *params){
 	return ll;
 }
 
+static double ln_x(double x, void *ignored){ return log(x); }
+
+//As with apop_normal_log_likelihoods, but the sums are of ln(x).
+void apop_lognormal_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(d, );
+    Get_vmsizes(d) //tsize
+    double mean = apop_map_sum(d, .fn_dp = ln_x)/tsize;
+    long double ss = apop_map_sum(d, .fn_dp = lnx_minus_mu_squared, .param = &mean);
+    double ln_jacobian = apop_map_sum(d, log, .part='m');
+    for (size_t i=0; i< params->size1; i++){
+        double mu = gsl_matrix_get(params, i, 0);
+        double sd = gsl_matrix_get(params, i, 1);
+        gsl_vector_set(out, i, -(ss + tsize*gsl_pow_2(mean-mu))/(2*gsl_pow_2(sd))
+                                - ln_jacobian - tsize*(M_LNPI+M_LN2+log(sd)));
+    }
+}
+
 /* \adoc estimated_info   Reports <tt>log likelihood</tt>. */
 static apop_model * lognormal_estimate(apop_data * data, apop_model *est){
     apop_data *cp = apop_data_copy(data);
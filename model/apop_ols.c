@@ -46,6 +46,36 @@ Feeling lazy? The program above was good form and demonstrated useful features,
 #include <apop.h>
 int main(){ apop_model_show(apop_estimate(apop_text_to_data("data"), apop_ols)); }
 \endcode
+
+If the data set is too large to fit in memory, you can have the model read it in blocks.
+The estimate depends on the data only via \f$X'X\f$, \f$X'y\f$, and a few other sums,
+so I read each block, add its sums to the running totals (using all of \ref
+apop_opts_type "apop_opts.thread_count" threads), and throw the block away. Give the \ref
+apop_lm_settings group either
+
+\li a \c query, which I will run against the database, reading \c chunk_rows rows at
+a time (default 100,000). To read a large text file, use \ref apop_text_to_db to put it
+in the database first. Or
+\li a \c chunk_fn, which returns the next block of data on each call, or \c NULL
+when there is no more data. It is sent the \c chunk_info pointer on each call. I free
+each block after reading it.
+
+Each block has to be in the same form as an in-memory data set, as per \ref dataprep:
+the dependent variable in the vector or the first column of the matrix, and, for WLS,
+weights in the \c weights vector. Blocks read via \c query have no weights, so for
+WLS, use a \c chunk_fn that fills in each block's \c weights. Give \ref apop_estimate a \c NULL data set:
+
+\code
+apop_model *m = apop_model_copy(apop_ols);
+Apop_model_add_group(m, apop_lm, .query="select y, x1, x2 from bigtab");
+apop_model *est = apop_estimate(NULL, *m);
+\endcode
+
+The parameters, covariance, and t-tests match those from the in-memory version to
+within rounding error, as do the log likelihood and \f$R^2\f$-type statistics for
+unweighted data. With weights, the SSE is \f$\sum w_i \epsilon_i^2\f$, and the log
+likelihood is the weighted log likelihood \f$\sum w_i \ln {\cal N}(\epsilon_i; 0, \sigma)\f$.
+There is no <tt>\<Predicted\></tt> page, because the data is never all in memory at once.
 */
 
 #include "apop_internal.h"
@@ -54,10 +84,16 @@ Apop_settings_copy(apop_lm,
     out->instruments = apop_data_copy(in->instruments);
     if (in->input_distribution)
         out->input_distribution = apop_model_copy(*in->input_distribution);
+    out->factor = apop_matrix_copy(in->factor);
+    out->tau = apop_vector_copy(in->tau);
+    out->factored = apop_matrix_copy(in->factored);
 )
 
 Apop_settings_free(apop_lm,
     apop_model_free(in->input_distribution);
+    if (in->factor) gsl_matrix_free(in->factor);
+    if (in->tau) gsl_vector_free(in->tau);
+    if (in->factored) gsl_matrix_free(in->factored);
 ) 
 
 Apop_settings_init(apop_lm,
@@ -65,29 +101,31 @@ Apop_settings_init(apop_lm,
     if (out->want_expected_value == 1 || !out->want_expected_value) out->want_expected_value = 'y';
     if (!out->input_distribution) 
        out->input_distribution = apop_model_copy(apop_improper_uniform);
+    Apop_varad_set(chunk_rows, 100000);
+    Apop_varad_set(solver, 'c');
 )
 
 //shift first col to depvar, rename first col "one".
-static void prep_names (apop_model *e){
+static void prep_names (apop_model *e, apop_name *names){
     apop_lm_settings *p = apop_settings_get_group(e, apop_lm);
     apop_parts_wanted_settings *pwant = apop_settings_get_group(e, apop_parts_wanted);
     apop_data *predicted = apop_data_get_page(e->info, "<Predicted>");
     if (predicted){
-        apop_name_add(predicted->names, (e->data->names->colct ? e->data->names->column[0] : "Observed"), 'c');
+        apop_name_add(predicted->names, (names->colct ? names->column[0] : "Observed"), 'c');
         apop_name_add(predicted->names, "Predicted", 'c');
         apop_name_add(predicted->names, "Residual", 'c');
     }
-	if (e->data->names->vector) { //this is post ols shuffle.
+	if (names->vector) { //this is post ols shuffle.
         if (e->parameters)
-            snprintf(e->parameters->names->title, 100, "Regression of %s", e->data->names->vector);
+            snprintf(e->parameters->names->title, 100, "Regression of %s", names->vector);
         apop_name_add(e->parameters->names, "parameters", 'v');
-        for(int i=0; i< e->data->names->colct; i++)
-            apop_name_add(e->parameters->names, e->data->names->column[i], 'r');
+        for(int i=0; i< names->colct; i++)
+            apop_name_add(e->parameters->names, names->column[i], 'r');
         if ((pwant && pwant->covariance) || (!pwant && p && p->want_cov== 'y')){
             apop_data *cov = apop_data_get_page(e->parameters, "<Covariance>");
-            if (cov && e->data->names){
-                apop_name_stack(cov->names, e->data->names, 'c');
-                apop_name_stack(cov->names, e->data->names, 'r', 'c');
+            if (cov && names){
+                apop_name_stack(cov->names, names, 'c');
+                apop_name_stack(cov->names, names, 'r', 'c');
             }
         }
 	}
@@ -106,6 +144,8 @@ static void ols_shuffle(apop_data *d){
 }
 
 static void ols_prep(apop_data *d, apop_model *m){
+    apop_lm_settings *olp = Apop_settings_get_group(m, apop_lm);
+    if (olp && (olp->chunk_fn || olp->query)) return; //Streaming; each block is shuffled as it is read.
     ols_shuffle(d);
     void *mpt = m->prep; //also use the defaults.
     m->prep = NULL;
@@ -116,37 +156,55 @@ static void ols_prep(apop_data *d, apop_model *m){
 /* The assumption that makes a log likelihood possible is that the
 errors are normally distributed.
 
-This function is a bit inefficient, in that it calculates the error terms,
-which you may have already done in the OLS estimation.  */
+Both the log likelihood and the score need the error terms and their variance before
+anything else can happen, so the first pass finds X beta via apop_dot_map_sum (without
+writing down a copy of each row) and keeps only the errors. */
+typedef struct {
+    apop_data *d;
+    double beta0;
+    gsl_vector *errors;
+} ols_errpass;
+
+static double ols_error_row(double const *xb, size_t i, void *ctx, double *acc){
+    ols_errpass *ep = ctx;
+    double expected = *xb, actual;
+    if (ep->d->vector) //then this has been prepped
+        actual    = gsl_vector_get(ep->d->vector, i);
+    else {
+        actual    = gsl_matrix_get(ep->d->matrix, i, 0);
+        expected += ep->beta0 * (1 - actual); //data isn't affine.
+    }
+    gsl_vector_set(ep->errors, i, expected-actual);
+    return 0;
+}
+
+static gsl_vector *ols_errors(apop_data *d, apop_model *p){
+    gsl_vector *beta = p->parameters->vector;
+    gsl_matrix_view betam = gsl_matrix_view_vector(beta, beta->size, 1);
+    ols_errpass ep = {.d=d, .beta0=gsl_vector_get(beta, 0), .errors=gsl_vector_alloc(d->matrix->size1)};
+    apop_dot_map_sum(d->matrix, &betam.matrix, ols_error_row, &ep, NULL);
+    return ep.errors;
+}
+
 static double ols_log_likelihood (apop_data *d, apop_model *p){ 
     Nullcheck_mpd(d, p, GSL_NAN); Nullcheck(d->matrix, GSL_NAN);
   long double ll  = 0; 
-  long double sigma, actual, weight;
-  double expected, x_prob;
+  long double sigma, weight;
+  double x_prob = 1;
   apop_lm_settings *lms = Apop_settings_get_group(p, apop_lm);
   apop_model *input_distribution = lms ? lms->input_distribution : NULL;
+  if (input_distribution && input_distribution->p == apop_improper_uniform.p)
+      input_distribution = NULL; //p(x)=1 for every row, so skip the calls.
   gsl_matrix *data	 = d->matrix;
-  gsl_vector *errors = gsl_vector_alloc(data->size1);
-	for (size_t i=0;i< data->size1; i++){
-        Apop_row(d, i, datarow);
-        gsl_blas_ddot(p->parameters->vector, datarow, &expected);
-        if (d->vector){ //then this has been prepped
-            actual    = apop_data_get(d,i, -1);
-        } else {
-            actual    = gsl_matrix_get(data,i, 0);
-            expected += gsl_vector_get(p->parameters->vector,0) * (1 - actual); //data isn't affine.
-        }
-        gsl_vector_set(errors, i, expected-actual);
-    }
+  gsl_vector *errors = ols_errors(d, p);
     sigma   = sqrt(apop_vector_var(errors));
 	for(size_t i=0;i< data->size1; i++){
-        Apop_row(d, i, datarow);
-        gsl_matrix_view m = gsl_matrix_view_vector(datarow, 1, datarow->size);
-        apop_data justarow = {.matrix=&(m.matrix)};
-        if (input_distribution)
-            x_prob = apop_p(&justarow, input_distribution); //probably improper uniform, and so just 1 anyway.
-        else
-            x_prob = 1;
+        if (input_distribution){
+            Apop_row(d, i, datarow);
+            gsl_matrix_view m = gsl_matrix_view_vector(datarow, 1, datarow->size);
+            apop_data justarow = {.matrix=&(m.matrix)};
+            x_prob = apop_p(&justarow, input_distribution);
+        }
         weight       = d->weights ? gsl_vector_get(d->weights, i) : 1; 
         ll  += log(gsl_ran_gaussian_pdf(gsl_vector_get(errors, i), sigma)* weight * x_prob);
 	} 
@@ -154,72 +212,221 @@ static double ols_log_likelihood (apop_data *d, apop_model *p){
     return ll;
 }
 
-/* $\partial {\cal N}(x\beta - y)/\partial \beta_i = \sum{x_i} \partial {\cal N}(K)/\partial K$ (at $K=x\beta -y$) */
+/* $\partial {\cal N}(x\beta - y)/\partial \beta_i = \sum{x_i} \partial {\cal N}(K)/\partial K$ (at $K=x\beta -y$).
+ The Normal's score with respect to its mean is just K/sigma^2, so the whole gradient
+ is X'(w .* errors)/sigma^2, one matrix-vector product. */
 static void ols_score(apop_data *d, gsl_vector *gradient, apop_model *p){ 
     Nullcheck_mpd(d, p, ); Nullcheck(d->matrix, );
-  long double sigma, actual, weight;
-  double expected;
-  gsl_matrix *data	= d->matrix;
-  gsl_vector *errors = gsl_vector_alloc(data->size1);
-  gsl_vector *normscore = gsl_vector_alloc(2);
-  apop_data  *subdata  = apop_data_alloc(1,1);
-	for(size_t i=0;i< data->size1; i++){
-        APOP_ROW(d, i, datarow);
-        gsl_blas_ddot(p->parameters->vector, datarow, &expected);
-        if (d->vector){ //then this has been prepped
-            actual       = apop_data_get(d,i, -1);
-        } else {
-            actual       = gsl_matrix_get(data,i, 0);
-            expected    +=  gsl_vector_get(p->parameters->vector,0) * (1 - actual); //data isn't affine.
-        }
-        gsl_vector_set(errors, i, expected-actual);
-    }
-    sigma   = sqrt(apop_vector_var(errors));
-    apop_model *norm = apop_model_set_parameters(apop_normal, 0.0, sigma);
-    gsl_vector_set_all(gradient, 0);
-	for(size_t i=0;i< data->size1; i++){
-        apop_data_set(subdata, 0, 0, gsl_vector_get(errors, i));
-        apop_score(subdata, normscore, norm);
-        weight = d->weights ? gsl_vector_get(d->weights, i) : 1; 
-        for(size_t j=0; j< data->size2; j++)
-            apop_vector_increment(gradient, j, weight * apop_data_get(d, i, j) * gsl_vector_get(normscore, 0));
-	} 
+  gsl_vector *errors = ols_errors(d, p);
+  long double sigma   = sqrt(apop_vector_var(errors));
+    if (d->weights) gsl_vector_mul(errors, d->weights);
+    gsl_blas_dgemv(CblasTrans, 1/gsl_pow_2(sigma), d->matrix, errors, 0, gradient);
     gsl_vector_free(errors);
-    apop_model_free(norm);
+}
+
+/* Out-of-core estimation. The OLS estimate depends on the data only via a few sums
+over rows, so we can read the data a block at a time and keep only running totals.
+
+Let A=[X y] be a block with the dependent variable as the last column, each row
+scaled by the root of its weight. We keep A'A, which has X'X, X'y, and y'y as
+subblocks; the weighted column sums, for the R^2 and log likelihood; and the total
+weight. These are packed into one vector, in that order. Each chunk of a block (of
+apop_pool_fixed_chunk rows, threaded or not) writes its sums to its own slot, the slots
+are added pairwise, and the block total is added to the running total with Kahan
+compensation, so the result depends neither on the thread count nor on how badly the
+running total dwarfs each new block.  */
+typedef struct {
+    size_t k, n;        //columns of X, including the constant; rows read so far.
+    gsl_vector *sums, *comp; //running totals, and the Kahan compensation for each.
+    apop_name *names;   //from the first block.
+    char error;
+} ols_stream;
+
+typedef struct {
+    apop_data const *d;
+    size_t k, chunk;
+    gsl_vector **slots;
+} stream_chunk_pass;
+
+#define Stream_ata(s, k) gsl_matrix_view_array((s)->data, (k)+1, (k)+1)
+#define Stream_colsums(s, k) gsl_vector_subvector((s), ((k)+1)*((k)+1), (k)+1)
+#define Stream_wsum(s, k) (s)->data[((k)+1)*((k)+2)]
+
+static void stream_chunk(void *ctx, size_t lo, size_t hi, int worker){
+    stream_chunk_pass *sp = ctx;
+    gsl_vector *slot = sp->slots[lo/sp->chunk];
+    gsl_matrix *a = gsl_matrix_alloc(hi-lo, sp->k+1);
+    gsl_vector *root_w = gsl_vector_alloc(hi-lo);
+    long double wsum = 0;
+    for (size_t i=lo; i< hi; i++){
+        double w = sp->d->weights ? gsl_vector_get(sp->d->weights, i) : 1;
+        double rw = sqrt(w);
+        wsum += w;
+        gsl_vector_set(root_w, i-lo, rw);
+        for (size_t j=0; j< sp->k; j++)
+            gsl_matrix_set(a, i-lo, j, rw * gsl_matrix_get(sp->d->matrix, i, j));
+        gsl_matrix_set(a, i-lo, sp->k, rw * gsl_vector_get(sp->d->vector, i));
+    }
+    gsl_matrix_view ata = Stream_ata(slot, sp->k);
+    gsl_blas_dsyrk(CblasLower, CblasTrans, 1, a, 0, &ata.matrix);
+    gsl_vector_view colsums = Stream_colsums(slot, sp->k);
+    gsl_blas_dgemv(CblasTrans, 1, a, root_w, 0, &colsums.vector); //sum of w_i a_i/sqrt(w_i)
+    Stream_wsum(slot, sp->k) = wsum;
+    gsl_matrix_free(a);
+    gsl_vector_free(root_w);
+}
+
+//Add one block to the running totals. The block is ours to shuffle and free.
+static int stream_block(apop_data *d, void *info){
+    ols_stream *s = info;
+    Apop_stopif(!d->matrix, s->error='d'; apop_data_free(d); return 1, 0, "A block of input data has no matrix.");
+    ols_shuffle(d);
+    if (!s->sums){
+        s->k = d->matrix->size2;
+        s->sums = gsl_vector_calloc((s->k+1)*(s->k+2) + 1);
+        s->comp = gsl_vector_calloc(s->sums->size);
+        s->names = apop_name_copy(d->names);
+    }
+    Apop_stopif(d->matrix->size2 != s->k, s->error='d'; apop_data_free(d); return 1, 0,
+            "A block of input data has %zu columns, but earlier blocks had %zu.", d->matrix->size2, s->k);
+    size_t n = d->matrix->size1;
+    if (!n) {apop_data_free(d); return 0;}
+    size_t chunk = apop_pool_fixed_chunk(n), chunk_ct = (n + chunk - 1)/chunk;
+    gsl_vector *slots[chunk_ct];
+    for (size_t c=0; c< chunk_ct; c++) slots[c] = gsl_vector_alloc(s->sums->size);
+    stream_chunk_pass sp = {.d=d, .k=s->k, .chunk=chunk, .slots=slots};
+    if (apop_opts.thread_count <= 1)
+        for (size_t lo=0; lo< n; lo+=chunk) stream_chunk(&sp, lo, GSL_MIN(n, lo+chunk), 0);
+    else apop_pool_run(stream_chunk, &sp, n, chunk);
+
+    for (size_t step=1; step< chunk_ct; step *= 2)
+        for (size_t c=0; c+step < chunk_ct; c += 2*step)
+            gsl_vector_add(slots[c], slots[c+step]);
+    for (size_t i=0; i< s->sums->size; i++){
+        double y = gsl_vector_get(slots[0], i) - s->comp->data[i];
+        double t = s->sums->data[i] + y;
+        s->comp->data[i] = (t - s->sums->data[i]) - y;
+        s->sums->data[i] = t;
+    }
+    s->n += n;
+    for (size_t c=0; c< chunk_ct; c++) gsl_vector_free(slots[c]);
+    apop_data_free(d);
+    return 0;
+}
+
+/* Factor X'X (solver 'c') or X (solver 'q') into the settings group, where it stays
+ for apop_lm_solve. A Cholesky factor is reused if X'X hasn't changed since it was
+ built. Returns nonzero if the factorization failed, so the caller can fall back
+ to the inverse.  */
+static int lm_factor(apop_lm_settings *p, apop_data const *data, gsl_matrix const *xpx, char solver){
+    if (solver == 'c' && p->factored_by == 'c' && apop_same_matrix(p->factored, xpx)) return 0;
+    if (p->factor) gsl_matrix_free(p->factor);
+    if (p->tau) gsl_vector_free(p->tau);
+    if (p->factored) gsl_matrix_free(p->factored);
+    p->tau = NULL;
+    p->factored = apop_matrix_copy(xpx);
+    p->factored_by = solver;
+    size_t k = xpx->size1;
+    gsl_error_handler_t *prior_handler = gsl_set_error_handler(apop_gsl_error);
+    int status;
+    if (solver == 'q'){
+        p->factor = apop_matrix_copy(data->matrix);
+        p->tau = gsl_vector_alloc(GSL_MIN(data->matrix->size1, k));
+        status = gsl_linalg_QR_decomp(p->factor, p->tau);
+    } else {
+        p->factor = apop_matrix_copy(xpx);
+        status = gsl_linalg_cholesky_decomp(p->factor);
+    }
+    gsl_set_error_handler(prior_handler);
+    double det = 1; //the product of the squared diagonal of R or L is det(X'X).
+    for (size_t i=0; !status && i< k; i++){
+        det *= gsl_pow_2(gsl_matrix_get(p->factor, i, i));
+        if (!gsl_matrix_get(p->factor, i, i)) status = GSL_ESING;
+    }
+    Apop_stopif(status || !isfinite(det), gsl_matrix_free(p->factor); p->factor=NULL;
+            p->factored_by = 0; return 1, 1, "Couldn't factor X'X; falling back to inverting it.");
+    if (det < 1e-4) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
+                        "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", det);
+    return 0;
+}
+
+//(X'X)^{-1} from the factorization: X'X = LL' for Cholesky, and R'R for QR.
+static gsl_matrix *lm_factor_inverse(apop_lm_settings const *p){
+    size_t k = p->factored->size1;
+    gsl_matrix *out = gsl_matrix_alloc(k, k);
+    gsl_matrix_set_identity(out);
+    gsl_matrix_const_view f = gsl_matrix_const_submatrix(p->factor, 0, 0, k, k);
+    if (p->factored_by == 'q'){
+        gsl_blas_dtrsm(CblasLeft, CblasUpper, CblasTrans, CblasNonUnit, 1, &f.matrix, out);   //R'^{-1}
+        gsl_blas_dtrsm(CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit, 1, &f.matrix, out); //R^{-1}R'^{-1}
+    } else {
+        gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1, &f.matrix, out); //L^{-1}
+        gsl_blas_dtrsm(CblasLeft, CblasLower, CblasTrans, CblasNonUnit, 1, &f.matrix, out);   //L'^{-1}L^{-1}
+    }
+    return out;
+}
+
+//Solve for beta via the factorization: LL'beta = X'y for Cholesky, or the least-squares solution of QR beta = y.
+static void lm_factor_solve(apop_lm_settings const *p, gsl_vector const *y, gsl_vector const *xpy, gsl_vector *beta){
+    if (p->factored_by == 'q'){
+        gsl_vector *resid = gsl_vector_alloc(y->size);
+        gsl_linalg_QR_lssolve(p->factor, p->tau, y, beta, resid);
+        gsl_vector_free(resid);
+    } else gsl_linalg_cholesky_solve(p->factor, xpy, beta);
 }
 
 //xpx may be destroyed by the HH transformation.
-static void xpxinvxpy(apop_data const*data, gsl_matrix *xpx, apop_data const* xpy, apop_model *out){
+//If the data was streamed, data==NULL and the sums in s stand in for it.
+//The solver is as per apop_lm_settings.solver; X'X has to be symmetric for any but 'i'.
+static void xpxinvxpy(apop_data const*data, gsl_matrix *xpx, apop_data const* xpy, apop_model *out, ols_stream const *s, char solver){
     apop_lm_settings   *p =  apop_settings_get_group(out, apop_lm);
     apop_parts_wanted_settings *pwant = apop_settings_get_group(out, apop_parts_wanted);
+    if (solver == 'q' && (!data || data->matrix->size1 < xpx->size1))
+        solver = 'c'; //there's no X to factor, or it's too short for QR.
+    if (solver != 'i' && lm_factor(p, data, xpx, solver)) solver = 'i';
 	if ( (pwant && pwant->covariance!='y' && pwant->predicted != 'y') 
        ||(!pwant && p && p->want_cov!='y' && p->want_expected_value != 'y')){	
 		//then don't calculate (X'X)^{-1}
-		gsl_linalg_HH_solve (xpx, xpy->vector, out->parameters->vector);
+        if (solver != 'i')
+            lm_factor_solve(p, data ? data->vector : NULL, xpy->vector, out->parameters->vector);
+        else
+            gsl_linalg_HH_solve (xpx, xpy->vector, out->parameters->vector);
 		return;
 	} //else:
     double s_sq;
-    gsl_vector const *y_data = data->vector; //just an alias
     apop_data *cov = apop_data_alloc();
-    double det = apop_det_and_inv(xpx, &cov->matrix, 1, 1);// not yet cov, just (X'X)^-1.
-    if (det < 1e-4) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
-                        "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", det);
-    apop_data_free(out->parameters);
-    out->parameters = apop_dot(cov, xpy);               // \beta=(X'X)^{-1}X'Y
-    apop_data *error = apop_dot(data, out->parameters); // X\beta ==predicted (not yet error)
-	gsl_vector_sub(error->vector, y_data);              // X'\beta - Y == error
-    gsl_blas_ddot(error->vector, error->vector, &s_sq); // e'e
-    s_sq /= data->matrix->size1 - data->matrix->size2;  // \sigma^2 = e'e / df
-	gsl_matrix_scale(cov->matrix, s_sq);                // cov = \sigma^2 (X'X)^{-1}
-	if ((pwant && pwant->predicted) || (!pwant && p && p->want_expected_value)){
-        gsl_matrix *predicted_page = apop_data_get_page(out->info, "<Predicted>")->matrix;
-        gsl_matrix_set_col(predicted_page, 0, y_data);
-        gsl_matrix_set_col(predicted_page, 2, error->vector);
-        Apop_matrix_col(predicted_page, 1, predicted);
-        gsl_vector_memcpy(predicted, y_data);
-        gsl_vector_add(predicted, error->vector); //pred = y_data + error
+    if (solver != 'i'){
+        cov->matrix = lm_factor_inverse(p);
+        lm_factor_solve(p, data ? data->vector : NULL, xpy->vector, out->parameters->vector);
+    } else {
+        double det = apop_det_and_inv(xpx, &cov->matrix, 1, 1);// not yet cov, just (X'X)^-1.
+        if (det < 1e-4) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
+                            "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", det);
+        apop_data_free(out->parameters);
+        out->parameters = apop_dot(cov, xpy);           // \beta=(X'X)^{-1}X'Y
+    }
+    if (!data){ //streamed, so e'e = y'y - \beta'X'y.
+        gsl_matrix_view ata = Stream_ata(s->sums, s->k);
+        gsl_blas_ddot(out->parameters->vector, xpy->vector, &s_sq);
+        s_sq = (gsl_matrix_get(&ata.matrix, s->k, s->k) - s_sq) / (s->n - s->k);
+        gsl_matrix_scale(cov->matrix, s_sq);
+    } else {
+        gsl_vector const *y_data = data->vector; //just an alias
+        apop_data *error = apop_dot(data, out->parameters); // X\beta ==predicted (not yet error)
+        gsl_vector_sub(error->vector, y_data);              // X'\beta - Y == error
+        gsl_blas_ddot(error->vector, error->vector, &s_sq); // e'e
+        s_sq /= data->matrix->size1 - data->matrix->size2;  // \sigma^2 = e'e / df
+        gsl_matrix_scale(cov->matrix, s_sq);                // cov = \sigma^2 (X'X)^{-1}
+        if ((pwant && pwant->predicted) || (!pwant && p && p->want_expected_value)){
+            gsl_matrix *predicted_page = apop_data_get_page(out->info, "<Predicted>")->matrix;
+            gsl_matrix_set_col(predicted_page, 0, y_data);
+            gsl_matrix_set_col(predicted_page, 2, error->vector);
+            Apop_matrix_col(predicted_page, 1, predicted);
+            gsl_vector_memcpy(predicted, y_data);
+            gsl_vector_add(predicted, error->vector); //pred = y_data + error
+        }
+        apop_data_free(error);
     }
-    apop_data_free(error);
     if (apop_data_get_page(out->parameters, "<Covariance>"))
         apop_data_rm_page(out->parameters, "<Covariance>");
     apop_data_add_page(out->parameters, cov, "<Covariance>");
@@ -268,6 +475,87 @@ static void ols_rng(double *out, gsl_rng *r, apop_model *m){
     gsl_vector_free(tempdata);
 }
 
+static apop_model *apop_estimate_OLS_stream(apop_data *inset, apop_model *ep, apop_lm_settings *olp){
+    apop_parts_wanted_settings *pwant = apop_settings_get_group(ep, apop_parts_wanted);
+    ols_stream s = { };
+    if (olp->query){
+        int rc = apop_query_to_blocks(olp->query, olp->chunk_rows, stream_block, &s);
+        if (rc && !s.error) s.error = 'q';
+    } else
+        for (apop_data *d; !s.error && (d = olp->chunk_fn(olp->chunk_info)); )
+            stream_block(d, &s);
+    ep->data = inset;
+    if (!ep->info) ep->info = apop_data_alloc();
+    snprintf(ep->info->names->title, 100, "Info");
+    Apop_stopif(!s.error && s.n <= s.k, s.error='d', 0, "I read %zu rows of data, which is "
+            "too few to estimate %zu parameters.", s.n, s.k);
+    Apop_stopif(s.error, ep->error=s.error; goto done, 0, "Error reading the input data; "
+            "returning a model with error='%c'.", s.error);
+
+    size_t k = s.k, n = s.n;
+    ep->dsize = k;
+    apop_data_free(ep->parameters);
+    ep->parameters = apop_data_alloc(k);
+    gsl_matrix_view ata = Stream_ata(s.sums, k);
+    gsl_vector_view colsums = Stream_colsums(s.sums, k);
+    double wsum = Stream_wsum(s.sums, k),
+           ypy = gsl_matrix_get(&ata.matrix, k, k),
+           wy = gsl_vector_get(&colsums.vector, k);
+    apop_data *xpx_d = apop_data_alloc(k, k), *xpy_d = apop_data_alloc(k);
+    for (size_t i=0; i< k; i++){
+        for (size_t j=0; j<= i; j++){ //dsyrk only filled the lower triangle.
+            gsl_matrix_set(xpx_d->matrix, i, j, gsl_matrix_get(&ata.matrix, i, j));
+            gsl_matrix_set(xpx_d->matrix, j, i, gsl_matrix_get(&ata.matrix, i, j));
+        }
+        gsl_vector_set(xpy_d->vector, i, gsl_matrix_get(&ata.matrix, k, i));
+    }
+    xpxinvxpy(NULL, xpx_d->matrix, xpy_d, ep, &s, olp->solver);
+    prep_names(ep, s.names);
+
+    //Residual moments: sum w e^2 = y'y - \beta'X'y and sum w e = sum w y - \beta' sum w x.
+    double bxy, bwx;
+    gsl_blas_ddot(ep->parameters->vector, xpy_d->vector, &bxy);
+    gsl_vector_view wx = gsl_vector_subvector(&colsums.vector, 0, k);
+    gsl_blas_ddot(ep->parameters->vector, &wx.vector, &bwx);
+    double sse = ypy - bxy, we = wy - bwx,
+           len = (wsum < 1.1 ? n : wsum); //as in apop_vector_weighted_var.
+    double sst = (ypy/len - gsl_pow_2(wy/len)) * len/(len-1.) * (n-1.);
+    double sigma_sq = (sse/len - gsl_pow_2(we/len)) * len/(len-1.);
+    apop_data_free(xpx_d);
+    apop_data_free(xpy_d);
+
+    if ((pwant && pwant->covariance) || (!pwant && olp->want_cov=='y')){
+        int df = GSL_MAX(1, (int)(n - k));
+        apop_data *ep_tests = apop_data_add_page(ep->info, apop_data_alloc(k, 2), "<test info>");
+        apop_name_add(ep_tests->names, "p value", 'c');
+        apop_name_add(ep_tests->names, "confidence", 'c');
+        apop_name_stack(ep_tests->names, ep->parameters->names, 'r', 'r');
+        apop_data_add_named_elmt(ep->info, "df", df);
+        apop_data *zero = apop_data_calloc(1, 1);
+        for (size_t i=0; i< k; i++){
+            apop_model *t = apop_model_set_parameters(apop_t_distribution, ep->parameters->vector->data[i],
+                                sqrt(apop_data_get(ep->parameters, i, i, .page="<Covariance>")), df);
+            double conf = 2*fabs(0.5-apop_cdf(zero, t));
+            apop_data_set(ep_tests, i, .colname="confidence", .val=conf);
+            apop_data_set(ep_tests, i, .colname="p value",    .val=1-conf);
+            apop_model_free(t);
+        }
+        apop_data_free(zero);
+    }
+    apop_data_add_named_elmt(ep->info, "log likelihood", -wsum/2.*log(2*M_PI*sigma_sq) - sse/(2*sigma_sq));
+    apop_data_add_named_elmt(ep->info, "R_squared", 1 - sse/sst);
+    apop_data_add_named_elmt(ep->info, "R_squared_adj", 1 - (n-1.)/(n-k+1.) * (sse/sst));
+    apop_data_add_named_elmt(ep->info, "SSE", sse);
+    apop_data_add_named_elmt(ep->info, "SST", sst);
+    apop_data_add_named_elmt(ep->info, "SSR", sst - sse);
+
+    done:
+    gsl_vector_free(s.sums);
+    gsl_vector_free(s.comp);
+    apop_name_free(s.names);
+    return ep;
+}
+
 /* \adoc estimated_data You can specify whether the data is modified with an \ref apop_lm_settings group. If so, see \ref dataprep for details. Else, left unchanged.
 
 \adoc estimated_parameters
@@ -294,9 +582,10 @@ Given your estimate \c est, the zeroth element is one of <br>
 <tt> apop_data_get(est->info, .page= "Predicted", .row=0, .colname="residual").</tt><br>
 */
 static apop_model * apop_estimate_OLS(apop_data *inset, apop_model *ep){
+    apop_lm_settings *olp =  apop_settings_get_group(ep, apop_lm);
+    if (olp && (olp->chunk_fn || olp->query)) return apop_estimate_OLS_stream(inset, ep, olp);
     Nullcheck_mpd(inset, ep, NULL);
     apop_data *set;
-    apop_lm_settings *olp =  apop_settings_get_group(ep, apop_lm);
     apop_parts_wanted_settings *pwant = apop_settings_get_group(ep, apop_parts_wanted);
     if (!olp) 
         olp = Apop_model_add_group(ep, apop_lm);
@@ -315,15 +604,15 @@ static apop_model * apop_estimate_OLS(apop_data *inset, apop_model *ep){
     if ((pwant &&pwant->covariance) || (!pwant && olp && olp->want_cov=='y'))
         apop_data_add_page(ep->parameters, apop_data_alloc(0, set->matrix->size2, set->matrix->size2), "<Covariance>");
     if (weights)
-        for (int i = -1; i < set->matrix->size2; i++){
+        for (int i = -1; i < (int)set->matrix->size2; i++){
             APOP_COL(set, i, v);
             gsl_vector_mul(v, weights);
         }
 
     apop_data *xpx_d = apop_dot(set, set, .form1='t'); //(X'X)
     apop_data *xpy_d = apop_dot(set, set, .form1='t', .form2='v'); //(X'y)
-    xpxinvxpy(set, xpx_d->matrix, xpy_d, ep);
-    prep_names(ep);
+    xpxinvxpy(set, xpx_d->matrix, xpy_d, ep, NULL, olp->solver);
+    prep_names(ep, ep->data->names);
     apop_data_free(xpx_d);
     apop_data_free(xpy_d);
 
@@ -340,6 +629,74 @@ static apop_model * apop_estimate_OLS(apop_data *inset, apop_model *ep){
     return ep;
 }
 
+/** Find OLS coefficients for many dependent variables that share one set of
+independent variables, reusing the factorization of \f$X\f$ or \f$X'X\f$ from an
+earlier \ref apop_ols estimation. The factorization is not redone, and all of the
+dependent variables are solved for at once, so this is much faster than one
+estimation per dependent variable.
+
+\code
+apop_model *est = apop_estimate(data, apop_ols);
+apop_data *betas = apop_lm_solve(est, other_ys); //one column of other_ys per dependent variable
+\endcode
+
+\li The output has only the coefficients. For covariances and the other estimation
+output, estimate the model with each dependent variable (the factorization will
+still be reused when using the Cholesky solver).
+\li If the data was weighted, the same weights apply to every dependent variable.
+
+\param est An \ref apop_ols model estimated with the \ref apop_lm_settings group's \c
+solver set to \c 'c' (the default) or \c 'q'. Its \c data element, as prepped for
+estimation (see \ref dataprep), gives \f$X\f$ and any weights, so it can't have
+been mangled via <tt>.destroy_data='y'</tt>.
+\param y A data set whose \c matrix has a column for each dependent variable, and a row
+for each row of <tt>est->data</tt>.
+\return A data set whose \c matrix has a column of coefficients for each column of \c y,
+with rows named as in <tt>est->parameters</tt> and columns named as in \c y.
+\exception out->error=='f' The model has no cached factorization.
+\exception out->error=='d' The model's data is missing, doesn't match \c y, or was mangled.
+\ingroup regression
+*/
+apop_data *apop_lm_solve(apop_model *est, apop_data *y){
+    Nullcheck_m(est, NULL); Nullcheck_d(y, NULL);
+    apop_lm_settings *p = Apop_settings_get_group(est, apop_lm);
+    Apop_stopif(!p || !p->factor, apop_return_data_error(f), 0, "I couldn't find a factorization "
+            "of X in the model. Was it estimated via apop_ols with .solver='c' or 'q'?");
+    apop_data const *x = est->data;
+    Apop_stopif(!x || !x->matrix || !y->matrix || x->matrix->size1 != y->matrix->size1,
+            apop_return_data_error(d), 0, "I need the estimated model's data and y to have the same number of rows.");
+    Apop_stopif(p->destroy_data && x->weights, apop_return_data_error(d), 0,
+            "The model's data was weighted in place (via .destroy_data='y'), so I can't use it again.");
+    size_t k = x->matrix->size2, n = x->matrix->size1;
+    apop_data *out = apop_data_alloc(k, y->matrix->size2);
+    gsl_matrix *wy = y->matrix;
+    if (x->weights){ //X'WY for Cholesky; the root weights for QR, as X is the factor of W^{1/2}X.
+        wy = apop_matrix_copy(y->matrix);
+        for (size_t i=0; i< n; i++){
+            Apop_matrix_row(wy, i, onerow);
+            double w = gsl_vector_get(x->weights, i);
+            gsl_vector_scale(onerow, p->factored_by == 'q' ? sqrt(w) : w);
+        }
+    }
+    if (p->factored_by == 'q'){
+        gsl_vector *resid = gsl_vector_alloc(n);
+        for (size_t j=0; j< wy->size2; j++){
+            Apop_matrix_col(wy, j, ycol);
+            Apop_matrix_col(out->matrix, j, beta);
+            gsl_linalg_QR_lssolve(p->factor, p->tau, ycol, beta, resid);
+        }
+        gsl_vector_free(resid);
+    } else { //LL' beta = X'Y
+        gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, x->matrix, wy, 0, out->matrix);
+        gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1, p->factor, out->matrix);
+        gsl_blas_dtrsm(CblasLeft, CblasLower, CblasTrans, CblasNonUnit, 1, p->factor, out->matrix);
+    }
+    if (wy != y->matrix) gsl_matrix_free(wy);
+    if (est->parameters) apop_name_stack(out->names, est->parameters->names, 'r');
+    apop_name_stack(out->names, y->names, 'c');
+    return out;
+}
+
 /* \adoc predict This function is limited to taking in a data set with a matrix, and
 filling the vector with \f$X\beta\f$. Like, the OLS estimation will shuffle a matrix around
 to insert a column of ones (see \ref dataprep).
@@ -455,7 +812,7 @@ static apop_model * apop_estimate_IV(apop_data *inset, apop_model *ep){
 
     if ((pwant && pwant->predicted) || (!pwant && olp && olp->want_expected_value))
         apop_data_add_page(ep->info, apop_data_alloc(set->matrix->size1, 3), "<Predicted>");
-    prep_names(ep);
+    prep_names(ep, ep->data->names);
     if (weights){
         gsl_vector_mul(set->vector, weights);
         for (int i = 0; i < set->matrix->size2; i++){
@@ -467,7 +824,7 @@ static apop_model * apop_estimate_IV(apop_data *inset, apop_model *ep){
     apop_data *zpx = apop_dot(z, set, .form1='t');
     apop_data *zpy = apop_dot(z, set, .form1='t', .form2='v'); //z'y
 
-    xpxinvxpy(inset, zpx->matrix, zpy, ep);
+    xpxinvxpy(inset, zpx->matrix, zpy, ep, NULL, 'i');
 
     //covariance matrix right now is sigma (Z'X)^-1. We need
     //sigma (Z'X)^-1 (Z'Z) (X'Z)^-1
@@ -50,6 +50,16 @@ apop_model *my_pmf = apop_estimate(in_data, apop_pmf);
 equally probable.
 \li If the \c weights are present but sum to a not-finite value, the model's \c error element is set to \c 'w' when the estimation is run, and a warning printed.
 
+\li The first time you call the \c p or \c log_likelihood method, I build a hash index of
+the rows of the PMF's data, so each observation is found in constant time rather than via a
+search through every row. The index is kept in the model's \ref apop_pmf_settings group.
+It is dropped when the model is estimated, and rebuilt if you point the model to a data
+set at a different address or the row count changes. Otherwise, the data is assumed not
+to change after the first call: if you modify the data or weights in place (or free the
+data set and point the model to a new one of the same size that happens to be allocated
+at the same address), call \ref apop_pmf_invalidate before the next call to \c p or
+\c draw. Otherwise, \c p may report zero probability for rows that are in the data.
+
 \li Be careful: the weights are in the \c weights element of the \c apop_data set, not in
 the \c vector element. If you put the weights in the \c vector and have \c NULL \c
 weights, then draws are equiprobable. This will be difficult to debug.
@@ -62,19 +72,62 @@ weights, then draws are equiprobable. This will be difficult to debug.
 
 #include "apop_internal.h"
 
+/* A hash table of the rows of a data set, so that finding a row (or its first
+   duplicate) doesn't require a scan over the whole set. The table is open-addressed,
+   with each slot holding a row number (-1 for empty) and that row's hash. */
+typedef struct apop_pmf_index {
+    apop_data const *data; //the data set indexed, and its row count, to check that it's still current.
+    int rowct;
+    size_t mask;
+    int *rows;
+    unsigned long long *hashes;
+} apop_pmf_index;
+
+static void pmf_index_free(apop_pmf_index *ix){
+    if (!ix) return;
+    free(ix->rows);
+    free(ix->hashes);
+    free(ix);
+}
+
+static void alias_clear(apop_pmf_settings *settings){
+    if (settings->alias_probs) gsl_vector_free(settings->alias_probs);
+    free(settings->aliases);
+    settings->alias_probs = NULL;
+    settings->aliases = NULL;
+}
+
+//Drop what's built from the data, to be rebuilt on demand: the row index and the CMF.
+static void pmf_caches_clear(apop_pmf_settings *settings){
+    pmf_index_free(settings->index);
+    settings->index = NULL;
+    if (settings->cmf && !(--settings->cmf_refct)) gsl_vector_free(settings->cmf);
+    settings->cmf = NULL;
+    settings->cmf_refct = 1;
+}
+
 Apop_settings_copy(apop_pmf,
     if (in->cmf){
         out->cmf = apop_vector_copy(in->cmf);
         out->cmf_refct++;
     }
+    out->index = NULL; //rebuilt on demand.
+    if (in->alias_probs){
+        out->alias_probs = apop_vector_copy(in->alias_probs);
+        out->aliases = malloc(sizeof(size_t)*in->alias_probs->size);
+        memcpy(out->aliases, in->aliases, sizeof(size_t)*in->alias_probs->size);
+    }
 )
 
 Apop_settings_free(apop_pmf,
     if (!(--in->cmf_refct)) gsl_vector_free(in->cmf);
+    pmf_index_free(in->index);
+    alias_clear(in);
 ) 
 
 Apop_settings_init(apop_pmf,
     Apop_varad_set(draw_index, 'n')
+    Apop_varad_set(draw_method, 'c')
     out->cmf_refct = 1;
 )
 
@@ -87,6 +140,8 @@ static apop_model *estim (apop_data *d, apop_model *out){
 
     apop_pmf_settings *settings = Apop_settings_get_group(out, apop_pmf);
     if (!settings) settings = Apop_model_add_group(out, apop_pmf);
+    pmf_caches_clear(settings); //d may be new, or edited since the caches were built.
+    alias_clear(settings);
     if (d->weights) {
         settings->total_weight = apop_sum(d->weights);
         Apop_stopif(!isfinite(settings->total_weight),
@@ -95,6 +150,38 @@ static apop_model *estim (apop_data *d, apop_model *out){
     return out;
 }
 
+/** Tell a PMF that its data set has changed. The PMF's \c p method looks up rows via an
+index built on the first call, draws use a CMF or alias table built on the first draw, and the total
+weight is found when the model is estimated, all on the assumption that the data and
+weights don't change. If you modify them in place, call this before the next call to \c
+p or \c draw, and I will drop those caches, to be rebuilt from the current data.
+
+\code
+apop_model *pmf = apop_estimate(d, apop_pmf);
+double before = apop_p(row, pmf);
+apop_data_set(d, 0, 0, 3.2);
+apop_pmf_invalidate(pmf);
+double after = apop_p(row, pmf);
+\endcode
+
+\param pmf An \ref apop_pmf model. If it has no \ref apop_pmf_settings group, nothing
+has been cached, and this does nothing.
+\exception pmf->error='w' The weights sum to a non-finite value.
+\ingroup models
+*/
+void apop_pmf_invalidate(apop_model *pmf){
+    Nullcheck_m(pmf, );
+    apop_pmf_settings *settings = Apop_settings_get_group(pmf, apop_pmf);
+    if (!settings) return;
+    pmf_caches_clear(settings);
+    alias_clear(settings);
+    if (pmf->data && pmf->data->weights){
+        settings->total_weight = apop_sum(pmf->data->weights);
+        Apop_stopif(!isfinite(settings->total_weight),
+            pmf->error='w', 0, "total weight in the input data is %Lg.\n", settings->total_weight);
+    }
+}
+
 /* \adoc    RNG  Return the data in a random row of the PMF's data set. If there is a
       weights vector, i will use that to make draws; else all rows are equiprobable.
 
@@ -111,35 +198,104 @@ Function). For an especially large data set this may take a human-noticeable amo
 of time. The CMF will be stored in <tt>parameters->weights[1]</tt>, and subsequent
 draws will have no computational overhead. 
 
+\li If you set \c draw_method to \c 'a', then the first draw will instead generate an
+alias table (via Vose's method), and each subsequent draw takes constant time, rather
+than the time for a binary search of the CMF. This is worth it for large PMFs that you
+draw from many times. E.g.,
+
+\code
+Apop_settings_add(your_model, apop_pmf, draw_method, 'a');
+\endcode
+
+The alias table is dropped when the model is estimated, and rebuilt if the weights
+vector changes size. Otherwise, the weights are assumed not to change after the first
+draw: if you modify them in place, call \ref apop_pmf_invalidate before the next draw.
+
+\li \ref apop_model_draws does the setup and checks once, then fills its matrix with draws.
+
 \exception m->error='f' There is zero or NaN density in the CMF. I set the model's \c error element to \c 'f' and set <tt>out=NAN</tt>.
 \exception m->error='a' Allocation error. I set the model's \c error element to \c 'a' and set <tt>out=NAN</tt>. Maybe try \ref apop_data_pmf_compress first?
 */
-static void draw (double *out, gsl_rng *r, apop_model *m){
-    Nullcheck_m(m, ) Nullcheck_d(m->data, )
-    apop_pmf_settings *settings = Apop_settings_get_group(m, apop_pmf);
-    if (!settings) settings = Apop_model_add_group(m, apop_pmf);
-    Get_vmsizes(m->data) //maxsize
+static int cmf_setup(apop_model *m, apop_pmf_settings *settings){
+    size_t size = m->data->weights->size;
+    settings->cmf = gsl_vector_alloc(size);
+    Apop_stopif(!settings->cmf, m->error='a'; return 1,
+            0, "Allocation error setting up the CMF.");
+    gsl_vector *cdf = settings->cmf; //alias.
+    cdf->data[0] = m->data->weights->data[0];
+    for (int i=1; i< size; i++)
+        cdf->data[i] = m->data->weights->data[i] + cdf->data[i-1];
+    //Now make sure the last entry is one.
+    Apop_stopif(cdf->data[size-1]==0 || isnan(cdf->data[size-1]), m->error='f'; return 1,
+            0, "Bad density in the PMF.");
+    gsl_vector_scale(cdf, 1./cdf->data[size-1]);
+    Apop_stopif(!isfinite(cdf->data[size-1]), m->error='f'; return 1,
+            0, "Bad density in the PMF.");
+    return 0;
+}
+
+/* Vose's alias method: scale the weights so they average to one, then pair each
+   below-average row with an above-average row that fills out the rest of its slot. */
+static int alias_setup(apop_model *m, apop_pmf_settings *settings){
+    gsl_vector *w = m->data->weights;
+    size_t n = w->size, small_ct = 0, large_ct = 0;
+    long double total = 0;
+    for (size_t i=0; i< n; i++) total += gsl_vector_get(w, i);
+    Apop_stopif(!total || !isfinite(total), m->error='f'; return 1, 0, "Bad density in the PMF.");
+    settings->alias_probs = gsl_vector_alloc(n);
+    settings->aliases = malloc(sizeof(size_t)*n);
+    size_t *small = malloc(sizeof(size_t)*n), *large = malloc(sizeof(size_t)*n);
+    Apop_stopif(!settings->alias_probs || !settings->aliases || !small || !large, 
+            m->error='a'; free(small); free(large); return 1,
+            0, "Allocation error setting up the alias table.");
+    double *p = settings->alias_probs->data;
+    for (size_t i=0; i< n; i++){
+        p[i] = gsl_vector_get(w, i) * n / total;
+        settings->aliases[i] = i;
+        if (p[i] < 1) small[small_ct++] = i;
+        else          large[large_ct++] = i;
+    }
+    while (small_ct && large_ct){
+        size_t s = small[--small_ct], l = large[large_ct-1];
+        settings->aliases[s] = l;
+        p[l] -= 1 - p[s];
+        if (p[l] < 1){
+            large_ct--;
+            small[small_ct++] = l;
+        }
+    }
+    //Whatever is left is at one, up to rounding error.
+    while (large_ct) p[large[--large_ct]] = 1;
+    while (small_ct) p[small[--small_ct]] = 1;
+    free(small);
+    free(large);
+    return 0;
+}
+
+//Build the CMF or alias table if need be. Returns nonzero on error, with m->error set.
+static int draw_setup(apop_model *m, apop_pmf_settings *settings){
+    if (!m->data->weights) return 0;
+    if (settings->draw_method == 'a'){
+        if (settings->alias_probs && settings->alias_probs->size != m->data->weights->size)
+            alias_clear(settings); //built for a different data set.
+        if (!settings->alias_probs) return alias_setup(m, settings);
+    } else if (!settings->cmf) return cmf_setup(m, settings);
+    Apop_stopif(m->error=='f', return 1, 0, "Zero or NaN density in the PMF.");
+    return 0;
+}
+
+static size_t draw_row(gsl_rng *r, apop_model *m, apop_pmf_settings *settings, size_t maxsize){
     size_t current; 
     if (!m->data->weights) //all rows are equiprobable
         current = gsl_rng_uniform(r)* (maxsize-1);
-    else {
+    else if (settings->draw_method == 'a'){
+        size_t size = settings->alias_probs->size;
+        double draw = gsl_rng_uniform(r) * size;
+        current = GSL_MIN(draw, size-1);
+        if (draw - current >= settings->alias_probs->data[current])
+            current = settings->aliases[current];
+    } else {
         size_t size = m->data->weights->size;
-        if (!settings->cmf){
-            settings->cmf = gsl_vector_alloc(size);
-            Apop_stopif(!settings->cmf, m->error='a'; *out=GSL_NAN; return,
-                    0, "Allocation error setting up the CMF.");
-            gsl_vector *cdf = settings->cmf; //alias.
-            cdf->data[0] = m->data->weights->data[0];
-            for (int i=1; i< size; i++)
-                cdf->data[i] = m->data->weights->data[i] + cdf->data[i-1];
-            //Now make sure the last entry is one.
-            Apop_stopif(cdf->data[size-1]==0 || isnan(cdf->data[size-1]), m->error='f'; *out=GSL_NAN; return,
-                    0, "Bad density in the PMF.");
-            gsl_vector_scale(cdf, 1./cdf->data[size-1]);
-            Apop_stopif(!isfinite(cdf->data[size-1]), m->error='f'; *out=GSL_NAN; return,
-                    0, "Bad density in the PMF.");
-        }
-        Apop_stopif(m->error=='f', *out=GSL_NAN; return, 0, "Zero or NaN density in the PMF.");
         double draw = gsl_rng_uniform(r);
         //do a binary search for where draw is in the CDF.
         double *cdf = settings->cmf->data; //alias.
@@ -166,7 +322,10 @@ static void draw (double *out, gsl_rng *r, apop_model *m){
             if (current==0 && cdf[0] >= draw) break;
         }
     }
-    //Done searching. Current should now be the right row index.
+    return current;
+}
+
+static void write_draw(double *out, apop_model *m, apop_pmf_settings *settings, size_t current){
     if (settings->draw_index=='y'){
         *out = current;
         return;
@@ -180,6 +339,28 @@ static void draw (double *out, gsl_rng *r, apop_model *m){
             out[i] = gsl_matrix_get(outrow->matrix, 0, i);
 }
 
+static void draw (double *out, gsl_rng *r, apop_model *m){
+    Nullcheck_m(m, ) Nullcheck_d(m->data, )
+    apop_pmf_settings *settings = Apop_settings_get_group(m, apop_pmf);
+    if (!settings) settings = Apop_model_add_group(m, apop_pmf);
+    Get_vmsizes(m->data) //maxsize
+    Apop_stopif(draw_setup(m, settings), *out=GSL_NAN; return, 0, "Couldn't set up to make draws.");
+    write_draw(out, m, settings, draw_row(r, m, settings, maxsize));
+}
+
+/* Fill every row of out->matrix with a draw, doing the setup once. This is registered
+   in the apop_model_draws vtable, so apop_model_draws uses it for PMFs. Declared in internal.h. */
+void apop_pmf_draws(apop_data *out, gsl_rng *r, apop_model *m){
+    Nullcheck_m(m, ) Nullcheck_d(m->data, ) Nullcheck_d(out, )
+    apop_pmf_settings *settings = Apop_settings_get_group(m, apop_pmf);
+    if (!settings) settings = Apop_model_add_group(m, apop_pmf);
+    Get_vmsizes(m->data) //maxsize
+    Apop_stopif(draw_setup(m, settings), gsl_matrix_set_all(out->matrix, GSL_NAN); out->error=m->error; return,
+            0, "Couldn't set up to make draws.");
+    for (size_t i=0; i< out->matrix->size1; i++)
+        write_draw(gsl_matrix_ptr(out->matrix, i, 0), m, settings, draw_row(r, m, settings, maxsize));
+}
+
 
 static int are_equal(apop_data *left, apop_data *right){
     /* Intended by use for apop_data_pmf_compress and .p, below.
@@ -214,29 +395,90 @@ static int are_equal(apop_data *left, apop_data *right){
     return 1;
 }
 
-static int find_in_data(apop_data *searchme, apop_data *findme){//findme is one row tall.
-    Get_vmsizes(searchme)
-    for(int i=0; i < GSL_MAX(vsize, GSL_MAX(searchme->textsize[0], msize1)); i++){
-        Apop_data_row(searchme, i, onerow);
-        if (are_equal(findme, onerow))
-            return i;
+static int row_count(apop_data const *d){
+    Get_vmsizes(d) //vsize, msize1
+    return GSL_MAX(vsize, GSL_MAX(d->textsize[0], msize1));
+}
+
+//Rows that are_equal have to hash alike, which apop_hash_double takes care of for NaNs and -0.
+static unsigned long long row_hash(apop_data const *row){
+    unsigned long long h = apop_hash_start;
+    if (row->vector) h = apop_hash_double(apop_hash_bytes(h, "v", 1), row->vector->data[0]);
+    if (row->matrix){
+        h = apop_hash_bytes(h, &row->matrix->size2, sizeof(size_t));
+        for (size_t i=0; i< row->matrix->size2; i++)
+            h = apop_hash_double(h, gsl_matrix_get(row->matrix, 0, i));
     }
+    for (size_t i=0; i< row->textsize[1]; i++)
+        h = apop_hash_bytes(h, row->text[0][i], strlen(row->text[0][i])+1); //include the '\0' as a separator.
+    return h;
+}
+
+/* Look for findme in the rows of data already in the index. Returns the row number, or -1
+   if not found, in which case *slot is the empty slot where findme would go. */
+static int pmf_index_find(apop_pmf_index const *ix, apop_data *data, apop_data *findme,
+                                    unsigned long long h, size_t *slot){
+    for (*slot = h & ix->mask; ix->rows[*slot] != -1; *slot = (*slot+1) & ix->mask)
+        if (ix->hashes[*slot] == h){
+            Apop_data_row(data, ix->rows[*slot], onerow);
+            if (are_equal(findme, onerow)) return ix->rows[*slot];
+        }
     return -1;
 }
+
+static void pmf_index_add(apop_pmf_index *ix, int row, unsigned long long h, size_t slot){
+    ix->rows[slot] = row;
+    ix->hashes[slot] = h;
+}
+
+//Room for at least twice the rows, so chains stay short.
+static apop_pmf_index *pmf_index_alloc(apop_data const *d, int rowct){
+    apop_pmf_index *ix = malloc(sizeof(apop_pmf_index));
+    size_t size = 16;
+    while (size < 2*(size_t)rowct) size *= 2;
+    *ix = (apop_pmf_index){.data=d, .rowct=rowct, .mask=size-1,
+            .rows=malloc(sizeof(int)*size), .hashes=malloc(sizeof(unsigned long long)*size)};
+    Apop_stopif(!ix->rows || !ix->hashes, pmf_index_free(ix); return NULL, 0, "Allocation error building the PMF index.");
+    for (size_t i=0; i< size; i++) ix->rows[i] = -1;
+    return ix;
+}
+
+//Index every row, keeping the first of any set of duplicates, as a linear search would find.
+static apop_pmf_index *pmf_index_build(apop_data *d){
+    int rowct = row_count(d);
+    apop_pmf_index *ix = pmf_index_alloc(d, rowct);
+    Apop_stopif(!ix, return NULL, 0, "Allocation error.");
+    size_t slot;
+    for (int i=0; i< rowct; i++){
+        Apop_data_row(d, i, onerow);
+        unsigned long long h = row_hash(onerow);
+        if (pmf_index_find(ix, d, onerow, h, &slot) == -1)
+            pmf_index_add(ix, i, h, slot);
+    }
+    return ix;
+}
+
+/* The probability of each row of the input data is the weight of the first matching row
+   in the PMF's data set, over the total weight (or one over the row count if there are no
+   weights). Lookups go through the hash index, built on the first call. */
 double pmf_p(apop_data *d, apop_model *m){
-    apop_pmf_settings *settings = Apop_settings_get_group(m, apop_pmf);
     Nullcheck_d(d, GSL_NAN) 
     Nullcheck_m(m, GSL_NAN) 
-    int model_pmf_length;
-    {
-        Get_vmsizes(m->data);//maxsize
-        model_pmf_length = maxsize;
+    Nullcheck_d(m->data, GSL_NAN) 
+    apop_pmf_settings *settings = Apop_settings_get_group(m, apop_pmf);
+    if (!settings) settings = Apop_model_add_group(m, apop_pmf);
+    int model_pmf_length = row_count(m->data);
+    if (!settings->index || settings->index->data != m->data || settings->index->rowct != model_pmf_length){
+        pmf_index_free(settings->index);
+        settings->index = pmf_index_build(m->data);
+        Apop_stopif(!settings->index, m->error='a'; return GSL_NAN, 0, "Allocation error building the PMF index.");
     }
     Get_vmsizes(d)//maxsize
     long double p = 1;
+    size_t slot;
     for (int i=0; i< maxsize; i++){
         Apop_data_row(d, i, onerow);
-        int elmt = find_in_data(m->data, onerow);
+        int elmt = pmf_index_find(settings->index, m->data, onerow, row_hash(onerow), &slot);
         if (elmt == -1) return 0; //Can't find one observation: prob=0;
         p *= m->data->weights
                  ? m->data->weights->data[elmt] /settings->total_weight 
@@ -307,21 +549,22 @@ apop_data *apop_data_pmf_compress(apop_data *in){
     }
     if (maxsize==1) return in; //optional check.
     int *cutme = calloc(maxsize, sizeof(int));
-    int not_done = 1; //if we do a full j-loop and everything is to be cut, we're done.
-    for (int i=0; i< maxsize && not_done;i++){
-        if (cutme[i]) continue;
-        Apop_data_row(in, i, subject);
-        not_done = 0;
-        for (int j=i+1; j< maxsize; j++){
-            if (cutme[j]) continue;
-            not_done = 1;
-            Apop_data_row(in, j, compare_me);
-            if (are_equal(subject, compare_me)){
-                apop_vector_increment(subject->weights, 0, gsl_vector_get (compare_me->weights, 0));
-                cutme[j]=1;
-            }
+    //Each row is either the first of its kind, and goes into the index, or a duplicate
+    //whose weight goes to the first of its kind.
+    apop_pmf_index *ix = pmf_index_alloc(in, maxsize);
+    Apop_stopif(!cutme || !ix, free(cutme); pmf_index_free(ix); return in, 0, "Allocation error; returning the original data set unchanged.");
+    size_t slot;
+    for (int i=0; i< maxsize; i++){
+        Apop_data_row(in, i, compare_me);
+        unsigned long long h = row_hash(compare_me);
+        int first = pmf_index_find(ix, in, compare_me, h, &slot);
+        if (first == -1) pmf_index_add(ix, i, h, slot);
+        else {
+            apop_vector_increment(in->weights, first, gsl_vector_get(compare_me->weights, 0));
+            cutme[i]=1;
         }
     }
+    pmf_index_free(ix);
     apop_data_rm_rows(in, cutme);
     free(cutme);
     return in;
@@ -27,6 +27,28 @@ static double poisson_log_likelihood(apop_data *d, apop_model * p){
     return ll - tsize*lambda;
 }
 
+static double invalid(double x){ return x < 0 || (x - (int)x) > 1e-4; }
+static double ln_x_factorial(double x){ return x==0 ? 0 : gsl_sf_lngamma(x+1); }
+static double ident(double x){ return x; }
+
+/* The batched version, for apop_log_likelihoods. As in apply_me, an element that isn't
+ a nonnegative integer makes the log likelihood -infinity for any lambda. */
+void apop_poisson_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params, gsl_vector *out){
+    gsl_vector_set_all(out, GSL_NAN);
+    Nullcheck_d(d, );
+    Get_vmsizes(d) //tsize
+    if (apop_map_sum(d, .fn_d = invalid)){
+        gsl_vector_set_all(out, -INFINITY);
+        return;
+    }
+    double sum = apop_map_sum(d, .fn_d = ident),
+           sum_ln_fact = apop_map_sum(d, .fn_d = ln_x_factorial);
+    for (size_t i=0; i< params->size1; i++){
+        double lambda = gsl_matrix_get(params, i, 0);
+        gsl_vector_set(out, i, (sum ? log(lambda)*sum : 0) - sum_ln_fact - tsize*lambda);
+    }
+}
+
 static double data_mean(apop_data *d){
     Get_vmsizes(d)
     if (vsize && !msize1) return apop_vector_mean(d->vector);
@@ -5,6 +5,10 @@ Copyright (c) 2005--2008, 2010 by Ben Klemens.  Licensed under the modified GNU
 
   Apophenia makes no distinction between the bivariate probit and the multinomial probit. This one does both.
 
+  The log likelihood and score make one pass over the data, finding \f$x\beta_j\f$
+  for all options at each row. Given <tt>apop_opts.thread_count > 1</tt>, the rows are
+  split among threads; the result is the same at any thread count.
+
 \adoc    Input_format  
 The first column of the data matrix this model expects is zeros, ones, ..., enumerating
 the factors; to get there, try \ref apop_data_to_factors; if you  forget to run it,
@@ -47,88 +51,100 @@ static void probit_prep(apop_data *d, apop_model *m){
     for (int i=1; i< count; i++) 
         apop_name_add(m->parameters->names, factor_list->text[i][0], 'c');
     gsl_matrix_set_all(m->parameters->matrix, 1);
-    //haven't yet implemented the score for probit && $N>2$
-    if (!strcmp(m->name, apop_probit.name) && count > 2) m->score = NULL;
     char *tmp = strdup(m->name);
     snprintf(m->name, 100, "%s with %s as numeraire", tmp, factor_list->text[0][0]);
     free(tmp);
 }
 
-double biprobit_ll_row(apop_data *r){
-    long double n = gsl_cdf_gaussian_P(-gsl_matrix_get(r->matrix, 0, 0),1);
-    n = n ? n : 1e-10; //prevent -inf in the next step.
-    n = n<1 ? n : 1-1e-10; 
-    return r->vector->data[0] ?  log(1-n): log(n);
+/* The probit and logit likelihoods and scores all find x beta_j for every row and
+ every column j of the parameter matrix, and accumulate a function of each row. So they
+ share one engine, apop_dot_map_sum, which multiplies a tile of rows at a time and splits
+ the tiles among threads (given apop_opts.thread_count > 1), summing fixed-size chunks'
+ log likelihoods and scores in order. There's no static state, so many models can be
+ evaluated at once. */
+typedef struct {
+    apop_data *d;
+    gsl_matrix *beta;
+    double *cats;
+    size_t cat_ct;
+    char model;         //'p'=probit, 'l'=logit
+} choicepass;
+
+/* A probit is a set of binary probits, one per column of the parameter matrix. With two
+ categories, the outcome is whether the data is nonzero; with more, column j's outcome
+ is whether the data matches category j. */
+static double probit_row(double outcome, double const *xb, gsl_vector const *x,
+                                                   choicepass const *cp, double *grad){
+    long double ll = 0;
+    size_t cols = cp->beta->size2;
+    for (size_t j=0; j< cols; j++){
+        int y = cp->cat_ct == 2 ? outcome != 0 : outcome == cp->cats[j];
+        long double n = gsl_cdf_gaussian_P(-xb[j], 1);
+        n = n ? n : 1e-10; //prevent -inf in the next step.
+        n = n<1 ? n : 1-1e-10; 
+        ll += y ? logl(1-n): logl(n);
+        if (!grad) continue;
+        double deriv_base = y ?  gsl_ran_gaussian_pdf(-xb[j], 1) /(1-n)
+                              : -gsl_ran_gaussian_pdf(-xb[j], 1) / n;
+        for (size_t k=0; k< x->size; k++)
+            grad[k*cols + j] += gsl_vector_get(x, k) * deriv_base;
+    }
+    return ll;
+}
+
+static size_t find_index(double in, double *m, size_t max){
+    size_t i = 0;
+    while (in !=m[i] && i<max) i++;
+    return i;
+}
+
+/* The log likelihood is x beta_choice - ln(sum_j e^{x beta_j}), with beta_0 fixed at zero
+ for the numeraire. The sum uses the subtract-the-max trick described in the
+ documentation. The score for beta_j is x (1{choice=j} - p_j). */
+static double logit_row(double outcome, double const *xb, gsl_vector const *x,
+                                                   choicepass const *cp, double *grad){
+    size_t cols = cp->beta->size2;
+    size_t index = find_index(outcome, cp->cats, cols);
+    double max = 0; //the numeraire's x beta
+    for (size_t j=0; j< cols; j++) max = GSL_MAX(max, xb[j]);
+    long double total = expl(-max);
+    for (size_t j=0; j< cols; j++) total += expl(xb[j] - max);
+    if (grad)
+        for (size_t j=0; j< cols; j++){
+            double resid = (index == j+1) - expl(xb[j] - max)/total;
+            for (size_t k=0; k< x->size; k++)
+                grad[k*cols + j] += gsl_vector_get(x, k) * resid;
+        }
+    return (index ? xb[index-1] : 0) - (max + logl(total));
 }
 
-//The case where outcome is a single zero/one option.
-static double biprobit_log_likelihood(apop_data *d, apop_model *p){
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    betadotx->vector = d->vector;
-    double total_prob = apop_map_sum(betadotx, .fn_r=biprobit_ll_row);
-    betadotx->vector = NULL;
-    apop_data_free(betadotx);
-	return total_prob;
+static double choice_row(double const *xb, size_t i, void *ctx, double *grad){
+    choicepass *cp = ctx;
+    Apop_matrix_row(cp->d->matrix, i, x);
+    double outcome = gsl_vector_get(cp->d->vector, i);
+    return (cp->model == 'p' ? probit_row : logit_row)(outcome, xb, x, cp, grad);
 }
 
-static double val;
-static double unordered(double in){ return in == val; }
+/* Returns the log likelihood and, if gradient is not NULL, fills it with the score. */
+static double choice_ll(apop_data *d, apop_model *m, apop_data *cats, char model, gsl_vector *gradient){
+    Apop_stopif(!d->vector || !d->matrix, return GSL_NAN, 0, "I expect the outcome in "
+            "the data's vector and the independent variables in its matrix. Did the prep routine run?");
+    choicepass cp = {.d=d, .beta=m->parameters->matrix, .cats=cats->vector->data,
+                     .cat_ct=cats->vector->size, .model=model};
+    return apop_dot_map_sum(d->matrix, cp.beta, choice_row, &cp, gradient);
+}
 
-// This is just a for loop that runs a probit on each column.
-static double multiprobit_log_likelihood(apop_data *d, apop_model *p){
+static double probit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
-    gsl_vector *val_vector = get_category_table(d)->vector;
-    if (val_vector->size==2) return biprobit_log_likelihood(d, p);
-    //else, multinomial loop
-    static apop_model *spare_probit = NULL;
-    if (!spare_probit){
-        spare_probit = apop_model_copy(apop_probit);
-        spare_probit->parameters = apop_data_alloc();
-    }
-    Staticdef(apop_data *, working_data, apop_data_alloc());
-    working_data->matrix = d->matrix;
-    gsl_vector *original_outcome = d->vector;
-    double ll = 0;
-    double *vals = val_vector->data;
-    for(size_t i=0; i < p->parameters->matrix->size2; i++){
-        Apop_col(p->parameters, i, param);
-        val = vals[i];
-        working_data->vector = apop_vector_map(original_outcome, unordered);
-        spare_probit->parameters->matrix = apop_vector_to_matrix(param);
-        ll  += apop_log_likelihood(working_data, spare_probit);
-        gsl_vector_free(working_data->vector); //yup. It's inefficient.
-        gsl_matrix_free(spare_probit->parameters->matrix);
-    }
-	return ll;
+    return choice_ll(d, p, get_category_table(d), 'p', NULL);
 }
 
 static void probit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mp(p, )
-    gsl_vector *val_vector = get_category_table(p->data)->vector;
-    if (val_vector->size!=2){
-        gsl_vector * numeric_default = apop_numerical_gradient(d, p);
-        gsl_vector_memcpy(gradient, numeric_default);
-        gsl_vector_free(numeric_default);
-    }
-    long double	cdf, betax, deriv_base;
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    gsl_vector_set_all(gradient,0);
-    for (size_t i=0; i< d->matrix->size1; i++){
-        betax = apop_data_get(betadotx, i, 0);
-        cdf   = gsl_cdf_gaussian_P(-betax, 1);
-        cdf = cdf ? cdf : 1e-10; //prevent -inf in the next step.
-        cdf = cdf<1 ? cdf : 1-1e-10; 
-        if (apop_data_get(d, i, -1))
-            deriv_base      = gsl_ran_gaussian_pdf(-betax, 1) /(1-cdf);
-        else
-            deriv_base      = -gsl_ran_gaussian_pdf(-betax, 1) / cdf;
-        for (size_t j=0; j< d->matrix->size2; j++)
-            apop_vector_increment(gradient, j, apop_data_get(d, i, j) * deriv_base);
-	}
-	apop_data_free(betadotx);
+    Nullcheck_mpd(d, p, )
+    choice_ll(d, p, get_category_table(d), 'p', gradient);
 }
 
-apop_model apop_probit = {"Probit", .log_likelihood = multiprobit_log_likelihood, .dsize=-1,
+apop_model apop_probit = {"Probit", .log_likelihood = probit_log_likelihood, .dsize=-1,
     .score = probit_dlog_likelihood, .prep = probit_prep};
 
 
@@ -200,93 +216,16 @@ static apop_data *multilogit_expected(apop_data *in, apop_model *m){
     return out;
 }
 
-static size_t find_index(double in, double *m, size_t max){
-    size_t i = 0;
-    while (in !=m[i] && i<max) i++;
-    return i;
-}
-
-double one_logit_row(apop_data *thisobservation, void *factor_list){
-    //get the $x\beta_j$ numerator for the appropriate choice:
-    size_t index   = find_index(gsl_vector_get(thisobservation->vector, 0), 
-                                factor_list, thisobservation->matrix->size2);
-    Apop_row(thisobservation, 0, thisrow);
-    double num = (index==0) ? 0 : gsl_vector_get(thisrow, index-1);
-
-    /* Get the denominator, ln(sum(exp(xbeta))) using the subtract-the-max trick 
-     mentioned in the documentation.  Don't forget the implicit beta_0, fixed at 
-     zero (so we need to add exp(0-max)). */
-
-    double max = gsl_vector_max(thisrow);
-    gsl_vector_add_constant(thisrow, -max);
-    apop_vector_exp(thisrow);
-    //return num - (max + log(apop_vector_sum(thisrow) +exp(-max)));
-    long double expmax = expl(-max);
-    return num - (max + (isfinite(expmax)? logl(apop_vector_sum(thisrow) +  expmax) : -max) );
-}
-
 static double multilogit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
     Nullcheck(d->matrix, GSL_NAN)
-    //Find X\beta_i for each row of X and each column of \beta.
-    apop_data  *xbeta = apop_dot(d, p->parameters);
-    double* factor_list = get_category_table(p->data)->vector->data;
-    xbeta->vector = d->vector; //we'll need this in one_logit_row
-    long double ll = apop_map_sum(xbeta, .fn_rp = one_logit_row, .param=factor_list);
-    xbeta->vector = NULL;
-    apop_data_free(xbeta);
-	return ll;
-}
-
-/*
-static void dlogit_foreach(apop_data *x, apop_data *gmat, gsl_matrix *beta, apop_data *factor_list){
-  //\beta_this = choice for the row.
-  //dLL/d\beta_ij = [(\beta_i==\beta_this) ? x_j : 0] - x_i e^(x\beta_j)/\sum_k e^(x\beta_k)
-  //that last term simplifies: x / \sum_k e^(x(\beta_k - \beta_i))
-    Apop_row(x, 0, xdata);
-    assert(gmat->matrix->size1 == x->matrix->size2);     //the j index---input vars (incl. 1 column)
-    assert(gmat->matrix->size2 == beta->size2); //the i index---choices
-    assert(xdata->size == beta->size1);//cols of data=variables; rows of output=var.s (cols=choices)
-    size_t choice = find_index(gsl_vector_get(x->vector, 0), factor_list->vector->data, factor_list->vector->size);
-    for (int i=0; i < beta->size2; i++) { //go through choices.
-        gsl_vector *denom = gsl_vector_alloc(beta->size1);
-        gsl_vector_set_all(denom, 1); //see below
-        for (int other=-1; other < (int)beta->size2; other++){
-            if (other != i) { //this block calculates exp(x (otherbeta-thisbeta))
-                Apop_matrix_col(beta, i, thisbeta); 
-                gsl_vector *diff = apop_vector_copy(thisbeta);
-                gsl_vector_scale(diff, -1);
-                if (other >=0){//the phantom beta_0 == 0, so that term is e^x(0-beta|i)
-                    Apop_matrix_col(beta, other, otherbeta);
-                    gsl_vector_add(diff, otherbeta);
-                }
-                gsl_vector_mul(diff, xdata);
-                apop_vector_exp(diff);
-                gsl_vector_add(denom, diff);
-                gsl_vector_free(diff);
-            } //else, other==i, and \beta_i - \beta_i = 0, and e^{0x} = 1. Thus the gsl_vector_set_all(denom, 1).
-        }
-        for (int j=0; j< xdata->size; j++){ //add to each coefficient of the gradient matrix 
-            double pick = (choice-1 == i) ? gsl_vector_get(xdata,j) : 0; //numeraire has no betas.
-            apop_matrix_increment(gmat->matrix, j, i, 
-                                            pick - gsl_vector_get(xdata, j)/gsl_vector_get(denom, j));
-        }
-        gsl_vector_free(denom);
-    }
+    return choice_ll(d, p, get_category_table(p->data), 'l', NULL);
 }
 
 static void logit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mpd(d, p, );
-    apop_data *gradient_matrix = apop_data_calloc(p->parameters->matrix->size1, p->parameters->matrix->size2);
-    apop_data *cats = get_category_table(d);
-    for (int i=0; i< d->matrix->size1; i++){
-        Apop_data_row(d, i, onerow);
-        dlogit_foreach(onerow, gradient_matrix, p->parameters->matrix, cats);
-    }
-    apop_data_pack(gradient_matrix, gradient);
-    apop_data_free(gradient_matrix);
+    Nullcheck_mpd(d, p, )
+    choice_ll(d, p, get_category_table(p->data), 'l', gradient);
 }
-*/
 
 //Should this be available everywhere?
 static size_t get_draw_size(apop_model *in){
@@ -333,6 +272,10 @@ static void logit_rng(double *out, gsl_rng *r, apop_model *m){
 
 Apophenia makes no distinction between the bivariate logit and the multinomial logit. This does both.
 
+As with the \ref apop_probit, the log likelihood and score (\f$x(1_{choice=j} - p_j)\f$
+for the parameters of option \f$j\f$) make one pass over the data, split among threads
+given <tt>apop_opts.thread_count > 1</tt>.
+
   The likelihood of choosing item \f$j\f$ is:
   \f$e^{x\beta_j}/ (\sum_i{e^{x\beta_i}})\f$
 
@@ -374,5 +317,5 @@ Here is an artifical example:
 \include fake_logit.c
 */
 apop_model apop_logit = {.name="Logit", .log_likelihood = multilogit_log_likelihood, .dsize=-1,
-/*.score = logit_dlog_likelihood,*/ .predict=multilogit_expected, .prep = logit_prep, .draw=logit_rng
+.score = logit_dlog_likelihood, .predict=multilogit_expected, .prep = logit_prep, .draw=logit_rng
 };
@@ -204,6 +204,31 @@ delta;
                              through the dimensions is within this amount of the previous cycle's log likelihood. There
                              will be at least two cycles.
                              */
+    char        deriv_method; /**< How should I take numerical derivatives (for the gradient
+                             of models without a \c score, and for the Hessian behind the covariance)?
+                             'c' (the default): GSL's central-difference stencil, four evaluations per dimension.
+                             'f': one-sided forward difference, \f$(f(x+\delta)-f(x))/\delta\f$, one evaluation
+                             per dimension plus one shared; cheaper but less precise. */
+    char        threaded_derivs; /**< If 'y', split numerical gradients and Hessians by
+                             dimension across <tt>apop_opts.thread_count</tt> threads, each with its
+                             own copy of the model. Your model's \c log_likelihood, \c p, \c score, and
+                             \c constraint have to be thread-safe. Models built on other models (via
+                             \ref apop_model_fix_params, \c apop_model_mixture, \c apop_model_stack, ...)
+                             share those sub-models among copies, and are not. Default: 'n'. */
+    int         start_count; /**< If greater than one, run this many searches from different
+                             starting points and keep the one with the highest log likelihood.
+                             The first search starts at \c starting_pt; see \c start_model
+                             and \c start_spread for the others. Searches run concurrently on
+                             <tt>apop_opts.thread_count</tt> threads (except for simulated annealing
+                             and traced searches, which run one at a time), with the same
+                             thread-safety caveats as \c threaded_derivs. The output model's
+                             \c info element gets a <tt>\<Multistart\></tt> page listing each
+                             search's final log likelihood and status. Default: 1. */
+    apop_model  *start_model; /**< If not \c NULL, draw the extra starting points from this
+                             (parameterized) model. Each draw has to fill the full parameter set. */
+    double      start_spread; /**< If there is no \c start_model, the extra starting points are
+                             the first starting point plus independent Normal noise with this
+                             standard deviation. Default: 1. */
 //simulated annealing (also uses step_size);
     int         n_tries, iters_fixed_T;
     double      k, t_initial, mu_t, t_min ;
@@ -221,6 +246,20 @@ typedef struct {
     char want_cov; /**< Deprecated. Please use \ref apop_parts_wanted_settings. */
     char want_expected_value; /**< Deprecated. Please use \ref apop_parts_wanted_settings. */
     apop_model *input_distribution; /**< The distribution of \f$P(Y|X)\f$ is specified by the model, but the distribution of \f$X\f$ is not.  */
+    apop_data *(*chunk_fn)(void *chunk_info); /**< If not \c NULL, \ref apop_ols reads its data in blocks from this function,
+                                 rather than from the data set handed to \ref apop_estimate. See \ref apop_ols for details. */
+    void *chunk_info; /**< Passed to \c chunk_fn on every call. */
+    char *query; /**< If not \c NULL, \ref apop_ols reads its data in blocks from this query. Query blocks carry no weights; for WLS, use \c chunk_fn. See \ref apop_ols for details. */
+    size_t chunk_rows; /**< When reading from a \c query, the number of rows in each block. Default: 100,000. */
+    char solver; /**< How \ref apop_ols solves for the parameters.
+                    'c' (the default): via the Cholesky factorization of \f$X'X\f$.
+                    'q': via the QR factorization of \f$X\f$, which is slower but more accurate when columns are nearly collinear.
+                    'i': via the explicit inverse of \f$X'X\f$, as in earlier versions of Apophenia.
+                    The factorization is kept in the estimated model; see \ref apop_lm_solve. */
+    gsl_matrix *factor; /**< For internal use: the cached Cholesky factor of \f$X'X\f$, or QR factorization of \f$X\f$. */
+    gsl_vector *tau;    /**< For internal use: the Householder coefficients of a QR factorization. */
+    gsl_matrix *factored; /**< For internal use: the \f$X'X\f$ that \c factor was built from, for checking whether the data has changed. */
+    char factored_by;   /**< For internal use: the solver that built \c factor. */
 } apop_lm_settings;
 
 /** The default is for the estimation routine to give some auxiliary information,
@@ -286,8 +325,24 @@ typedef struct {
                            If \c 'n' (the default), then return the data in the vector/matrix elements of the data set. */
     long double total_weight; /**< Keep the total weight, in case the input weights aren't normalized to sum to one. */
     int cmf_refct;    /**< For internal use, so I can garbage-collect the CMF when needed. */
+    struct apop_pmf_index *index; /**< For internal use: a hash index of the rows of the data, built on the first call to \c p. */
+    char draw_method; /**< If \c 'c' (the default), draws are via a binary search of the CMF.
+                           If \c 'a', draws are via an alias table, which takes constant time per draw. */
+    gsl_vector *alias_probs; /**< For internal use: the alias table's cutoffs, built on the first draw if <tt>draw_method=='a'</tt>. */
+    size_t *aliases;  /**< For internal use: the alias table's alternate rows. */
 } apop_pmf_settings;
 
+/** Settings for the \ref apop_multivariate_normal model. All of the elements of this
+ struct are caches built on the first log likelihood or draw, and rebuilt whenever the
+ covariance in the model's parameters changes; you never need to set them.
+
+  \ingroup settings */
+typedef struct {
+    gsl_matrix *cholesky; /**< The lower-triangular Cholesky factor of the covariance. */
+    gsl_matrix *factored; /**< A copy of the covariance that \c cholesky was built from, for checking whether the parameters have changed. */
+    double log_det; /**< The log of the determinant of the covariance. */
+} apop_mvn_settings;
+
 
 /** Settings for the \ref apop_kernel_density model. 
 
@@ -300,7 +355,16 @@ typedef struct{
                                     \ref apop_normal with std dev 1. */
     void (*set_fn)(apop_data*, apop_model*); /**< The function I will use for each data
                                                   point to center the kernel over each point.*/
+    char method; /**< \c 'e' (the default): sum the kernel over every point of the base PMF.
+                      \c 'f': for the default Normal kernel over one-dimensional data, sort the
+                      base points once and sum only over those within \c cutoff standard
+                      deviations of the evaluation point. See \ref apop_kernel_density. */
+    double cutoff; /**< In fast mode, the half-width of the window, in kernel standard deviations. Default: 8. */
     int own_pmf, own_kernel; /**< For internal use only. */
+    size_t *sorted_rows; /**< For internal use: the base PMF's rows in order of value, built when the group is set up or the model estimated. */
+    double *sorted_vals, *cum_wts; /**< For internal use: the sorted values, and the weight of all rows before each. */
+    apop_data *sorted_from; /**< For internal use: the base data the sorted values came from. */
+    size_t sorted_ct; /**< For internal use: the number of sorted values. */
 }apop_kernel_density_settings;
 
 
@@ -314,7 +378,10 @@ typedef struct{
     double burnin; /**< What <em>percentage</em> of the periods should be ignored
                          as initialization. That is, this is a number between zero and one. */
     int histosegments; /**< If outputting a binned PMF, how many segments should it have? */
-    char method;
+    char method; /**< 'd' (the default): draw every proposal from the prior (an independence sampler).
+                      'r': adaptive random-walk Metropolis. See \ref apop_update. */
+    int chain_count; /**< How many chains should I run? Each runs for \c periods steps,
+                          and the output pools them all. Default: 1. */
 } apop_update_settings;
 
 //Loess, including the old FORTRAN-to-C.
@@ -524,6 +591,7 @@ Apop_settings_declarations(apop_ct)
 Apop_settings_declarations(apop_lm)
 Apop_settings_declarations(apop_pm)
 Apop_settings_declarations(apop_pmf)
+Apop_settings_declarations(apop_mvn)
 Apop_settings_declarations(apop_mle)
 Apop_settings_declarations(apop_cdf)
 Apop_settings_declarations(apop_arms)
@@ -142,7 +142,7 @@ apop_data * apop_data_correlation(const apop_data *in);
 long double apop_matrix_sum(const gsl_matrix *m);
 double apop_matrix_mean(const gsl_matrix *data);
 void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var);
-apop_data * apop_data_summarize(apop_data *data);
+Apop_var_declare( apop_data * apop_data_summarize(apop_data *indata, char approx) )
 
 apop_data *apop_test_fisher_exact(apop_data *intab); //in apop_fisher.c
 
@@ -165,6 +165,8 @@ Apop_var_declare( apop_data * apop_f_test (apop_model *est, apop_data *contrast)
 
 apop_data * apop_text_unique_elements(const apop_data *d, size_t col);
 gsl_vector * apop_vector_unique_elements(const gsl_vector *v);
+apop_data * apop_text_unique_codes(const apop_data *d, size_t col, gsl_vector *codes);
+gsl_vector * apop_vector_unique_codes(const gsl_vector *v, gsl_vector *codes);
 Apop_var_declare( apop_data * apop_data_to_factors(apop_data *data, char intype, int incol, int outcol) )
 Apop_var_declare( apop_data * apop_data_get_factor_names(apop_data *data, int col, char type) )
 
@@ -177,8 +179,8 @@ void apop_estimate_parameter_tests (apop_model *est);
 
 
 //Bootstrapping & RNG
-apop_data * apop_jackknife_cov(apop_data *data, apop_model model);
-Apop_var_declare( apop_data * apop_bootstrap_cov(apop_data *data, apop_model model, gsl_rng* rng, int iterations, char keep_boots, char ignore_nans) )
+Apop_var_declare( apop_data * apop_jackknife_cov(apop_data *in, apop_model model, char threaded) )
+Apop_var_declare( apop_data * apop_bootstrap_cov(apop_data *data, apop_model model, gsl_rng* rng, int iterations, char keep_boots, char ignore_nans, char threaded) )
 gsl_rng *apop_rng_alloc(int seed);
 double apop_rng_GHgB3(gsl_rng * r, double* a); //in apop_asst.c
 
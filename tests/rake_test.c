@@ -55,6 +55,51 @@ void test_raking_further(){
 }
 
 
+//Threaded rounds give the same weights as unthreaded ones, and the info page has one row per round.
+void test_raking_threads(){
+    int threads = apop_opts.thread_count;
+    apop_data *out[2];
+    for (int i=0; i< 2; i++){
+        apop_opts.thread_count = i ? 4 : 1;
+        out[i] = apop_rake("inequals", .var_list=(char*[]){"a", "b", "c"}, .var_ct=3,
+                    .contrasts=(char*[]){"a|b", "b|c", "a|c"}, .contrast_ct=3, .count_col="weights", .tolerance=1e-8);
+    }
+    apop_opts.thread_count = threads;
+    assert(!out[0]->error && !out[1]->error);
+    for (int i=0; i< out[0]->weights->size; i++)
+        assert(gsl_vector_get(out[0]->weights, i) == gsl_vector_get(out[1]->weights, i));
+    apop_data *info = apop_data_get_page(out[1], "<Info>", .match='e');
+    assert(info && info->matrix->size1 > 1 && info->matrix->size1 < 1000);
+    assert(apop_data_get(info, .row=info->matrix->size1-1, .colname="max deviation") < 1e-8);
+    apop_data_free(out[0]);
+    apop_data_free(out[1]);
+}
+
+//The in-memory version matches the database version.
+void test_rake_data(){
+    apop_data *margins = apop_query_to_mixed_data("mmmw", "select a, b, c, weights from inequals");
+    apop_data *init = apop_query_to_mixed_data("mmm", "select distinct a, b, c from inequals");
+    char *contrasts[] = {"a|b", "c"};
+    apop_data *mem = apop_rake_data(margins, init, .contrasts=contrasts, .contrast_ct=2, .tolerance=1e-8);
+    assert(!mem->error && !init->weights);
+    apop_data_print(mem, .output_file="raked_mem", .output_type='d');
+    apop_data *sql = apop_rake("inequals", .var_list=(char*[]){"a", "b", "c"}, .var_ct=3,
+                .contrasts=contrasts, .contrast_ct=2, .count_col="weights", .tolerance=1e-8);
+    apop_data_print(sql, .output_file="raked_sql", .output_type='d');
+    assert(apop_query_to_float("select count(*) from raked_mem m, raked_sql s "
+                "where m.a=s.a and m.b=s.b and m.c=s.c") == 120);
+    Diff(apop_query_to_float("select max(abs(m.weights - s.weights)) from raked_mem m, raked_sql s "
+                "where m.a=s.a and m.b=s.b and m.c=s.c"), 0, 1e-6);
+
+    apop_data *bad = apop_rake_data(margins, init, .contrasts=(char*[]){"a|d"}, .contrast_ct=1);
+    assert(bad->error == 'i');
+    apop_data_free(bad);
+    apop_data_free(mem);
+    apop_data_free(sql);
+    apop_data_free(init);
+    apop_data_free(margins);
+}
+
 /* Some OK tests on the raking procedure. We assert that a regression on the raw data 
 and a set of dummies is equivalent to a regression on the base data. */
 
@@ -118,5 +163,8 @@ int main(){
 
     apop_map(ols_out->parameters, .fn_rpi=compare_results, .param= raked_ols->parameters);
 
+    test_raking_threads();
+    test_rake_data();
+
     test_raking_further();
 }
@@ -270,6 +270,65 @@ void test_skew_and_kurt(gsl_rng *r){
     gsl_vector_free(v);
 }
 
+//The fraction of the sorted vector that is below x.
+static double empirical_cdf(gsl_vector const *sorted, double x){
+    size_t below = 0;
+    while (below < sorted->size && gsl_vector_get(sorted, below) < x) below++;
+    return below/(double)sorted->size;
+}
+
+//Sketches built from batches and merged, and the database-side approx_percentile(), should put
+//each percentile within a small distance (in rank) of the exact one.
+void test_quantile_sketch(gsl_rng *r){
+    int n = 40000, batches = 4;
+    gsl_vector *all = gsl_vector_alloc(n);
+    apop_quantile_sketch *whole = apop_quantile_sketch_alloc();
+    apop_quantile_sketch *parts[batches];
+    for (int b=0; b< batches; b++){
+        parts[b] = apop_quantile_sketch_alloc(.compression=100);
+        gsl_vector_view batchv = gsl_vector_subvector(all, b*n/batches, n/batches);
+        gsl_vector *batch = &batchv.vector;
+        for (size_t i=0; i< batch->size; i++)
+            gsl_vector_set(batch, i, b%2 ? gsl_ran_gaussian(r, 1) : gsl_ran_exponential(r, 2));
+        apop_quantile_sketch_add_vector(parts[b], batch, NULL);
+        apop_quantile_sketch_add_vector(whole, batch, NULL);
+        apop_quantile_sketch_add(parts[b], GSL_NAN); //ignored.
+    }
+    for (int b=1; b< batches; b++) apop_quantile_sketch_merge(parts[0], parts[b]);
+    gsl_vector *sorted = apop_vector_copy(all);
+    gsl_sort_vector(sorted);
+    double *exact = apop_vector_percentiles(all, 'a');
+    double *pw = apop_quantile_sketch_percentiles(whole), *pm = apop_quantile_sketch_percentiles(parts[0]);
+    assert(pw[0] == exact[0] && pm[0] == exact[0]);
+    assert(pw[100] == exact[100] && pm[100] == exact[100]);
+    for (int i=1; i< 100; i++){
+        Diff(empirical_cdf(sorted, pw[i]), i/100., 0.005);
+        Diff(empirical_cdf(sorted, pm[i]), i/100., 0.008);
+    }
+
+    apop_table_exists(.remove=1, .name="sketched");
+    apop_query("create table sketched(grp, x)");
+    apop_query("begin");
+    for (int i=0; i< n; i+=4)
+        apop_query("insert into sketched values(%i, %.17g)", i%3, gsl_vector_get(all, i));
+    apop_query("insert into sketched values(1, NULL)");
+    apop_query("commit");
+    gsl_vector *v = apop_query_to_vector("select x from sketched where x is not null");
+    gsl_sort_vector(v);
+    Diff(empirical_cdf(v, apop_query_to_float("select approx_median(x) from sketched")), 0.5, 0.01);
+    Diff(empirical_cdf(v, apop_query_to_float("select approx_percentile(x, 95) from sketched")), 0.95, 0.005);
+    assert(apop_query_to_float("select approx_percentile(x, 100) from sketched") == gsl_vector_get(v, v->size-1));
+    apop_data *by_group = apop_query_to_data("select grp, approx_median(x) from sketched group by grp");
+    assert(by_group->matrix->size1 == 3);
+    apop_table_exists(.remove=1, .name="sketched");
+
+    apop_data_free(by_group);
+    gsl_vector_free(v); gsl_vector_free(sorted); gsl_vector_free(all);
+    free(exact); free(pw); free(pm);
+    apop_quantile_sketch_free(whole);
+    for (int b=0; b< batches; b++) apop_quantile_sketch_free(parts[b]);
+}
+
 void test_listwise_delete(){
   apop_data *t1 = apop_data_calloc(10,10);
   apop_text_alloc(t1, 10, 10);
@@ -629,6 +688,79 @@ void test_summarize(){
     apop_data_free(s);
 }
 
+//The selection-based summary should match the sort-based percentiles and the usual
+//moments exactly, with odd and even row counts, many ties, weights, and threads.
+void test_summarize_selection(gsl_rng *r){
+    int threads = apop_opts.thread_count;
+    for (int n=1; n< 2000; n = n*3 + 1){
+        apop_data *d = apop_data_alloc(n, 7);
+        for (int i=0; i< n; i++)
+            for (int j=0; j< 7; j++)
+                apop_data_set(d, i, j, j%2 ? gsl_rng_uniform(r)*10 - 5 : (int)(gsl_rng_uniform(r)*(j+1)));
+        for (int weighted=0; weighted< 2 && n > 1; weighted++){
+            if (weighted){
+                d->weights = gsl_vector_alloc(n);
+                for (int i=0; i< n; i++) gsl_vector_set(d->weights, i, gsl_rng_uniform(r)*3);
+            }
+            for (int t=1; t<= 4; t+=3){
+                apop_opts.thread_count = t;
+                apop_data *s = apop_data_summarize(d);
+                for (int j=0; j< 7; j++){
+                    Apop_col(d, j, v);
+                    double *pctiles = apop_vector_percentiles(v);
+                    double mean = weighted ? apop_vector_weighted_mean(v, d->weights) : apop_vector_mean(v);
+                    double var = weighted ? apop_vector_weighted_var(v, d->weights) : apop_vector_var_m(v, mean);
+                    if (weighted){ //summed in long double throughout, so may differ in the last bits.
+                        Diff(apop_data_get(s, j, 0), mean, 1e-12*(1+fabs(mean)));
+                        Diff(apop_data_get(s, j, 2), var, 1e-12*(1+fabs(var)));
+                    } else {
+                        assert(apop_data_get(s, j, 0) == mean);
+                        assert(apop_data_get(s, j, 2) == var);
+                    }
+                    assert(apop_data_get(s, j, 3) == pctiles[0]);
+                    assert(apop_data_get(s, j, 4) == pctiles[50]);
+                    assert(apop_data_get(s, j, 5) == pctiles[100]);
+                    free(pctiles);
+                }
+                apop_data_free(s);
+            }
+        }
+        apop_data_free(d);
+    }
+    apop_opts.thread_count = threads;
+
+    //approximate median: close in rank; the rest matches up to rounding.
+    int n = 20000;
+    apop_data *d = apop_data_alloc(n, 2);
+    for (int i=0; i< n; i++){
+        apop_data_set(d, i, 0, gsl_rng_uniform(r)*10 - 5);
+        apop_data_set(d, i, 1, gsl_ran_gaussian(r, 3));
+    }
+    apop_data_set(d, 7, 1, GSL_NAN);
+    apop_data *exact = apop_data_summarize(d);
+    apop_data *approx = apop_data_summarize(d, .approx='y');
+    for (int j=0; j< 2; j++){
+        for (int k=0; k< 6; k++){
+            double e = apop_data_get(exact, j, k), a = apop_data_get(approx, j, k);
+            if (k==4){
+                Apop_col(d, j, v);
+                int below = 0;
+                for (int i=0; i< n; i++) below += gsl_vector_get(v, i) < a;
+                Diff(below/(double)n, 0.5, 0.005);
+            } else if (gsl_isnan(e)) assert(gsl_isnan(a));
+            else Diff(a, e, 1e-10*(1+fabs(e)));
+        }
+    }
+    apop_data_free(exact);
+    apop_data_free(approx);
+
+    int verbose = apop_opts.verbose; apop_opts.verbose = -1;
+    d->weights = gsl_vector_alloc(n-1);
+    assert(!apop_data_summarize(d));
+    apop_opts.verbose = verbose;
+    apop_data_free(d);
+}
+
 void test_dot(){
 apop_data *d1   = apop_text_to_data(.text_file="test_data2",0,1); // 55 x 2
 apop_data *d2   = apop_text_to_data("test_data2"); // 55 x 2
@@ -812,6 +944,49 @@ static apop_model * super_broken_est(apop_data *d, apop_model *m){
     return apop_normal.estimate(d, m);
 }
 
+//The blocked covariance should match the column-pair-at-a-time version, with no
+//weights, with weights summing to more than one, and with weights summing to one.
+void test_blocked_covariance(gsl_rng *r){
+    int n = 400, p = 150; //three blocks of columns
+    apop_data *d = apop_data_alloc(n, p);
+    for (int i=0; i< n; i++)
+        for (int j=0; j< p; j++)
+            apop_data_set(d, i, j, gsl_rng_uniform(r)*(j%7+1) + (j%3 ? 0 : apop_data_get(d, i, 0)));
+    int threads = apop_opts.thread_count;
+    for (int weighted=0; weighted< 3; weighted++){
+        if (weighted){
+            if (!d->weights) d->weights = gsl_vector_alloc(n);
+            for (int i=0; i< n; i++) gsl_vector_set(d->weights, i, 0.2 + gsl_rng_uniform(r));
+            if (weighted==2) apop_vector_normalize(d->weights);
+        }
+        apop_data *serial_cov = NULL;
+        for (int t=1; t<= 4; t+=3){
+            apop_opts.thread_count = t;
+            apop_data *cov = apop_data_covariance(d);
+            apop_data *cor = apop_data_correlation(d);
+            if (!serial_cov) serial_cov = apop_data_copy(cov);
+            else for (int i=0; i< p*p; i++) //same sums at any thread count
+                assert(cov->matrix->data[i] == serial_cov->matrix->data[i]);
+            for (int i=0; i< p; i+=7)
+                for (int j=0; j< p; j+=5){
+                    Apop_col(d, i, ci);
+                    Apop_col(d, j, cj);
+                    double slow = apop_vector_weighted_cov(ci, cj, d->weights);
+                    Diff(apop_data_get(cov, i, j), slow, 1e-9*(1+fabs(slow)));
+                    Diff(apop_data_get(cov, j, i), slow, 1e-9*(1+fabs(slow)));
+                    Diff(apop_data_get(cor, i, j), slow/sqrt(apop_vector_weighted_var(ci, d->weights)
+                                                        * apop_vector_weighted_var(cj, d->weights)), 1e-9);
+                }
+            for (int i=0; i< p; i++) Diff(apop_data_get(cor, i, i), 1, 1e-12);
+            apop_data_free(cov);
+            apop_data_free(cor);
+        }
+        apop_data_free(serial_cov);
+    }
+    apop_opts.thread_count = threads;
+    apop_data_free(d);
+}
+
 void test_jackknife(gsl_rng *r){
     double pv[] = {3.09,2.8762};
     int len = 2000;
@@ -827,6 +1002,18 @@ void test_jackknife(gsl_rng *r){
     //Notice that the jackknife just ain't a great estimator here.
 assert ((fabs(apop_data_get(out, 0,0) - gsl_pow_2(pv[1])/len)) < tol2 
             && fabs(apop_data_get(out, 1,1) - gsl_pow_2(pv[1])/(2*len)) < tol2*100);
+
+    //The threaded jackknife estimates the same subsets as the serial one.
+    apop_data *threaded_out = apop_jackknife_cov(d, *m, .threaded='y');
+    gsl_matrix_sub(threaded_out->matrix, out->matrix);
+    assert(apop_matrix_map_all_sum(threaded_out->matrix, fabs) < 1e-12);
+    apop_data_free(threaded_out);
+
+    apop_data *threaded_boot = apop_bootstrap_cov(d, *m, .threaded='y');
+    assert (fabs(apop_data_get(threaded_boot) - gsl_pow_2(pv[1])/len) < tol2
+                && fabs(apop_data_get(threaded_boot, 1,1) - gsl_pow_2(pv[1])/(2*len)) < tol2);
+    apop_data_free(threaded_boot);
+
     apop_data *out2 = apop_bootstrap_cov(d, *m, .keep_boots='y');
     assert (fabs(apop_data_get(out2) - gsl_pow_2(pv[1])/len) < tol2
                 && fabs(apop_data_get(out2, 1,1) - gsl_pow_2(pv[1])/(2*len)) < tol2);
@@ -872,6 +1059,251 @@ int test_jack(gsl_rng *r){
     return (error < 1e-2);//still not very accurate.
 }
 
+//A quartic with no score function, so the Hessian is all numerical derivatives.
+static double quartic_ll(apop_data *d, apop_model *m){
+    double A[3][3] = {{4,1,.5},{1,3,.2},{.5,.2,2}}, *t = m->parameters->vector->data, out = 0;
+    for (int i=0; i< 3; i++)
+        for (int j=0; j< 3; j++)
+            out -= t[i]*A[i][j]*t[j]*(1+0.1*t[i]*t[i])/2;
+    return out;
+}
+
+void test_threaded_hessian(){
+    apop_model *m = apop_model_copy((apop_model){"quartic", .vbase=3, .log_likelihood=quartic_ll});
+    m->parameters = apop_data_fill(apop_data_alloc(3), .3, -.2, .5);
+    apop_data *serial = apop_model_hessian(NULL, m);
+    Diff(apop_data_get(serial, 0, 0), -4.2205, 1e-4);
+    Diff(apop_data_get(serial, 0, 2), -.5255, 1e-4);
+    Diff(apop_data_get(serial, 2, 0), -.5255, 1e-4);
+
+    int threads = apop_opts.thread_count;
+    apop_opts.thread_count = 3;
+    Apop_model_add_group(m, apop_mle, .threaded_derivs='y');
+    apop_data *threaded = apop_model_hessian(NULL, m);
+    Apop_settings_set(m, apop_mle, deriv_method, 'f');
+    apop_data *forward = apop_model_hessian(NULL, m);
+    apop_opts.thread_count = threads;
+    for (int i=0; i< 3; i++)
+        for (int j=0; j< 3; j++){
+            Diff(apop_data_get(threaded, i, j), apop_data_get(serial, i, j), 1e-10);
+            Diff(apop_data_get(forward, i, j), apop_data_get(serial, i, j), 1e-2);
+        }
+    assert(apop_data_get(m->parameters, 2, -1) == .5); //left where it started.
+    apop_data_free(serial);
+    apop_data_free(threaded);
+    apop_data_free(forward);
+    apop_model_free(m);
+}
+
+//Local max near -2, global max near +2.
+static double two_humps_ll(apop_data *d, apop_model *m){
+    double b = m->parameters->vector->data[0];
+    return -gsl_pow_2(b*b-4) + b;
+}
+
+void test_multistart(){
+    apop_model *m = apop_model_copy((apop_model){"two humps", .vbase=1, .log_likelihood=two_humps_ll});
+    Apop_model_add_group(m, apop_mle, .starting_pt=(double[]){-2.5}, .method=APOP_SIMPLEX_NM,
+                                      .tolerance=1e-8);
+    Apop_model_add_group(m, apop_parts_wanted, .info='y');
+    apop_model *single = apop_estimate(NULL, *m);
+    assert(apop_data_get(single->parameters, 0, -1) < -1.9);
+
+    Apop_settings_set(m, apop_mle, start_count, 8);
+    Apop_settings_set(m, apop_mle, start_spread, 3);
+    apop_model *multi = apop_estimate(NULL, *m);
+    Diff(apop_data_get(multi->parameters, 0, -1), 2.031, 1e-3);
+    Diff(apop_data_get(multi->info, .rowname="log likelihood"), two_humps_ll(NULL, multi), 1e-6);
+    apop_data *starts = apop_data_get_page(multi->info, "<Multistart>", .match='e');
+    assert(starts && starts->matrix->size1 == 8);
+    Diff(apop_data_get(starts, .row=0, .colname="log likelihood"), 
+            apop_log_likelihood(NULL, single), 1e-6);
+    apop_model_free(single);
+    apop_model_free(multi);
+    apop_model_free(m);
+}
+
+static double kernel_p_at(apop_data *row, void *kernel){ return apop_p(row, kernel); }
+
+void test_fast_kernel(gsl_rng *r){
+    apop_model *unif = apop_model_set_parameters(apop_uniform, 0, 100);
+    apop_data *d = apop_model_draws(unif, 2000, r);
+    d->weights = gsl_vector_alloc(2000);
+    for (int i=0; i< 2000; i++) gsl_vector_set(d->weights, i, 1 + i%3);
+    apop_model *exact = apop_estimate(d, apop_kernel_density);
+    apop_model *fast = apop_model_copy(apop_kernel_density);
+    Apop_model_add_group(fast, apop_kernel_density, .base_data=d, .method='f');
+    assert(Apop_settings_get(fast, apop_kernel_density, sorted_vals));
+    apop_data *pt = apop_data_alloc(0, 1, 1);
+    for (double x = -10; x < 110; x += 0.37){
+        apop_data_set(pt, 0, 0, x);
+        Diff(apop_p(pt, fast), apop_p(pt, exact), 1e-12);
+        Diff(apop_cdf(pt, fast), apop_cdf(pt, exact), 1e-12);
+    }
+
+    //p only reads the sorted data, so a threaded map gives the same answers.
+    apop_data *pts = apop_data_alloc(0, 300, 1);
+    for (int i=0; i< 300; i++) apop_data_set(pts, i, 0, -10 + i*0.4);
+    int threads = apop_opts.thread_count;
+    apop_opts.thread_count = 4;
+    apop_data *threaded = apop_map(pts, .fn_rp=kernel_p_at, .param=fast);
+    apop_opts.thread_count = threads;
+    for (int i=0; i< 300; i++){
+        Apop_row(pts, i, row);
+        apop_data_set(pt, 0, 0, row->data[0]);
+        assert(apop_data_get(threaded, i, -1) == apop_p(pt, fast));
+    }
+
+    //Swapping in a new data set without re-estimating falls back to the exact sum.
+    apop_model *pmf = Apop_settings_get(fast, apop_kernel_density, base_pmf);
+    apop_data *orig = pmf->data;
+    pmf->data = pts;
+    apop_model *exact_pts = apop_estimate(pts, apop_kernel_density);
+    apop_data_set(pt, 0, 0, 50);
+    Diff(apop_p(pt, fast), apop_p(pt, exact_pts), 1e-12);
+    pmf->data = orig;
+    apop_model_free(exact_pts);
+    apop_data_free(threaded);
+    apop_data_free(pts);
+    apop_data_free(pt);
+    apop_data_free(d);
+    apop_model_free(fast);
+    apop_model_free(exact);
+    apop_model_free(unif);
+}
+
+//Each row of the batched output should match a one-at-a-time log likelihood.
+static void check_batch(apop_model *m, apop_data *d, gsl_matrix *params){
+    gsl_vector *lls = apop_log_likelihoods(d, m, params);
+    gsl_vector *ps = apop_ps(d, m, params);
+    apop_model *one = apop_model_copy(*m);
+    for (size_t i=0; i< params->size1; i++){
+        Apop_matrix_row(params, i, row);
+        apop_data_unpack(row, one->parameters);
+        double ll = apop_log_likelihood(d, one);
+        Diff(gsl_vector_get(lls, i), ll, 1e-8*fabs(ll));
+        Diff(gsl_vector_get(ps, i), exp(ll), 1e-8*exp(ll));
+    }
+    gsl_vector_free(lls);
+    gsl_vector_free(ps);
+    apop_model_free(one);
+}
+
+void test_batched_log_likelihoods(gsl_rng *r){
+    apop_model *models[] = {apop_model_set_parameters(apop_normal, 1.5, 2),
+                            apop_model_set_parameters(apop_lognormal, .5, .3),
+                            apop_model_set_parameters(apop_exponential, 1.2),
+                            apop_model_set_parameters(apop_gamma, 2, 1.5),
+                            apop_model_set_parameters(apop_poisson, 3),
+                            apop_model_set_parameters(apop_beta, 2, 3), //no native batch
+                            NULL};
+    for (apop_model **m = models; *m; m++){
+        apop_data *d = apop_model_draws(*m, 30, r);
+        size_t psize = (*m)->parameters->vector->size;
+        gsl_matrix *params = gsl_matrix_alloc(6, psize);
+        for (size_t i=0; i< 6; i++)
+            for (size_t j=0; j< psize; j++)
+                gsl_matrix_set(params, i, j, gsl_vector_get((*m)->parameters->vector, j)*(0.6 + 0.15*i));
+        check_batch(*m, d, params);
+        gsl_matrix_free(params);
+        apop_data_free(d);
+        apop_model_free(*m);
+    }
+
+    apop_model *mvn = apop_model_copy(apop_multivariate_normal);
+    mvn->parameters = apop_data_fill(apop_data_alloc(2, 2, 2), 1, 1, .5,
+                                                        -2, .5, 2);
+    mvn->dsize = 2;
+    apop_data *d = apop_model_draws(mvn, 40, r);
+    gsl_matrix *params = gsl_matrix_alloc(3, 6);
+    for (size_t i=0; i< 3; i++){
+        gsl_vector *packed = apop_data_pack(mvn->parameters);
+        gsl_vector_set(packed, 0, i);
+        gsl_vector_set(packed, 2, 1+i);
+        gsl_matrix_set_row(params, i, packed);
+        gsl_vector_free(packed);
+    }
+    check_batch(mvn, d, params);
+    gsl_matrix_free(params);
+    apop_data_free(d);
+    apop_model_free(mvn);
+}
+
+void test_mvn_cache(){
+    apop_model *mvn = apop_model_copy(apop_multivariate_normal);
+    mvn->parameters = apop_data_fill(apop_data_alloc(3, 3, 3), 1,   2, .5,  0,
+                                                              0,  .5,  1, .3,
+                                                             -1,   0, .3,  3);
+    mvn->dsize = 3;
+    gsl_rng *r1 = apop_rng_alloc(8), *r2 = apop_rng_alloc(8);
+    apop_data *batch = apop_model_draws(mvn, 500, r1);
+    apop_data *one_by_one = apop_data_alloc(500, 3);
+    for (int i=0; i< 500; i++){
+        Apop_row(one_by_one, i, onerow);
+        apop_draw(onerow->data, r2, mvn);
+    }
+    for (int i=0; i< 500; i++)
+        for (int j=0; j< 3; j++)
+            Diff(apop_data_get(batch, i, j), apop_data_get(one_by_one, i, j), 1e-12);
+    assert(Apop_settings_get_group(mvn, apop_mvn));
+
+    //the cached factor has to follow changes in the covariance.
+    gsl_matrix *params = gsl_matrix_alloc(2, 12);
+    double ll[2];
+    for (int i=0; i< 2; i++){
+        apop_data_set(mvn->parameters, 1, 1, 1+i);
+        gsl_vector *packed = apop_data_pack(mvn->parameters);
+        gsl_matrix_set_row(params, i, packed);
+        gsl_vector_free(packed);
+        ll[i] = apop_log_likelihood(batch, mvn);
+    }
+    gsl_vector *lls = apop_log_likelihoods(batch, mvn, params);
+    for (int i=0; i< 2; i++)
+        Diff(ll[i], gsl_vector_get(lls, i), 1e-8*fabs(ll[i]));
+    assert(ll[0] != ll[1]);
+    gsl_vector_free(lls);
+    apop_data_set(mvn->parameters, 0, 1, 3); //no longer positive definite.
+    apop_data_set(mvn->parameters, 1, 0, 3);
+    assert(gsl_isinf(apop_log_likelihood(batch, mvn)));
+    gsl_matrix_free(params);
+    apop_data_free(batch);
+    apop_data_free(one_by_one);
+    gsl_rng_free(r1); gsl_rng_free(r2);
+    apop_model_free(mvn);
+}
+
+//The Normal prior/Exponential likelihood pair isn't in the conjugate table, so this is MCMC.
+void test_random_walk_update(gsl_rng *r){
+    int draws = 400;
+    apop_model *expo = apop_model_set_parameters(apop_exponential, 2);
+    apop_data *d = apop_data_alloc(draws, 1);
+    for (int i=0; i< draws; i++)
+        apop_draw(apop_data_ptr(d, i, 0), r, expo);
+    double mean = apop_matrix_mean(d->matrix);
+    apop_model *prior = apop_model_set_parameters(apop_normal, 1, 5);
+    Apop_model_add_group(prior, apop_update, .method='r', .chain_count=3, .periods=1e4, .burnin=.2);
+    apop_model *like = apop_model_copy(apop_exponential);
+    apop_model *post = apop_update(d, prior, like, r);
+    //With a flat-ish prior, the posterior mean is about sum(x)/(n-1), with sd about mean/sqrt(n).
+    double post_mean, post_var;
+    apop_matrix_mean_and_var(post->data->matrix, &post_mean, &post_var);
+    Diff(post_mean, mean*draws/(draws-1.), 0.03);
+    Diff(sqrt(post_var), mean/sqrt(draws), 0.02);
+    for (int c=0; c< 3; c++){
+        char name[100];
+        sprintf(name, "accept rate, chain %i", c);
+        double rate = apop_data_get(post->info, .rowname=name);
+        assert(rate > 0.1 && rate < 0.5);
+    }
+    assert(apop_data_get(post->info, .rowname="R-hat 0") < 1.1);
+    apop_data_free(d);
+    apop_model_free(expo);
+    apop_model_free(prior);
+    apop_model_free(like);
+    apop_data_free(post->data);
+    apop_model_free(post);
+}
+
 void test_lognormal(gsl_rng *r){
     apop_model *source = apop_model_copy(apop_normal);
     apop_model_clear(NULL, source);
@@ -1066,6 +1498,80 @@ void test_blank_db_queries(){
     assert(gsl_isnan(h));
 }
 
+//Numbers come out of the db as doubles, so they shouldn't lose digits to a text round trip.
+//Also check that growing the output geometrically leaves it trimmed to the right size.
+void test_typed_queries(){
+    apop_query("create table typed (a, b, c)");
+    for (int i=0; i< 1000; i++)
+        apop_query("insert into typed values(%i, 1.0/%i, '%i')", i, i+3, i*2);
+    apop_query("insert into typed values(NULL, 'NaN', 'NULL')");
+    apop_data *d = apop_query_to_data("select * from typed");
+    assert(d->matrix->size1 == 1001 && d->matrix->size2 == 3);
+    for (int i=0; i< 1000; i++){
+        assert(apop_data_get(d, i, 0) == i);
+        assert(apop_data_get(d, i, 1) == 1./(i+3));
+        assert(apop_data_get(d, i, 2) == i*2);
+    }
+    assert(gsl_isnan(apop_data_get(d, 1000, 0)));
+    assert(gsl_isnan(apop_data_get(d, 1000, 1)));
+    assert(gsl_isnan(apop_data_get(d, 1000, 2)));
+    apop_data *m = apop_query_to_mixed_data("vmwt", "select a, b, a+1, c from typed where a < 10;"
+                                                     "select 50, 0.5, 51, 'last'");
+    assert(m->vector->size == 11 && m->matrix->size1 == 11 
+            && m->weights->size == 11 && *m->textsize == 11);
+    assert(apop_data_get(m, 10, -1) == 50);
+    assert(apop_data_get(m, 3, 0) == 1./6);
+    assert(gsl_vector_get(m->weights, 9) == 10);
+    assert(apop_strcmp(m->text[10][0], "last"));
+    apop_data_free(d);
+    apop_data_free(m);
+    apop_table_exists("typed", 'd');
+}
+
+//The threaded reader kicks in for files bigger than a few read buffers, and has to
+//split between lines the way the serial reader sees them.
+void test_threaded_text_read(){
+    int threads = apop_opts.thread_count;
+    FILE *f = fopen("threadtest", "w");
+    fprintf(f, "# a comment with a \"quote\n\n first, second, third\n");
+    for (int i=0; i< 20000; i++)
+        if (i%97==0) fprintf(f, "\"r%i, spanning\na line\", %i, 'it''s\n%i'\n", i, i, i);
+        else if (i%89==0) fprintf(f, "\n  \n# just a comment, 'with' a quote\nr%i,,%i\n", i, i);
+        else fprintf(f, "r%i, %g, %i # trailing comment\n", i, i*.37, i%13);
+    fprintf(f, "last, 1, 2");
+    fclose(f);
+    apop_opts.thread_count = 1;
+    apop_data *serial = apop_text_to_data("threadtest", .has_row_names='y');
+    apop_text_to_db("threadtest", "serialtab");
+    apop_opts.thread_count = 3;
+    apop_data *threaded = apop_text_to_data("threadtest", .has_row_names='y');
+    apop_text_to_db("threadtest", "threadtab");
+    apop_data *bad_type = apop_text_alloc(NULL, 1, 2); //a create query that fails, after the map is set up.
+    apop_text_fill(bad_type, ".*", "numeric (");
+    int verbose = apop_opts.verbose; apop_opts.verbose = -1;
+    assert(apop_text_to_db("threadtest", "badtab", .field_params=bad_type) == -1);
+    apop_opts.verbose = verbose;
+    apop_data_free(bad_type);
+    apop_opts.thread_count = threads;
+    assert(serial->matrix->size1 == 20001 && serial->names->rowct == 20001);
+    assert(threaded->matrix->size1 == 20001 && threaded->names->rowct == 20001);
+    for (int i=0; i< 20001; i++){
+        assert(apop_strcmp(serial->names->row[i], threaded->names->row[i]));
+        for (int j=0; j< 2; j++)
+            assert(apop_data_get(serial, i, j) == apop_data_get(threaded, i, j)
+                    || (gsl_isnan(apop_data_get(serial, i, j)) && gsl_isnan(apop_data_get(threaded, i, j))));
+    }
+    assert(apop_strcmp(threaded->names->row[97], "r97, spanning\na line"));
+    assert(apop_query_to_float("select count(*) from threadtab") == 20001);
+    assert(!apop_query_to_float("select count(*) from (select rowid, * from serialtab "
+                                    "except select rowid, * from threadtab)"));
+    apop_data_free(serial);
+    apop_data_free(threaded);
+    apop_table_exists("serialtab", 'd');
+    apop_table_exists("threadtab", 'd');
+    unlink("threadtest");
+}
+
 int get_factor_index(apop_data *flist, char *findme){
     for (int i=0; i< flist->textsize[0]; i++)
         if (apop_strcmp(flist->text[i][0], findme))
@@ -1122,6 +1628,64 @@ void test_vector_moving_average(){
         assert(gsl_vector_get(v, i+1) == gsl_vector_get(slightly_smooth, i));
 }
 
+//Check the sliding-window stats against each window computed directly.
+void test_moving_stats(gsl_rng *r){
+    int n = 2000;
+    gsl_vector *v = gsl_vector_alloc(n), *w = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++){
+        gsl_vector_set(v, i, 1e6 + gsl_rng_uniform(r)*10 + i*1e-3); //offset tests the shift
+        gsl_vector_set(w, i, 1 + gsl_rng_uniform_int(r, 4));
+    }
+    gsl_vector_set(v, 1500, GSL_NAN);
+    for (int bw=1; bw < 300; bw = bw*3+1){
+        int width = (bw/2)*2+1;
+        gsl_vector *avg = apop_vector_moving_average(v, bw),
+                   *sum = apop_vector_moving_stat(v, bw, 's'),
+                   *var = apop_vector_moving_stat(v, bw, 'v'),
+                   *wvar = apop_vector_moving_stat(v, bw, 'v', .weights=w),
+                   *lo = apop_vector_moving_stat(v, bw, 'l'),
+                   *hi = apop_vector_moving_stat(v, bw, 'h');
+        assert(avg->size == n - width + 1);
+        for (int i=0; i< avg->size; i++){
+            gsl_vector_view win = gsl_vector_subvector(v, i, width);
+            gsl_vector_view ww = gsl_vector_subvector(w, i, width);
+            if (i <= 1500 && 1500 < i+width){
+                assert(isnan(avg->data[i]) && isnan(var->data[i]) && isnan(hi->data[i]));
+                continue;
+            }
+            Diff(avg->data[i], apop_vector_mean(&win.vector), 1e-9);
+            Diff(sum->data[i], apop_vector_sum(&win.vector), 1e-9*width);
+            if (width > 1) Diff(var->data[i], apop_vector_var(&win.vector), 1e-6);
+            if (width > 1){ //apop_vector_weighted_var uses E(x^2), so shift to keep its precision.
+                gsl_vector *shifted = apop_vector_copy(&win.vector);
+                gsl_vector_add_constant(shifted, -1e6);
+                Diff(wvar->data[i], apop_vector_weighted_var(shifted, &ww.vector), 1e-6);
+                gsl_vector_free(shifted);
+            }
+            assert(lo->data[i] == gsl_vector_min(&win.vector));
+            assert(hi->data[i] == gsl_vector_max(&win.vector));
+        }
+        gsl_vector_free(avg); gsl_vector_free(sum); gsl_vector_free(var);
+        gsl_vector_free(wvar); gsl_vector_free(lo); gsl_vector_free(hi);
+    }
+
+    //EW mean of a constant is the constant; EW mean and variance by the recursion.
+    gsl_vector *ewm = apop_vector_ewma(v, .alpha=0.05), *ewv = apop_vector_ewma(v, 0.05, 'v');
+    double m = v->data[0], s2 = 0;
+    assert(ewm->data[0] == m && ewv->data[0] == 0);
+    for (int i=1; i< n; i++){
+        if (!isnan(v->data[i])){
+            double d = v->data[i] - m;
+            m += 0.05*d;
+            s2 = 0.95*(s2 + 0.05*d*d);
+        }
+        Diff(ewm->data[i], m, 1e-9);
+        Diff(ewv->data[i], s2, 1e-9);
+    }
+    gsl_vector_free(ewm); gsl_vector_free(ewv);
+    gsl_vector_free(v); gsl_vector_free(w);
+}
+
 void test_transpose(){
     apop_data *t = apop_text_to_data("test_data", 0, 1);
     apop_data *tt = apop_data_transpose(t);
@@ -1176,6 +1740,37 @@ void test_unique_elements(){
     assert(!strcmp(".", dt->text[0][0]));
     assert(!strcmp("Hi,", dt->text[1][0]));
     assert(!strcmp("text", dt->text[5][0]));
+
+    //Each row's code is its place in the sorted list; NaNs (all one element) sort last, -0 == 0.
+    gsl_vector *codes = gsl_vector_alloc(9);
+    apop_data *dt2 = apop_text_unique_codes(t, 0, codes);
+    for (int i=0; i< 9; i++)
+        assert(!strcmp(dt2->text[(int)gsl_vector_get(codes, i)][0], t->text[i][0]));
+    assert(gsl_vector_get(codes, 1) == gsl_vector_get(codes, 4));
+
+    double nd[] = {3, GSL_NAN, -0.0, 1, GSL_NAN, 0, 3, -1};
+    gsl_vector *ndv = apop_array_to_vector(nd, 8);
+    gsl_vector *ncodes = gsl_vector_alloc(8);
+    gsl_vector *ndistinct = apop_vector_unique_codes(ndv, ncodes);
+    assert(ndistinct->size == 5);
+    assert(gsl_vector_get(ndistinct, 0) == -1 && gsl_vector_get(ndistinct, 3) == 3);
+    assert(gsl_isnan(gsl_vector_get(ndistinct, 4)));
+    double expected_codes[] = {3, 4, 1, 2, 4, 1, 3, 0};
+    for (int i=0; i< 8; i++) assert(gsl_vector_get(ncodes, i) == expected_codes[i]);
+
+    //Many rows, many repeats: check the codes against the sorted list.
+    int n = 20000;
+    gsl_vector *big = gsl_vector_alloc(n), *bigcodes = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++) gsl_vector_set(big, i, (i*7919) % 1009 - 500);
+    gsl_vector *bigdistinct = apop_vector_unique_codes(big, bigcodes);
+    assert(bigdistinct->size == 1009);
+    for (int i=1; i< 1009; i++) assert(gsl_vector_get(bigdistinct, i) == gsl_vector_get(bigdistinct, i-1) + 1);
+    for (int i=0; i< n; i++)
+        assert(gsl_vector_get(bigdistinct, gsl_vector_get(bigcodes, i)) == gsl_vector_get(big, i));
+    gsl_vector_free(big); gsl_vector_free(bigcodes); gsl_vector_free(bigdistinct);
+    gsl_vector_free(ndv); gsl_vector_free(ncodes); gsl_vector_free(ndistinct);
+    gsl_vector_free(codes);
+    apop_data_free(dt2);
 }
 
 void test_probit_and_logit(gsl_rng *r){
@@ -1205,6 +1800,129 @@ void test_probit_and_logit(gsl_rng *r){
     apop_data_free(data2);
 }
 
+//Three-way choices: the fused likelihoods should be the same at any thread count, and
+//their scores should match numerical gradients.
+void test_multichoice_ll(gsl_rng *r){
+    int n = 2000;
+    apop_data *d = apop_data_alloc(n, 3);
+    for (int i=0; i< n; i++){
+        apop_data_set(d, i, 0, (int)(gsl_rng_uniform(r)*3));
+        apop_data_set(d, i, 1, gsl_rng_uniform(r)*2-1);
+        apop_data_set(d, i, 2, gsl_rng_uniform(r)*2-1);
+    }
+    apop_model *models[] = {apop_model_copy(apop_logit), apop_model_copy(apop_probit)};
+    int threads = apop_opts.thread_count;
+    for (int k=0; k< 2; k++){
+        apop_model *m = models[k];
+        apop_prep(d, m);
+        assert(m->parameters->matrix->size1 == 3 && m->parameters->matrix->size2 == 2);
+        for (int j=0; j< 6; j++) m->parameters->matrix->data[j] = (j-2.5)/4;
+        apop_opts.thread_count = 1;
+        double ll = apop_log_likelihood(d, m);
+        apop_opts.thread_count = 3;
+        Diff(apop_log_likelihood(d, m), ll, 1e-9*fabs(ll));
+
+        gsl_vector *score = gsl_vector_alloc(6);
+        apop_score(d, score, m);
+        gsl_vector *numeric = apop_numerical_gradient(d, m);
+        for (int j=0; j< 6; j++)
+            Diff(gsl_vector_get(score, j), gsl_vector_get(numeric, j), 1e-3*(1+fabs(gsl_vector_get(numeric, j))));
+        gsl_vector_free(score);
+        gsl_vector_free(numeric);
+        apop_opts.thread_count = threads;
+    }
+
+    //check the logit against the textbook form.
+    long double ll = 0;
+    gsl_matrix *beta = models[0]->parameters->matrix;
+    for (int i=0; i< n; i++){
+        Apop_row(d, i, x);
+        double xb[3] = {0}, total = 1;
+        for (int j=1; j< 3; j++){
+            Apop_matrix_col(beta, j-1, b);
+            gsl_blas_ddot(x, b, xb+j);
+            total += exp(xb[j]);
+        }
+        ll += xb[(int)apop_data_get(d, i, -1)] - log(total);
+    }
+    Diff(apop_log_likelihood(d, models[0]), ll, 1e-9*fabs(ll));
+    apop_model_free(models[0]);
+    apop_model_free(models[1]);
+    apop_data_free(d);
+}
+
+//A row function for apop_dot_map_sum: add up (x beta_0)(x beta_1), and put x beta in the accumulator.
+static double xb_product(double const *xb, size_t row, void *param, double *acc){
+    acc[0] += xb[0];
+    acc[1] += xb[1];
+    return xb[0]*xb[1];
+}
+
+//apop_dot_map_sum and the OLS likelihood and score built on it should match the
+//write-it-all-down versions, at any thread count.
+void test_dot_map_sum(gsl_rng *r){
+    int n = 3001;
+    apop_data *d = apop_data_alloc(n, n, 4);
+    d->weights = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++){
+        for (int j=0; j< 4; j++) apop_data_set(d, i, j, gsl_rng_uniform(r)*2-1);
+        apop_data_set(d, i, -1, 1 + apop_data_get(d, i, 1) - 2*apop_data_get(d, i, 3) + gsl_rng_uniform(r));
+        gsl_vector_set(d->weights, i, 0.5 + gsl_rng_uniform(r));
+    }
+    apop_data *beta = apop_data_alloc(4, 2);
+    for (int j=0; j< 8; j++) beta->matrix->data[j] = (j-3.5)/3;
+
+    apop_data *xb = apop_dot(d, beta);
+    long double product = 0, sums[2] = {0};
+    for (int i=0; i< n; i++){
+        product += apop_data_get(xb, i, 0) * apop_data_get(xb, i, 1);
+        sums[0] += apop_data_get(xb, i, 0);
+        sums[1] += apop_data_get(xb, i, 1);
+    }
+    gsl_vector *acc = gsl_vector_alloc(2);
+    int threads = apop_opts.thread_count;
+    double first_sum;
+    for (int t=1; t<= 4; t+=3){
+        apop_opts.thread_count = t;
+        double dotsum = apop_dot_map_sum(d->matrix, beta->matrix, xb_product, NULL, acc);
+        Diff(dotsum, product, 1e-9*fabs(product));
+        if (t==1) first_sum = dotsum;
+        else assert(dotsum == first_sum); //same grouping at any thread count
+        Diff(gsl_vector_get(acc, 0), sums[0], 1e-9*(1+fabs(sums[0])));
+        Diff(gsl_vector_get(acc, 1), sums[1], 1e-9*(1+fabs(sums[1])));
+    }
+    apop_opts.thread_count = threads;
+
+    apop_model *est = apop_estimate(d, apop_ols);
+    gsl_vector *b = est->parameters->vector;
+    gsl_vector *errors = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++){
+        Apop_row(d, i, x);
+        double expected;
+        gsl_blas_ddot(x, b, &expected);
+        gsl_vector_set(errors, i, expected - apop_data_get(d, i, -1));
+    }
+    double sigma = sqrt(apop_vector_var(errors));
+    long double ll = 0;
+    gsl_vector *score = gsl_vector_calloc(4), *fast_score = gsl_vector_alloc(4);
+    for (int i=0; i< n; i++){
+        double e = gsl_vector_get(errors, i), w = gsl_vector_get(d->weights, i);
+        ll += log(gsl_ran_gaussian_pdf(e, sigma) * w);
+        for (int j=0; j< 4; j++)
+            apop_vector_increment(score, j, w * apop_data_get(d, i, j) * e/gsl_pow_2(sigma));
+    }
+    Diff(apop_log_likelihood(d, est), ll, 1e-9*fabs(ll));
+    apop_score(d, fast_score, est);
+    for (int j=0; j< 4; j++)
+        Diff(gsl_vector_get(fast_score, j), gsl_vector_get(score, j), 1e-8*(1+fabs(gsl_vector_get(score, j))));
+
+    gsl_vector_free(errors); gsl_vector_free(score); gsl_vector_free(fast_score); gsl_vector_free(acc);
+    apop_model_free(est);
+    apop_data_free(xb);
+    apop_data_free(beta);
+    apop_data_free(d);
+}
+
 void test_resize(){
     //This is the multiplication table from _Modeling with Data_
     //with a +.1 to distinguish columns from rows.
@@ -1322,6 +2040,41 @@ void row_manipulations(){
 }
 
 
+static double row_index(gsl_vector *in, int index){ return index;}
+static double data_row_index(apop_data *in, int index){ return index;}
+static double vector_sum(gsl_vector *in){ return apop_vector_sum(in);}
+
+//Rows of uneven cost, some of which map_sum a vector of their own.
+static double uneven_row(apop_data *in){
+    double val = apop_data_get(in, 0, 0), out = 0;
+    if ((int)val % 7) return val;
+    apop_data *inner = apop_data_alloc(1+(int)val%50);
+    gsl_vector_set_all(inner->vector, 1);
+    out = apop_map_sum(inner, .fn_d=is_odd) - inner->vector->size + val;
+    apop_data_free(inner);
+    return out;
+}
+
+void test_map_pool(){
+    int n = 1000, threads = apop_opts.thread_count;
+    apop_data *d = apop_data_alloc(n, 3);
+    for (int i=0; i< n; i++)
+        for (int j=0; j< 3; j++)
+            apop_data_set(d, i, j, i*(j+1));
+    for (int t=1; t<= 4; t+=3){
+        apop_opts.thread_count = t;
+        //the index is for the whole data set, not the chunk.
+        assert(apop_map_sum(d, .fn_vi=row_index) == n*(n-1)/2);
+        assert(apop_map_sum(d, .fn_r=uneven_row) == n*(n-1)/2);
+        assert(apop_map_sum(d, .fn_v=vector_sum, .part='c') == 6*n*(n-1)/2);
+        apop_data *idx = apop_map(d, .fn_ri=data_row_index);
+        for (int i=0; i< n; i++) assert(apop_data_get(idx, i, -1) == i);
+        apop_data_free(idx);
+    }
+    apop_opts.thread_count = threads;
+    apop_data_free(d);
+}
+
 void test_pmf(){
     double x[] = {0, 0.2, 0 , 0.4, 1, .7, 0 , 0, 0};
     gsl_rng *r = apop_rng_alloc(1234);
@@ -1341,6 +2094,31 @@ void test_pmf(){
     apop_vector_normalize(v);
     for (size_t i=0; i < v->size; i ++)
         Diff(d->weights->data[i], v->data[i], 1e-2);
+
+    //Again, via the alias table and the batch-drawing routine.
+    Apop_settings_set(m, apop_pmf, draw_method, 'a');
+    m->dsize = 1; //one row index per draw.
+    apop_data *draws = apop_model_draws(m, 1e5, r);
+    gsl_vector_set_zero(v);
+    for (size_t i=0; i< 1e5; i++)
+        apop_vector_increment(v, apop_data_get(draws, i, 0));
+    apop_vector_normalize(v);
+    for (size_t i=0; i < v->size; i ++)
+        Diff(d->weights->data[i], v->data[i], 1e-2);
+    apop_data_free(draws);
+
+    //Edit the weights in place; apop_pmf_invalidate drops the alias table.
+    for (size_t i=0; i< 9; i++) d->weights->data[i] = x[8-i];
+    apop_vector_normalize(d->weights);
+    apop_pmf_invalidate(m);
+    draws = apop_model_draws(m, 1e5, r);
+    gsl_vector_set_zero(v);
+    for (size_t i=0; i< 1e5; i++)
+        apop_vector_increment(v, apop_data_get(draws, i, 0));
+    apop_vector_normalize(v);
+    for (size_t i=0; i < v->size; i ++)
+        Diff(d->weights->data[i], v->data[i], 1e-2);
+    apop_data_free(draws);
     apop_model_free(m);
     apop_data_free(d);
     gsl_vector_free(v);
@@ -1400,6 +2178,27 @@ void test_pmf_compress(gsl_rng *r){
     assert(apop_strcmp(d->text[2][0], "Pair"));
     assert(apop_strcmp(d->text[3][0], "Nada"));
 
+    //p() looks rows up by their contents, NaNs included.
+    apop_model *pmf = apop_estimate(d, apop_pmf);
+    Apop_data_row(d, 2, pair);
+    Diff(apop_p(pair, pmf), 4/9., 1e-10);
+    Apop_data_row(d, 3, nada);
+    Diff(apop_p(nada, pmf), 1/9., 1e-10);
+    apop_data *triple = apop_data_copy(pair);
+    apop_text_add(triple, 0, 0, "Triple");
+    assert(apop_p(triple, pmf) == 0);
+    apop_data_free(triple);
+    //After an in-place edit, re-estimating or apop_pmf_invalidate rebuilds the index.
+    d->vector->data[2] = 3;
+    pmf->estimate(d, pmf);
+    Diff(apop_p(pair, pmf), 4/9., 1e-10);
+    d->vector->data[2] = 2;
+    d->weights->data[2] = 13;
+    apop_pmf_invalidate(pmf);
+    Diff(apop_p(pair, pmf), 13/18., 1e-10);
+    d->weights->data[2] = 4;
+    apop_model_free(pmf);
+
     apop_data *b = apop_data_alloc();
     b->vector = apop_array_to_vector((double []){1.1, 2.1, 2, 1, 1}, 5);
     apop_text_alloc(b, 5, 1);
@@ -1446,6 +2245,18 @@ void test_weighted_regression(apop_data *d,apop_model *e){
     gsl_vector_set_all(cp->weights, 3);
     apop_model *e2 = apop_estimate(cp, apop_ols);
     assert( apop_vector_distance(e2->parameters->vector, e->parameters->vector) < tol5);
+
+    //A weight of two should act like a second copy of the row.
+    size_t n = d->matrix->size1;
+    for (size_t i=0; i< n; i++) gsl_vector_set(cp->weights, i, i < n/2 ? 1 : 2);
+    Apop_data_rows(d, n/2, n-n/2, back_half);
+    apop_data *doubled = apop_data_stack(d, back_half);
+    apop_model *wls = apop_estimate(cp, apop_ols);
+    apop_model *dup = apop_estimate(doubled, apop_ols);
+    assert( apop_vector_distance(wls->parameters->vector, dup->parameters->vector) < tol5);
+    apop_model_free(wls);
+    apop_model_free(dup);
+    apop_data_free(doubled);
 }
 
 void test_ols_offset(gsl_rng *r){
@@ -1480,6 +2291,204 @@ void test_ols_offset(gsl_rng *r){
     apop_data_free(useme);
 }
 
+typedef struct {
+    apop_data *d;
+    size_t next, rows;
+} ols_reader;
+
+//Hand out copies of the rows of the full data set, a few rows at a time.
+apop_data *ols_next_block(void *info){
+    ols_reader *rd = info;
+    size_t n = GSL_MIN(rd->rows, rd->d->matrix->size1 - rd->next);
+    if (!n) return NULL;
+    apop_data *out = apop_data_alloc(n, rd->d->matrix->size2);
+    apop_name_stack(out->names, rd->d->names, 'c');
+    gsl_matrix_view rows = gsl_matrix_submatrix(rd->d->matrix, rd->next, 0, n, rd->d->matrix->size2);
+    gsl_matrix_memcpy(out->matrix, &rows.matrix);
+    if (rd->d->weights){
+        out->weights = gsl_vector_alloc(n);
+        gsl_vector_view w = gsl_vector_subvector(rd->d->weights, rd->next, n);
+        gsl_vector_memcpy(out->weights, &w.vector);
+    }
+    rd->next += n;
+    return out;
+}
+
+void compare_ols_fits(apop_model *in_memory, apop_model *streamed, char all_info){
+    for (int i=0; i< in_memory->parameters->vector->size; i++){
+        Diff(apop_data_get(in_memory->parameters, i, -1), apop_data_get(streamed->parameters, i, -1), 1e-9);
+        assert(!strcmp(in_memory->parameters->names->row[i], streamed->parameters->names->row[i]));
+        for (int j=0; j< in_memory->parameters->vector->size; j++)
+            Diff(apop_data_get(in_memory->parameters, i, j, .page="<Covariance>"),
+                 apop_data_get(streamed->parameters, i, j, .page="<Covariance>"), 1e-9);
+        Diff(apop_data_get(in_memory->info, i, .colname="p value", .page="<test info>"),
+             apop_data_get(streamed->info, i, .colname="p value", .page="<test info>"), 1e-9);
+    }
+    if (all_info == 'y')
+        for (int i=0; i< in_memory->info->names->rowct; i++){
+            char *name = in_memory->info->names->row[i];
+            double mem = apop_data_get(in_memory->info, .rowname=name);
+            Diff(mem, apop_data_get(streamed->info, .rowname=name), 1e-9*GSL_MAX(1, fabs(mem)));
+        }
+}
+
+/* Estimate OLS with the data in memory, then again reading the data in blocks, both
+from a function and from a database query. The estimates should match, even when the
+blocks have awkward sizes. */
+void test_ols_stream(gsl_rng *r){
+    int size1 = 5000;
+    apop_data *d = apop_data_alloc(size1, 3);
+    apop_name_add(d->names, "y", 'c');
+    apop_name_add(d->names, "x1", 'c');
+    apop_name_add(d->names, "x2", 'c');
+    for (int i=0; i< size1; i++){
+        double x1 = 100*gsl_rng_uniform(r), x2 = 50 + gsl_ran_gaussian(r, 10);
+        apop_data_set(d, i, 1, x1);
+        apop_data_set(d, i, 2, x2);
+        apop_data_set(d, i, 0, 2 + 0.5*x1 - 3*x2 + gsl_ran_gaussian(r, 4));
+    }
+    apop_data *cp = apop_data_copy(d);
+    apop_model *in_memory = apop_estimate(cp, apop_ols);
+
+    apop_model *streamer = apop_model_copy(apop_ols);
+    ols_reader rd = {.d=d, .rows=333};
+    Apop_model_add_group(streamer, apop_lm, .chunk_fn=ols_next_block, .chunk_info=&rd);
+    apop_model *streamed = apop_estimate(NULL, *streamer);
+    assert(!streamed->error);
+    assert(!apop_data_get_page(streamed->info, "<Predicted>"));
+    compare_ols_fits(in_memory, streamed, 'y');
+
+    //The block sums are grouped the same way at any thread count.
+    int threads = apop_opts.thread_count;
+    apop_opts.thread_count = threads > 1 ? 1 : 4;
+    rd.next = 0;
+    apop_model *other_threads = apop_estimate(NULL, *streamer);
+    apop_opts.thread_count = threads;
+    for (int i=0; i< 3; i++)
+        assert(apop_data_get(other_threads->parameters, i, -1) == apop_data_get(streamed->parameters, i, -1));
+    apop_model_free(other_threads);
+    apop_model_free(streamed);
+
+    apop_table_exists("ols_stream", 'd');
+    apop_data_print(d, "ols_stream", .output_type='d');
+    Apop_settings_set(streamer, apop_lm, chunk_fn, NULL);
+    Apop_settings_set(streamer, apop_lm, query, "select * from ols_stream");
+    Apop_settings_set(streamer, apop_lm, chunk_rows, 1001);
+    streamed = apop_estimate(NULL, *streamer);
+    compare_ols_fits(in_memory, streamed, 'y');
+    apop_model_free(streamed);
+    apop_model_free(in_memory);
+
+    //WLS: the parameters, covariance, and tests still match.
+    d->weights = gsl_vector_alloc(size1);
+    for (int i=0; i< size1; i++) gsl_vector_set(d->weights, i, 0.5 + gsl_rng_uniform(r));
+    apop_data_free(cp);
+    cp = apop_data_copy(d);
+    in_memory = apop_estimate(cp, apop_ols);
+    Apop_settings_set(streamer, apop_lm, query, NULL);
+    Apop_settings_set(streamer, apop_lm, chunk_fn, ols_next_block);
+    rd.next = 0;
+    streamed = apop_estimate(NULL, *streamer);
+    compare_ols_fits(in_memory, streamed, 'n');
+
+    //A query error leaves an error code on the model.
+    Apop_settings_set(streamer, apop_lm, chunk_fn, NULL);
+    Apop_settings_set(streamer, apop_lm, query, "select * from no_such_table");
+    int v = apop_opts.verbose; apop_opts.verbose = -1;
+    apop_model *bad = apop_estimate(NULL, *streamer);
+    apop_opts.verbose = v;
+    assert(bad->error);
+    apop_table_exists("ols_stream", 'd');
+    apop_model_free(bad);
+    apop_model_free(streamed);
+    apop_model_free(in_memory);
+    apop_model_free(streamer);
+    apop_data_free(cp);
+    apop_data_free(d);
+}
+
+apop_model *ols_with_solver(apop_data *d, char solver){
+    apop_model *m = apop_model_copy(apop_ols);
+    Apop_model_add_group(m, apop_lm, .solver=solver);
+    apop_model *out = apop_estimate(apop_data_copy(d), *m);
+    apop_model_free(m);
+    return out;
+}
+
+/* The Cholesky, QR, and inverse solvers should give the same OLS estimates, and
+apop_lm_solve should give the same coefficients as one estimation per dependent
+variable, with or without weights. */
+void test_ols_solvers(gsl_rng *r){
+    int n = 500, ycount = 4;
+    apop_data *d = apop_data_alloc(n, 4);
+    apop_data *ys = apop_data_alloc(n, ycount);
+    for (int i=0; i< n; i++){
+        for (int j=1; j< 4; j++) apop_data_set(d, i, j, gsl_ran_gaussian(r, j*3) + j);
+        for (int c=0; c< ycount; c++)
+            apop_data_set(ys, i, c, c + (c-1.5)*apop_data_get(d, i, 1) + c*c*apop_data_get(d, i, 3)
+                                      + gsl_ran_gaussian(r, 1));
+        apop_data_set(d, i, 0, apop_data_get(ys, i, 0));
+    }
+    for (int weighted=0; weighted< 2; weighted++){
+        if (weighted){
+            d->weights = gsl_vector_alloc(n);
+            for (int i=0; i< n; i++) gsl_vector_set(d->weights, i, 0.1 + gsl_rng_uniform(r));
+        }
+        apop_model *inv = ols_with_solver(d, 'i'),
+                   *chol = ols_with_solver(d, 'c'),
+                   *qr = ols_with_solver(d, 'q');
+        for (int i=0; i< 4; i++){
+            Diff(apop_data_get(inv->parameters, i, -1), apop_data_get(chol->parameters, i, -1), 1e-9);
+            Diff(apop_data_get(inv->parameters, i, -1), apop_data_get(qr->parameters, i, -1), 1e-9);
+            for (int j=0; j< 4; j++){
+                double cov = apop_data_get(inv->parameters, i, j, .page="<Covariance>");
+                Diff(cov, apop_data_get(chol->parameters, i, j, .page="<Covariance>"), 1e-12);
+                Diff(cov, apop_data_get(qr->parameters, i, j, .page="<Covariance>"), 1e-12);
+            }
+        }
+        Diff(apop_data_get(inv->info, .rowname="SSE"), apop_data_get(qr->info, .rowname="SSE"), 1e-6);
+
+        //Many dependent variables at once, against one estimation apiece.
+        apop_data *chol_betas = apop_lm_solve(chol, ys);
+        apop_data *qr_betas = apop_lm_solve(qr, ys);
+        assert(!chol_betas->error && !qr_betas->error);
+        for (int c=0; c< ycount; c++){
+            Apop_col(ys, c, ycol);
+            Apop_col(d, 0, dep);
+            gsl_vector_memcpy(dep, ycol);
+            apop_model *one = ols_with_solver(d, 'i');
+            for (int i=0; i< 4; i++){
+                Diff(apop_data_get(one->parameters, i, -1), apop_data_get(chol_betas, i, c), 1e-9);
+                Diff(apop_data_get(one->parameters, i, -1), apop_data_get(qr_betas, i, c), 1e-9);
+            }
+            //Re-estimating from the Cholesky model reuses its factorization.
+            apop_model *again = apop_estimate(apop_data_copy(d), *chol);
+            assert(Apop_settings_get(again, apop_lm, factor));
+            for (int i=0; i< 4; i++)
+                Diff(apop_data_get(one->parameters, i, -1), apop_data_get(again->parameters, i, -1), 1e-9);
+            apop_data_free(again->data);
+            apop_model_free(again);
+            apop_data_free(one->data);
+            apop_model_free(one);
+        }
+        Apop_col(ys, 0, y0);
+        Apop_col(d, 0, dep);
+        gsl_vector_memcpy(dep, y0);
+
+        int v = apop_opts.verbose; apop_opts.verbose = -1;
+        apop_data *no_factor = apop_lm_solve(inv, ys);
+        apop_opts.verbose = v;
+        assert(no_factor->error == 'f');
+        apop_data_free(no_factor);
+        apop_data_free(chol_betas);
+        apop_data_free(qr_betas);
+        apop_data_free(inv->data); apop_data_free(chol->data); apop_data_free(qr->data);
+        apop_model_free(inv); apop_model_free(chol); apop_model_free(qr);
+    }
+    apop_data_free(d);
+    apop_data_free(ys);
+}
+
 #define do_test(text, fn) {if (verbose) printf("%s:", text); \
                           fflush(NULL);                      \
                           fn;                                \
@@ -1518,14 +2527,19 @@ int main(int argc, char **argv){
     do_test("split and stack test", test_split_and_stack(r));
     do_test("test probit and logit", test_probit_and_logit(r));
     do_test("test probit and logit again", test_probit_and_logit(r));
+    do_test("test multinomial probit and logit likelihoods", test_multichoice_ll(r));
+    do_test("apop_dot_map_sum and the OLS likelihood", test_dot_map_sum(r));
     do_test("test ML imputation", test_ml_imputation(r));
     do_test("NaN handling", test_nan_data());
     do_test("test data compressing", test_pmf_compress(r));
     do_test("weighted regression", test_weighted_regression(d,e));
     do_test("offset OLS", test_ols_offset(r));
+    do_test("streamed OLS", test_ols_stream(r));
+    do_test("OLS solvers and apop_lm_solve", test_ols_solvers(r));
     do_test("default RNG", test_default_rng(r));
     do_test("test printing", test_printing());
     do_test("test row set and remove", row_manipulations());
+    do_test("test map/apply thread pool", test_map_pool());
     do_test("test PMF", test_pmf());
     do_test("apop_pack/unpack test", apop_pack_test(r));
     do_test("test adaptive rejection sampling", test_arms(r));
@@ -1538,18 +2552,30 @@ int main(int argc, char **argv){
     do_test("dummies and factors", dummies_and_factors());
     do_test("test vector/matrix realloc", test_resize());
     do_test("test_vector_moving_average", test_vector_moving_average());
+    do_test("moving window stats", test_moving_stats(r));
     do_test("apop_estimate->dependent test", test_predicted_and_residual(e));
     do_test("apop_f_test and apop_coefficient_of_determination test", test_f(e));
     do_test("OLS test", test_OLS(r));
     do_test("test lognormal estimations", test_lognormal(r));
     do_test("test queries returning empty tables", test_blank_db_queries());
+    do_test("test typed queries", test_typed_queries());
+    do_test("test threaded text reading", test_threaded_text_read());
+    do_test("blocked covariance and correlation", test_blocked_covariance(r));
     do_test("test jackknife covariance", test_jack(r));
+    do_test("test random-walk MCMC", test_random_walk_update(r));
+    do_test("test threaded Hessian", test_threaded_hessian());
+    do_test("test multistart MLE", test_multistart());
+    do_test("test fast kernel density", test_fast_kernel(r));
+    do_test("test batched log likelihoods", test_batched_log_likelihoods(r));
+    do_test("test cached MVN factorization", test_mvn_cache());
     do_test("database skew, kurtosis, normalization", test_skew_and_kurt(r));
     do_test("test_percentiles", test_percentiles());
     do_test("weighted moments", test_weigted_moments());
     do_test("multivariate gamma", test_mvn_gamma());
     do_test("Inversion", test_inversion(r));
     do_test("apop_matrix_summarize", test_summarize());
+    do_test("apop_data_summarize via selection", test_summarize_selection(r));
+    do_test("quantile sketches", test_quantile_sketch(r));
     do_test("apop_linear_constraint", test_linear_constraint());
     do_test("transposition", test_transpose());
     do_test("test unique elements", test_unique_elements());
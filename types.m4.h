@@ -122,7 +122,7 @@ typedef struct{
     char db_pass[101]; /**< Password for database login. Max 100 chars.  */
     FILE *log_file;  /**< The file handle for the log. Defaults to \c stderr, but change it with, e.g.,
                            <tt>apop_opts.log_file = fopen("outlog", "w");</tt> */
-    int  thread_count; /**< Threads to use internally. See \ref apop_map and family.  */
+    int  thread_count; /**< Threads to use internally. See \ref apop_map and family, and \ref apop_text_to_data.  */
     int  rng_seed;
     float version;
 } apop_opts_type;
@@ -312,6 +312,8 @@ apop_model * apop_estimate(apop_data *d, apop_model m);
 void apop_score(apop_data *d, gsl_vector *out, apop_model *m);
 double apop_log_likelihood(apop_data *d, apop_model *m);
 double apop_p(apop_data *d, apop_model *m);
+gsl_vector *apop_log_likelihoods(apop_data *d, apop_model *m, gsl_matrix const *params);
+gsl_vector *apop_ps(apop_data *d, apop_model *m, gsl_matrix const *params);
 double apop_cdf(apop_data *d, apop_model *m);
 void apop_draw(double *out, gsl_rng *r, apop_model *m);
 void apop_prep(apop_data *d, apop_model *m);
@@ -319,6 +321,7 @@ apop_model *apop_parameter_model(apop_data *d, apop_model *m);
 apop_data * apop_predict(apop_data *d, apop_model *m);
 
 apop_model *apop_beta_from_mean_var(double m, double v); //in apop_beta.c
+apop_data *apop_lm_solve(apop_model *est, apop_data *y); //in apop_ols.c
 
 #define apop_model_set_parameters(in, ...) apop_model_set_parameters_base((in), (double []) {__VA_ARGS__})
 apop_model *apop_model_set_parameters_base(apop_model in, double ap[]);
@@ -362,6 +365,9 @@ double apop_vector_map_sum(const gsl_vector *in, double(*fn)(double));
 double apop_matrix_map_sum(const gsl_matrix *in, double (*fn)(gsl_vector*));
 double apop_matrix_map_all_sum(const gsl_matrix *in, double (*fn)(double));
 
+typedef double apop_fn_xb(double const *xb, size_t row, void *param, double *acc);
+double apop_dot_map_sum(gsl_matrix const *x, gsl_matrix const *beta, apop_fn_xb *fn, void *param, gsl_vector *acc);
+
 
         // Some output routines
 
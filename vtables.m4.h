@@ -8,5 +8,13 @@ typedef apop_model *(*apop_update_type)(apop_data *, apop_model , apop_model);
 #define apop_update_hash(m1, m2) ((size_t)(m1).draw + (size_t)((m2).log_likelihood ? (m2).log_likelihood : (m2).p)*33)
 make_vtab_fns(apop_update)
 
+typedef void (*apop_model_draws_type)(apop_data *, gsl_rng *, apop_model *);
+#define apop_model_draws_hash(m1) ((size_t)(m1).draw)
+make_vtab_fns(apop_model_draws)
+
+typedef void (*apop_log_likelihoods_type)(apop_data *, apop_model *, gsl_matrix const *, gsl_vector *);
+#define apop_log_likelihoods_hash(m1) ((size_t)(m1).log_likelihood)
+make_vtab_fns(apop_log_likelihoods)
+
 int apop_vtable_insert(char *tabname, void *fn_in, unsigned long hash);
 void *apop_vtable_get(char *tabname, unsigned long hash);